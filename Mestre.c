@@ -1,473 +1,4101 @@
 // TEMA 4 - MESTRE
 
-#include <stdio.h>      // printf, fgets, fprintf — entrada/saída padrão.
+#define _GNU_SOURCE     // accept4 — conexões do servidor já aceitas como não bloqueantes.
+#include <stdio.h>      // printf, fprintf — saída padrão (a entrada passa por lerLinha/get_choice).
 #include <stdlib.h>     // malloc, free, exit — alocação e encerramento.
 #include <string.h>     // strlen, memcpy, strcmp — manipulação de strings.
 #include <ctype.h>      // isspace — classificação de caracteres (espaços, tabs, newlines).
+#include <stdint.h>     // uint64_t — palavras dos conjuntos de pistas em bitset.
+#include <time.h>       // clock_gettime — relógio monotônico para medições de tempo.
+#include <fcntl.h>      // open — arquivos do diário de eventos.
+#include <unistd.h>     // read, write, pread, close — entrada em blocos e gravação do diário.
+#include <errno.h>      // errno, EINTR — leitura de stdin interrompida por sinal.
+#include <sys/mman.h>   // mmap — leitura do diário na reprodução.
+#include <sys/stat.h>   // fstat — tamanho dos arquivos do diário.
+#include <pthread.h>    // pthread_create, pthread_join — simulação de jogadores e montagem do mapa em paralelo.
+#include <sys/resource.h> // setpriority, setrlimit — recarga com prioridade mínima e limite de descritores do servidor.
+#include <sys/syscall.h> // SYS_gettid — identificador da thread para o setpriority.
+#include <stdarg.h>     // va_list — respostas formatadas do servidor.
+#include <signal.h>     // sigaction — encerramento do servidor com Ctrl+C.
+#include <sys/epoll.h>  // epoll — laço de eventos do servidor de jogo.
+#include <sys/eventfd.h> // eventfd — aviso de mundo recarregado para o laço do servidor.
+#include <sys/socket.h> // socket, accept4 — conexões do servidor e do gerador de carga.
+#include <sys/uio.h>    // writev — respostas montadas em pedaços.
+#include <sys/un.h>     // sockaddr_un — servidor em socket Unix.
+#include <netinet/in.h> // sockaddr_in — servidor em TCP local.
+#include <netinet/tcp.h> // TCP_NODELAY — respostas curtas sem espera do Nagle.
+#include <arpa/inet.h>  // htons, htonl — endereço e porta TCP.
+#ifdef __AVX2__
+#include <immintrin.h>  // intrínsecos AVX2 — popcount vetorizado dos conjuntos de pistas.
+#endif
+#include "motor.h" // mapa, pistas, tabela hash, entrada e instrumentação (base comum dos três níveis).
 
-/* ---------- Estruturas ---------- */
+/* ---------- Registro de suspeitos (nomes normalizados e sugestões) ---------- */
 
-/* Estrutura que representa uma sala (nó da árvore binária) */
-typedef struct Sala {          // início da definição do tipo 'struct Sala'
-    char *nome;               // ponteiro para string que guarda o nome da sala (alocado dinamicamente)
-    char *pista;              // ponteiro para string com a pista opcional (NULL se não houver)
-    struct Sala *esq;         // ponteiro para o filho à esquerda (subárvore esquerda)
-    struct Sala *dir;         // ponteiro para o filho à direita (subárvore direita)
-    struct Sala *pai;         // ponteiro para o nó pai (NULL se for a raiz)
-} Sala;                       // typedef para simplificar o uso do tipo como 'Sala'
+/*
+ * RegistroSuspeitos - resolve o nome digitado na acusação para o ID do
+ * suspeito sem exigir a grafia exata. Cada nome é guardado também na forma
+ * normalizada (ver normalizarNome: minúsculas, sem acentos, pontuação vira
+ * espaço), e um hash aberto no mesmo esquema do índice de salas leva da
+ * chave normalizada ao ID: "dr silva", "Dr. Silva" e "DR SILVA" dão no
+ * mesmo suspeito com uma busca. Nomes cuja chave coincide formam uma lista
+ * em 'mesmaChave'; a grafia exata desempata, senão vale o menor ID.
+ * Para nomes que não existem, regSugerir procura os mais parecidos em dois
+ * níveis. O primeiro é a vizinhança de deleção: um segundo hash aberto
+ * guarda cada chave e cada versão dela sem um caractere, de modo que um erro
+ * de digitação se resolve com uma busca por caractere da consulta, sem
+ * depender do tamanho do catálogo. Se nada estiver tão perto, o segundo
+ * nível usa trigramas: cada trigrama da chave (com um espaço de cada lado)
+ * tem a sua lista de IDs em ordem crescente, e os candidatos com pelo menos
+ * metade dos trigramas da consulta são ordenados pela distância de edição.
+ * Em catálogos de nomes (poucas palavras muito repetidas) as listas são
+ * longas; o trabalho por consulta é limitado (ver reg_porTrigramas), e os
+ * contadores ficam no registro e são zerados só onde a consulta mexeu,
+ * porque a consulta roda no laço de eventos do servidor.
+ */
+#define REG_CHAVE_MAX     128          // bytes da chave normalizada (com o '\0'); nomes maiores são cortados
+#define REG_FINALISTAS    32           // candidatos que passam para a distância de edição
+#define REG_DISTANCIA_MAX 2            // maior distância de edição aceita no primeiro nível
+#define REG_CANDIDATOS    4096         // candidatos de uma consulta de trigramas
+#define REG_POSTAGENS_MAX 32768        // IDs lidos por consulta no total (listas longas completam só até aqui)
+
+/* ListaTrigrama - posição do índice de trigramas: IDs em postagens[inicio .. inicio+tam) */
+typedef struct ListaTrigrama {
+    uint32_t trigrama;                 // 3 bytes da chave (0 = posição livre)
+    uint32_t inicio;
+    uint32_t tam;
+} ListaTrigrama;
+
+typedef struct RegistroSuspeitos {
+    size_t n;                          // suspeitos registrados
+    const char *const *nomes;          // nome original de cada ID (do chamador)
+    char *chaves;                      // chaves normalizadas, cada uma terminada em '\0'
+    uint32_t *inicioChave;             // [n] início da chave de cada ID em 'chaves'
+    uint8_t *tamChave;                 // [n] comprimento da chave
+    uint8_t *nTrigramas;               // [n] trigramas distintos da chave
+    uint64_t *indice;                  // [cap] (32 bits altos do hash << 32) | (ID + 1); 0 = livre
+    size_t cap;                        // posições do índice (potência de 2)
+    uint32_t *mesmaChave;              // [n] próximo ID com a mesma chave, UINT32_MAX no fim
+    uint64_t *delecoes;                // [capDelecoes] chaves e chaves sem um caractere, no formato de 'indice'
+    size_t capDelecoes;                // posições do índice de deleções (potência de 2)
+    ListaTrigrama *listas;             // [capListas] trigrama -> IDs
+    size_t capListas;                  // posições do índice de trigramas (potência de 2)
+    size_t nListas;                    // trigramas distintos
+    uint32_t *postagens;               // IDs de todas as listas, lista após lista
+    struct RascunhoTrigramas *rascunho; // contadores de reg_porTrigramas (uma consulta por vez)
+} RegistroSuspeitos;
+
+/*
+ * RascunhoTrigramas - contadores reaproveitados entre consultas de
+ * trigramas: em vez de alocar e zerar n contadores a cada consulta, ela
+ * devolve a zero só os dos seus candidatos (a lista 'cand' é exatamente o
+ * que foi tocado). Uma consulta por vez.
+ */
+typedef struct RascunhoTrigramas {
+    uint8_t *comum;                    // [n] trigramas em comum com a consulta atual (0 = não é candidato)
+    uint32_t cand[REG_CANDIDATOS];     // candidatos da consulta atual
+} RascunhoTrigramas;
+
+/* letra sem acento de cada caractere de U+00C0 a U+00FF ('×' e '÷' viram espaço) */
+static const char REG_LATIN1[65] = "aaaaaaaceeeeiiiidnooooo ouuuuytsaaaaaaaceeeeiiiidnooooo ouuuuyty";
+
+/*
+ * normalizarNome - chave de comparação de um nome em UTF-8: letras e
+ * dígitos ASCII em minúsculas, letras acentuadas do Latin-1 sem o acento,
+ * apóstrofos removidos ("D'Ávila" -> "davila") e qualquer outra pontuação
+ * ou espaço como um único espaço entre palavras, sem espaços nas pontas.
+ * Outros caracteres não ASCII passam sem mudança. Escreve no máximo
+ * cap - 1 bytes em 'out' e retorna o comprimento.
+ */
+size_t normalizarNome(const char *s, char *out, size_t cap) {
+    size_t n = 0;
+    int separar = 0;                   // espaço pendente: só entra antes da próxima letra
+    for (const unsigned char *p = (const unsigned char *)s; *p; ++p) {
+        unsigned char c = *p;
+        if (c < 0x80) {
+            if (c == '\'' || c == '`') continue;
+            if (c >= 'A' && c <= 'Z') c = (unsigned char)(c + ('a' - 'A'));
+            else if (!(c >= 'a' && c <= 'z') && !(c >= '0' && c <= '9')) c = ' ';
+        } else if (c == 0xC3 && (p[1] & 0xC0) == 0x80) {
+            c = (unsigned char)REG_LATIN1[*++p & 0x3F];
+        } else if (c == 0xC2 && (p[1] & 0xC0) == 0x80) {
+            ++p;                       // U+0080..U+00BF: aspas angulares, ordinais, símbolos
+            c = ' ';
+        } else if (c == 0xE2 && p[1] == 0x80 && (p[2] & 0xC0) == 0x80) {
+            p += 2;                    // U+2000..U+203F: aspas e travessões tipográficos
+            if (*p == 0x98 || *p == 0x99) continue; // apóstrofo tipográfico
+            c = ' ';
+        }
+        if (c == ' ') { separar = n > 0; continue; }
+        if (n + 1 + (size_t)separar >= cap) break;
+        if (separar) { out[n++] = ' '; separar = 0; }
+        out[n++] = (char)c;
+    }
+    if (cap) out[n] = '\0';
+    return n;
+}
+
+/* reg_trigramas - trigramas distintos de ' ' + chave + ' ', em ordem crescente; retorna quantos */
+static size_t reg_trigramas(const char *chave, size_t tam, uint32_t *t) {
+    size_t n = 0;
+    for (size_t i = 0; i < tam; ++i) {
+        uint32_t v = (uint32_t)(i ? (unsigned char)chave[i - 1] : ' ') << 16
+                   | (uint32_t)(unsigned char)chave[i] << 8
+                   | (uint32_t)(i + 1 < tam ? (unsigned char)chave[i + 1] : ' ');
+        size_t j = n++;
+        while (j && t[j - 1] > v) { t[j] = t[j - 1]; --j; } // inserção: chaves curtas, poucos trigramas
+        t[j] = v;
+    }
+    size_t m = 0;
+    for (size_t i = 0; i < n; ++i)
+        if (!m || t[m - 1] != t[i]) t[m++] = t[i];
+    return m;
+}
+
+/* reg_posicao - posição do trigrama 'v' (ou a livre onde ele entraria) no índice de trigramas */
+static inline ListaTrigrama *reg_posicao(ListaTrigrama *listas, size_t cap, uint32_t v) {
+    size_t i = (size_t)((v * 0x9E3779B97F4A7C15ull) >> 32) & (cap - 1);
+    while (listas[i].trigrama && listas[i].trigrama != v) i = (i + 1) & (cap - 1);
+    return &listas[i];
+}
+
+/* reg_chave - chave normalizada do suspeito 'id' */
+static inline const char *reg_chave(const RegistroSuspeitos *r, size_t id) {
+    return r->chaves + r->inicioChave[id];
+}
+
+/* reg_semLetra - copia a chave sem o caractere 'i' (i == tam: a chave inteira); retorna o comprimento */
+static inline size_t reg_semLetra(const char *chave, size_t tam, size_t i, char *dst) {
+    memcpy(dst, chave, i);
+    if (i < tam) memcpy(dst + i, chave + i + 1, tam - i - 1);
+    return i < tam ? tam - 1 : tam;
+}
+
+/* reg_sem_memoria - aborta a montagem do registro */
+static void reg_sem_memoria(void) {
+    fprintf(stderr, "Erro: memória insuficiente ao criar o registro de suspeitos.\n");
+    exit(EXIT_FAILURE);
+}
+
+/*
+ * regCriar - registra os 'n' nomes (o vetor continua do chamador e precisa
+ * viver tanto quanto o registro): normaliza as chaves, monta o índice de
+ * chaves e as listas de trigramas (contagem, somas de prefixo e
+ * preenchimento em ordem de ID, sem ordenar as postagens).
+ */
+RegistroSuspeitos *regCriar(const char *const *nomes, size_t n) {
+    RegistroSuspeitos *r = calloc(1, sizeof(RegistroSuspeitos));
+    size_t m = n ? n : 1;
+    if (!r) reg_sem_memoria();
+    r->n = n;
+    r->nomes = nomes;
+    r->inicioChave = malloc(m * sizeof(uint32_t));
+    r->tamChave = malloc(m);
+    r->nTrigramas = malloc(m);
+    r->mesmaChave = malloc(m * sizeof(uint32_t));
+    r->rascunho = calloc(1, sizeof(RascunhoTrigramas));
+    if (r->rascunho) r->rascunho->comum = calloc(m, 1);
+    if (!r->rascunho || !r->rascunho->comum) reg_sem_memoria();
+    size_t capChaves = 16, usados = 0;
+    for (size_t id = 0; id < n; ++id) capChaves += strlen(nomes[id]) + 1; // a chave nunca é maior que o nome
+    r->chaves = malloc(capChaves);
+    if (!r->inicioChave || !r->tamChave || !r->nTrigramas || !r->mesmaChave || !r->chaves) reg_sem_memoria();
+
+    uint32_t tri[REG_CHAVE_MAX];
+    size_t totalTri = 0;
+    r->capListas = 1024;
+    r->listas = calloc(r->capListas, sizeof(ListaTrigrama));
+    if (!r->listas) reg_sem_memoria();
+    for (size_t id = 0; id < n; ++id) { // chaves e contagem de cada trigrama
+        size_t tam = normalizarNome(nomes[id], r->chaves + usados, REG_CHAVE_MAX);
+        r->inicioChave[id] = (uint32_t)usados;
+        r->tamChave[id] = (uint8_t)tam;
+        usados += tam + 1;
+        size_t nt = reg_trigramas(reg_chave(r, id), tam, tri);
+        r->nTrigramas[id] = (uint8_t)nt;
+        totalTri += nt;
+        for (size_t k = 0; k < nt; ++k) {
+            ListaTrigrama *l = reg_posicao(r->listas, r->capListas, tri[k]);
+            if (!l->trigrama) {
+                if ((r->nListas + 1) * 4 > r->capListas * 3) { // ocupação > 75%: dobra e reinsere
+                    ListaTrigrama *antigas = r->listas;
+                    size_t capAntiga = r->capListas;
+                    r->capListas *= 2;
+                    r->listas = calloc(r->capListas, sizeof(ListaTrigrama));
+                    if (!r->listas) reg_sem_memoria();
+                    for (size_t i = 0; i < capAntiga; ++i)
+                        if (antigas[i].trigrama) *reg_posicao(r->listas, r->capListas, antigas[i].trigrama) = antigas[i];
+                    free(antigas);
+                    l = reg_posicao(r->listas, r->capListas, tri[k]);
+                }
+                l->trigrama = tri[k];
+                r->nListas++;
+            }
+            l->tam++;
+        }
+    }
+    uint32_t acumulado = 0;            // cada lista começa onde a anterior termina; 'tam' volta a ser o cursor
+    for (size_t i = 0; i < r->capListas; ++i) {
+        r->listas[i].inicio = acumulado;
+        acumulado += r->listas[i].tam;
+        r->listas[i].tam = 0;
+    }
+    r->postagens = malloc((totalTri ? totalTri : 1) * sizeof(uint32_t));
+    if (!r->postagens) reg_sem_memoria();
+    for (size_t id = 0; id < n; ++id) { // IDs em ordem crescente: as listas já saem ordenadas
+        size_t nt = reg_trigramas(reg_chave(r, id), r->tamChave[id], tri);
+        for (size_t k = 0; k < nt; ++k) {
+            ListaTrigrama *l = reg_posicao(r->listas, r->capListas, tri[k]);
+            r->postagens[l->inicio + l->tam++] = (uint32_t)id;
+        }
+    }
+
+    r->cap = 16;
+    while (r->cap * 3 < n * 4) r->cap *= 2; // ocupação <= 75%
+    r->indice = calloc(r->cap, sizeof(uint64_t));
+    if (!r->indice) reg_sem_memoria();
+    for (size_t id = n; id-- > 0; ) {  // de trás para a frente: cada lista de mesma chave fica em ordem de ID
+        const char *chave = reg_chave(r, id);
+        uint64_t h = hash_filtro(chave, r->tamChave[id]);
+        size_t i = (size_t)h & (r->cap - 1);
+        r->mesmaChave[id] = UINT32_MAX;
+        for (; r->indice[i]; i = (i + 1) & (r->cap - 1)) {
+            uint32_t outro = (uint32_t)r->indice[i] - 1;
+            if ((r->indice[i] >> 32) == (h >> 32) && strcmp(reg_chave(r, outro), chave) == 0) {
+                r->mesmaChave[id] = outro;
+                break;
+            }
+        }
+        r->indice[i] = (h >> 32 << 32) | (uint64_t)(id + 1);
+    }
+
+    size_t variantes = 0;              // índice de deleções: a chave e cada versão sem um caractere
+    for (size_t id = 0; id < n; ++id) {
+        const char *chave = reg_chave(r, id);
+        variantes += 1;
+        for (size_t i = 0; i < r->tamChave[id]; ++i) variantes += !i || chave[i] != chave[i - 1];
+    }
+    r->capDelecoes = 16;
+    while (r->capDelecoes * 3 < variantes * 4) r->capDelecoes *= 2;
+    r->delecoes = calloc(r->capDelecoes, sizeof(uint64_t));
+    if (!r->delecoes) reg_sem_memoria();
+    char variante[REG_CHAVE_MAX];
+    for (size_t id = 0; id < n; ++id) {
+        const char *chave = reg_chave(r, id);
+        size_t tam = r->tamChave[id];
+        for (size_t i = 0; i <= tam; ++i) {
+            if (i && i < tam && chave[i] == chave[i - 1]) continue;
+            size_t nv = reg_semLetra(chave, tam, i, variante);
+            uint64_t h = hash_filtro(variante, nv);
+            size_t p = (size_t)h & (r->capDelecoes - 1);
+            while (r->delecoes[p]) p = (p + 1) & (r->capDelecoes - 1); // repetições ficam lado a lado na sondagem
+            r->delecoes[p] = (h >> 32 << 32) | (uint64_t)(id + 1);
+        }
+    }
+    return r;
+}
+
+/* liberarRegistro - libera o registro (os nomes originais são do chamador) */
+void liberarRegistro(RegistroSuspeitos *r) {
+    if (!r) return;
+    free(r->chaves);
+    free(r->inicioChave);
+    free(r->tamChave);
+    free(r->nTrigramas);
+    free(r->indice);
+    free(r->mesmaChave);
+    free(r->delecoes);
+    free(r->listas);
+    free(r->postagens);
+    free(r->rascunho->comum);
+    free(r->rascunho);
+    free(r);
+}
+
+/* regBytes - memória ocupada pelo registro (sem os nomes originais) */
+size_t regBytes(const RegistroSuspeitos *r) {
+    size_t chaves = r->n ? r->inicioChave[r->n - 1] + r->tamChave[r->n - 1] + 1u : 0;
+    size_t postagens = 0;
+    for (size_t i = 0; i < r->capListas; ++i) postagens += r->listas[i].tam;
+    return sizeof(*r) + chaves + r->n * (2 * sizeof(uint32_t) + 3) + (r->cap + r->capDelecoes) * sizeof(uint64_t)
+         + sizeof(RascunhoTrigramas)
+         + r->capListas * sizeof(ListaTrigrama) + postagens * sizeof(uint32_t);
+}
+
+/*
+ * regBuscar - ID do suspeito cujo nome normalizado é igual ao de 'nome', ou
+ * -1. Se vários suspeitos têm essa chave, vale o de grafia exata e, sem ele,
+ * o de menor ID.
+ */
+long regBuscar(const RegistroSuspeitos *r, const char *nome) {
+    char chave[REG_CHAVE_MAX];
+    size_t tam = normalizarNome(nome, chave, sizeof(chave));
+    uint64_t h = hash_filtro(chave, tam);
+    for (size_t i = (size_t)h & (r->cap - 1); r->indice[i]; i = (i + 1) & (r->cap - 1)) {
+        uint32_t id = (uint32_t)r->indice[i] - 1;
+        if ((r->indice[i] >> 32) != (h >> 32) || strcmp(reg_chave(r, id), chave) != 0) continue;
+        for (uint32_t k = id; k != UINT32_MAX; k = r->mesmaChave[k])
+            if (strcmp(r->nomes[k], nome) == 0) return (long)k;
+        return (long)id;
+    }
+    return -1;
+}
+
+/* reg_distancia - distância de edição (Levenshtein) entre duas chaves */
+static unsigned reg_distancia(const char *a, size_t na, const char *b, size_t nb) {
+    unsigned linha[REG_CHAVE_MAX];
+    for (size_t j = 0; j <= nb; ++j) linha[j] = (unsigned)j;
+    for (size_t i = 1; i <= na; ++i) {
+        unsigned diagonal = linha[0];
+        linha[0] = (unsigned)i;
+        for (size_t j = 1; j <= nb; ++j) {
+            unsigned acima = linha[j];
+            unsigned v = diagonal + (a[i - 1] != b[j - 1]);
+            if (acima + 1 < v) v = acima + 1;
+            if (linha[j - 1] + 1 < v) v = linha[j - 1] + 1;
+            linha[j] = v;
+            diagonal = acima;
+        }
+    }
+    return linha[nb];
+}
+
+/*
+ * Finalista - candidato a sugestão: distância de edição até a consulta e,
+ * no segundo nível, trigramas em comum e na união (Jaccard = comum / uniao;
+ * zerados quando o candidato vem da vizinhança de deleção).
+ */
+typedef struct Finalista {
+    uint32_t id, comum, uniao, distancia;
+} Finalista;
+
+/* reg_antes - 'a' é sugerido antes de 'b': menor distância, maior Jaccard, menor ID */
+static inline int reg_antes(const Finalista *a, const Finalista *b) {
+    if (a->distancia != b->distancia) return a->distancia < b->distancia;
+    uint64_t x = (uint64_t)a->comum * b->uniao, y = (uint64_t)b->comum * a->uniao;
+    return x != y ? x > y : a->id < b->id;
+}
+
+/*
+ * reg_vizinhos - primeiro nível das sugestões: a consulta e cada uma das
+ * suas versões sem um caractere são procuradas no índice de deleções (as
+ * chaves e as suas versões sem um caractere). Acha toda chave a uma
+ * troca, falta, sobra ou inversão de distância com tam + 1 buscas; os
+ * candidatos ficam se a distância de edição for no máximo REG_DISTANCIA_MAX.
+ */
+static size_t reg_vizinhos(const RegistroSuspeitos *r, const char *chave, size_t tam, Finalista *fin) {
+    char variante[REG_CHAVE_MAX];
+    size_t nf = 0, mascara = r->capDelecoes - 1;
+    for (size_t i = 0; i <= tam; ++i) {
+        if (i && i < tam && chave[i] == chave[i - 1]) continue; // tirar qualquer letra de uma repetição dá o mesmo texto
+        size_t nv = reg_semLetra(chave, tam, i, variante);
+        uint64_t h = hash_filtro(variante, nv);
+        for (size_t p = (size_t)h & mascara; r->delecoes[p]; p = (p + 1) & mascara) {
+            if ((r->delecoes[p] >> 32) != (h >> 32)) continue;
+            Finalista f = { (uint32_t)r->delecoes[p] - 1, 0, 0, 0 };
+            size_t j = 0;
+            while (j < nf && fin[j].id != f.id) ++j;
+            if (j < nf) continue;      // já é candidato
+            f.distancia = reg_distancia(chave, tam, reg_chave(r, f.id), r->tamChave[f.id]);
+            if (f.distancia > REG_DISTANCIA_MAX) continue;
+            if (nf == REG_FINALISTAS) {
+                if (!reg_antes(&f, &fin[nf - 1])) continue;
+                --nf;
+            }
+            for (j = nf++; j && reg_antes(&f, &fin[j - 1]); --j) fin[j] = fin[j - 1];
+            fin[j] = f;
+        }
+    }
+    return nf;
+}
+
+/* ListaConsulta - lista de IDs de um trigrama da consulta */
+typedef struct ListaConsulta {
+    const uint32_t *ids;
+    uint32_t tam;
+} ListaConsulta;
+
+/* reg_contem - a lista (IDs em ordem crescente) contém 'id'? */
+static inline int reg_contem(const uint32_t *ids, uint32_t tam, uint32_t id) {
+    uint32_t ini = 0, fim = tam;
+    while (ini < fim) {
+        uint32_t meio = ini + (fim - ini) / 2;
+        if (ids[meio] < id) ini = meio + 1; else fim = meio;
+    }
+    return ini < tam && ids[ini] == id;
+}
+
+/*
+ * reg_porTrigramas - segundo nível das sugestões: candidatos com pelo menos
+ * metade dos trigramas da consulta, os REG_FINALISTAS de maior Jaccard
+ * ordenados pela distância de edição. Quem tem 'minimo' trigramas em comum
+ * aparece em pelo menos uma das nq - minimo + 1 listas mais curtas: só elas
+ * criam candidatos; as mais longas só completam a contagem de quem já é
+ * candidato. O trabalho é limitado: as listas curtas criam no máximo
+ * REG_CANDIDATOS candidatos, da mais curta para a mais longa (um nome que
+ * contém a consulta inteira está em todas, inclusive na primeira), e cada
+ * lista longa é percorrida ou, se for mais barato, consultada por busca
+ * binária para cada candidato, até REG_POSTAGENS_MAX IDs lidos no total
+ * (curtas inclusive). As listas que não couberem mais, ou só em parte, não
+ * contam para ninguém, o mínimo exigido desce junto e os finalistas têm os
+ * trigramas em comum recontados pela própria chave.
+ */
+static size_t reg_porTrigramas(const RegistroSuspeitos *r, const char *chave, size_t tam, Finalista *fin) {
+    uint32_t tri[REG_CHAVE_MAX];
+    ListaConsulta listas[REG_CHAVE_MAX];
+    size_t nq = reg_trigramas(chave, tam, tri);
+    if (!nq) return 0;
+    for (size_t k = 0; k < nq; ++k) {  // listas da consulta, da mais curta para a mais longa
+        const ListaTrigrama *l = reg_posicao(r->listas, r->capListas, tri[k]);
+        ListaConsulta c = { r->postagens + l->inicio, l->trigrama ? l->tam : 0 };
+        size_t j = k;
+        while (j && listas[j - 1].tam > c.tam) { listas[j] = listas[j - 1]; --j; }
+        listas[j] = c;
+    }
+    uint32_t minimo = nq <= 2 ? 1 : (uint32_t)(nq + 1) / 2; // trigramas em comum exigidos
+    size_t curtas = nq - minimo + 1, nCand = 0, lidos = 0;
+    RascunhoTrigramas *t = r->rascunho;
+    uint8_t *comum = t->comum;
+    uint32_t semContar = 0;            // listas que ficaram fora do limite (ou só em parte)
+    size_t k = 0;
+    for (; k < curtas && nCand < REG_CANDIDATOS; ++k) { // a lista em que as vagas acabam ainda soma inteira
+        uint32_t n = listas[k].tam;
+        if (n > REG_POSTAGENS_MAX - lidos) { n = (uint32_t)(REG_POSTAGENS_MAX - lidos); semContar++; }
+        for (uint32_t i = 0; i < n; ++i) {
+            uint32_t id = listas[k].ids[i];
+            if (comum[id]) comum[id]++;
+            else if (nCand < REG_CANDIDATOS) { comum[id] = 1; t->cand[nCand++] = id; }
+        }
+        lidos += n;
+    }
+    if (!nCand) return 0;
+    for (; k < nq; ++k) {              // sem vagas: as listas restantes só completam a contagem
+        uint32_t n = listas[k].tam;
+        size_t passos = 1;             // custo de uma busca binária
+        while ((1u << passos) < n) ++passos;
+        passos *= nCand;
+        if ((n < passos ? n : passos) > REG_POSTAGENS_MAX - lidos) { semContar++; continue; }
+        if (n < passos) {              // percorre a lista
+            for (uint32_t i = 0; i < n; ++i) {
+                uint32_t id = listas[k].ids[i];
+                comum[id] += comum[id] != 0;
+            }
+            lidos += n;
+        } else {                       // lista muito maior que os candidatos: busca binária
+            for (size_t c = 0; c < nCand; ++c)
+                comum[t->cand[c]] += (uint8_t)reg_contem(listas[k].ids, n, t->cand[c]);
+            lidos += passos;
+        }
+    }
+    minimo = minimo > semContar ? minimo - semContar : 1;
+
+    size_t nf = 0;
+    for (size_t c = 0; c < nCand; ++c) {
+        uint32_t id = t->cand[c], emComum = comum[id];
+        comum[id] = 0;                 // pronto para a próxima consulta
+        if (emComum < minimo) continue;
+        Finalista f = { id, emComum, (uint32_t)nq + r->nTrigramas[id] - emComum, 0 }; // distância ainda não conta
+        if (nf == REG_FINALISTAS) {    // cheio: só entra se for mais parecido que o último
+            if (!reg_antes(&f, &fin[nf - 1])) continue;
+            --nf;
+        }
+        size_t j = nf++;
+        for (; j && reg_antes(&f, &fin[j - 1]); --j) fin[j] = fin[j - 1];
+        fin[j] = f;
+    }
+    uint32_t triCand[REG_CHAVE_MAX];
+    for (size_t i = 0; i < nf; ++i) {  // reordena pela distância de edição
+        Finalista f = fin[i];
+        f.distancia = reg_distancia(chave, tam, reg_chave(r, f.id), r->tamChave[f.id]);
+        if (semContar) {               // contagem incompleta: refaz a dos finalistas pelos trigramas da chave
+            size_t nc = reg_trigramas(reg_chave(r, f.id), r->tamChave[f.id], triCand), a = 0, b = 0;
+            f.comum = 0;
+            while (a < nq && b < nc) { // as duas listas de trigramas estão em ordem crescente
+                if (tri[a] < triCand[b]) ++a;
+                else if (tri[a] > triCand[b]) ++b;
+                else { f.comum++; ++a; ++b; }
+            }
+            f.uniao = (uint32_t)(nq + nc) - f.comum;
+        }
+        size_t j = i;
+        for (; j && reg_antes(&f, &fin[j - 1]); --j) fin[j] = fin[j - 1];
+        fin[j] = f;
+    }
+    return nf;
+}
+
+/*
+ * regSugerir - até 'max' IDs de suspeitos com nome parecido com 'nome', do
+ * mais parecido ao menos (ver reg_antes). Primeiro a vizinhança de deleção
+ * (erros de digitação); se ela não acha nada, os trigramas (nome
+ * incompleto, vários erros). Retorna quantos IDs foram escritos em 'ids'.
+ */
+size_t regSugerir(const RegistroSuspeitos *r, const char *nome, uint32_t *ids, size_t max) {
+    char chave[REG_CHAVE_MAX];
+    Finalista fin[REG_FINALISTAS];
+    size_t tam = normalizarNome(nome, chave, sizeof(chave));
+    if (!tam) return 0;
+    size_t nf = reg_vizinhos(r, chave, tam, fin);
+    if (!nf) nf = reg_porTrigramas(r, chave, tam, fin);
+    if (nf > max) nf = max;
+    for (size_t i = 0; i < nf; ++i) ids[i] = fin[i].id;
+    return nf;
+}
+
+/* ---------- Catálogo de pistas e conjunto de pistas em bitset ---------- */
+
+/*
+ * Catalogo - numera cada sala do mapa (ID 0..nSalas-1), cada pista distinta
+ * (ID 0..nPistas-1, em ordem alfabética: o ID é o posto da pista) e cada
+ * suspeito distinto da tabela hash (ID 0..nSuspeitos-1). Para cada suspeito
+ * guarda uma máscara de bits com as pistas que apontam para ele, de modo que
+ * a contagem de evidências de uma sessão vira AND + popcount.
+ * Também indexa as salas pelo nome (buscarSalaId): hash aberto com sondagem
+ * linear cujas posições guardam o ID da sala e 32 bits do hash do nome, de
+ * modo que só a sala certa é lida para o strcmp final. Salas com o mesmo
+ * nome ocupam uma única posição e formam uma lista em 'mesmoNome'.
+ */
+typedef struct Catalogo {
+    Sala **salas;             // sala de cada ID
+    size_t nSalas;            // quantidade de salas do mapa
+    uint64_t *nomes;          // [capNomes] (32 bits altos do hash << 32) | (ID da primeira sala + 1); 0 = livre
+    size_t capNomes;          // posições do índice de nomes (potência de 2)
+    uint32_t *mesmoNome;      // [nSalas] próxima sala com o mesmo nome (ID maior), UINT32_MAX no fim
+    const char **pistas;      // texto de cada pista pelo ID, em ordem alfabética (textos guardados nas Salas)
+    struct Eytzinger *ordem;  // busca por texto -> ID sobre 'pistas' (ver Eytzinger)
+    int *suspeitoDaPista;     // ID do suspeito de cada pista (-1 se nenhum)
+    size_t nPistas;           // quantidade de pistas distintas
+    char **suspeitos;         // nome de cada suspeito pelo ID (cópias próprias)
+    size_t nSuspeitos;        // quantidade de suspeitos distintos
+    RegistroSuspeitos *registro; // nome normalizado -> ID e sugestões sobre 'suspeitos'
+    size_t nPalavras;         // palavras de 64 bits por conjunto de pistas
+    uint64_t *mascaras;       // nSuspeitos * nPalavras bits: pistas que apontam para cada suspeito
+} Catalogo;
+
+/* ConjuntoPistas - conjunto de IDs de pistas como vetor de bits (inserção e consulta O(1)) */
+typedef struct ConjuntoPistas {
+    uint64_t *palavras;       // bit i ligado = pista de ID i presente
+    size_t nPalavras;         // tamanho do vetor em palavras de 64 bits
+} ConjuntoPistas;
+
+/* conjCriar - cria um conjunto vazio capaz de guardar IDs de 0 a nPistas-1 */
+ConjuntoPistas *conjCriar(size_t nPistas) {
+    ConjuntoPistas *c = malloc(sizeof(ConjuntoPistas));
+    size_t n = (nPistas + 63) / 64;   // palavras necessárias
+    if (n == 0) n = 1;
+    uint64_t *p = calloc(n, sizeof(uint64_t)); // todos os bits desligados
+    if (!c || !p) {
+        fprintf(stderr, "Erro: memória insuficiente ao criar conjunto de pistas.\n");
+        exit(EXIT_FAILURE);
+    }
+    c->palavras = p;
+    c->nPalavras = n;
+    return c;
+}
+
+/* conjLiberar - libera o conjunto */
+void conjLiberar(ConjuntoPistas *c) {
+    if (!c) return;
+    free(c->palavras);
+    free(c);
+}
+
+/* conjLimpar - remove todos os elementos (reaproveita a memória entre sessões) */
+void conjLimpar(ConjuntoPistas *c) {
+    memset(c->palavras, 0, c->nPalavras * sizeof(uint64_t));
+}
+
+/* conjInserir - liga o bit da pista 'id'; retorna 1 se ela ainda não estava no conjunto */
+static inline int conjInserir(ConjuntoPistas *c, size_t id) {
+    uint64_t bit = 1ull << (id & 63);  // bit dentro da palavra
+    uint64_t *w = &c->palavras[id >> 6]; // palavra que contém o bit
+    int novo = (*w & bit) == 0;
+    *w |= bit;
+    return novo;
+}
+
+/* conjContem - retorna 1 se a pista 'id' está no conjunto */
+static inline int conjContem(const ConjuntoPistas *c, size_t id) {
+    return (int)((c->palavras[id >> 6] >> (id & 63)) & 1);
+}
+
+/* conjUniao / conjIntersecao - destino = destino ∪ / ∩ outro (laços simples, vetorizados pelo compilador) */
+void conjUniao(ConjuntoPistas *destino, const ConjuntoPistas *outro) {
+    for (size_t i = 0; i < destino->nPalavras; ++i) destino->palavras[i] |= outro->palavras[i];
+}
+
+void conjIntersecao(ConjuntoPistas *destino, const ConjuntoPistas *outro) {
+    for (size_t i = 0; i < destino->nPalavras; ++i) destino->palavras[i] &= outro->palavras[i];
+}
+
+/* conjCopiar - destino passa a ser igual a origem (mesmo tamanho) */
+void conjCopiar(ConjuntoPistas *destino, const ConjuntoPistas *origem) {
+    memcpy(destino->palavras, origem->palavras, destino->nPalavras * sizeof(uint64_t));
+}
+
+/*
+ * popcountE - número de bits ligados em (a AND b) sobre n palavras.
+ * Com AVX2 (-mavx2 ou -march=native) usa a contagem por nibbles com
+ * vpshufb, 256 bits por iteração; sem AVX2 usa popcount escalar.
+ */
+static size_t popcountE(const uint64_t *a, const uint64_t *b, size_t n) {
+    size_t total = 0, i = 0;
+#ifdef __AVX2__
+    const __m256i tabela = _mm256_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4,
+                                            0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4); // bits por nibble
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    __m256i acc = _mm256_setzero_si256();            // quatro somas parciais de 64 bits
+    for (; i + 4 <= n; i += 4) {
+        __m256i v = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(a + i)),
+                                     _mm256_loadu_si256((const __m256i *)(b + i)));
+        __m256i lo = _mm256_shuffle_epi8(tabela, _mm256_and_si256(v, nibble));
+        __m256i hi = _mm256_shuffle_epi8(tabela, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256()));
+    }
+    uint64_t parc[4];
+    _mm256_storeu_si256((__m256i *)parc, acc);
+    total = (size_t)(parc[0] + parc[1] + parc[2] + parc[3]);
+#endif
+    for (; i < n; ++i) total += (size_t)__builtin_popcountll(a[i] & b[i]); // resto (ou tudo, sem AVX2)
+    return total;
+}
+
+/* conjContar - quantidade de pistas no conjunto */
+size_t conjContar(const ConjuntoPistas *c) {
+    size_t total = 0;
+    for (size_t i = 0; i < c->nPalavras; ++i) total += (size_t)__builtin_popcountll(c->palavras[i]);
+    return total;
+}
+
+/* ---------- Catálogo ordenado em layout Eytzinger (busca sem desvios) ---------- */
+
+/*
+ * Eytzinger - catálogo somente leitura das pistas em ordem alfabética. As
+ * posições seguem a ordem de uma busca em largura da árvore de busca
+ * implícita (raiz em 1, filhos de k em 2k e 2k+1), então os níveis de cima
+ * ficam juntos na memória e a descida pode ser antecipada com prefetch.
+ *
+ * Pistas costumam começar igual ("Pegada...", "Uma ..."), então comparar os
+ * primeiros bytes pouco decide. Todo texto que chega a uma posição está entre
+ * os dois ancestrais que limitam a subárvore e, portanto, compartilha o
+ * prefixo comum a eles; cada posição guarda esse comprimento ('desloc') e os
+ * 8 bytes seguintes do seu texto em big-endian. Quase todas as comparações
+ * viram comparações de inteiros, e strcmp só roda quando esses 8 bytes empatam.
+ * 'textos' guarda as pistas por posto (rank), o que dá select em O(1) e
+ * listagem alfabética por varredura sequencial.
+ */
+typedef struct Eytzinger {
+    size_t n;                 // quantidade de pistas
+    uint64_t *prefixo;        // [n+1] 8 bytes do texto a partir de desloc[k] (posição 0 sem uso)
+    uint32_t *desloc;         // [n+1] prefixo comum garantido a todo texto que chega à posição k
+    uint32_t *posto;          // [n+1] posto (ordem alfabética) do texto em cada posição
+    const char **textos;      // [n] textos por posto (não pertencem ao catálogo)
+} Eytzinger;
+
+/* eyt_prefixo - 8 primeiros bytes de 't' como inteiro big-endian (preenchido com zeros) */
+static inline uint64_t eyt_prefixo(const char *t) {
+    uint64_t p = 0;
+    for (int i = 0; i < 8; ++i) {
+        p = (p << 8) | (unsigned char)t[i];
+        if (!t[i]) { p <<= 8 * (7 - i); break; } // terminador: completa com zeros
+    }
+    return p;
+}
+
+/* eyt_lcp - comprimento do prefixo comum de dois textos */
+static size_t eyt_lcp(const char *a, const char *b) {
+    size_t i = 0;
+    while (a[i] && a[i] == b[i]) ++i;
+    return i;
+}
+
+/* eyt_preencher - percorre a árvore implícita em ordem, distribuindo os postos 0..n-1 */
+static size_t eyt_preencher(Eytzinger *e, size_t proximo, size_t k) {
+    if (k > e->n) return proximo;
+    size_t ini = proximo;              // primeiro posto desta subárvore
+    proximo = eyt_preencher(e, proximo, 2 * k);
+    size_t meu = proximo;
+    proximo = eyt_preencher(e, proximo + 1, 2 * k + 1);
+    // a subárvore cobre os postos [ini, proximo): quem chega aqui está entre textos[ini-1] e textos[proximo]
+    size_t d = (ini > 0 && proximo < e->n) ? eyt_lcp(e->textos[ini - 1], e->textos[proximo]) : 0;
+    e->posto[k] = (uint32_t)meu;
+    e->desloc[k] = (uint32_t)d;
+    e->prefixo[k] = eyt_prefixo(e->textos[meu] + d);
+    return proximo;
+}
+
+/* eytCriar - catálogo a partir de 'ordenados' (n textos distintos em ordem de strcmp) */
+Eytzinger *eytCriar(const char **ordenados, size_t n) {
+    Eytzinger *e = malloc(sizeof(Eytzinger));
+    if (!e) { fprintf(stderr, "Erro: memória insuficiente ao criar catálogo ordenado.\n"); exit(EXIT_FAILURE); }
+    e->n = n;
+    e->prefixo = malloc((n + 1) * sizeof(uint64_t));
+    e->posto = malloc((n + 1) * sizeof(uint32_t));
+    e->desloc = malloc((n + 1) * sizeof(uint32_t));
+    e->textos = ordenados;
+    if (!e->prefixo || !e->posto || !e->desloc) { fprintf(stderr, "Erro: memória insuficiente ao criar catálogo ordenado.\n"); exit(EXIT_FAILURE); }
+    eyt_preencher(e, 0, 1);
+    return e;
+}
+
+/* liberarEytzinger - libera o catálogo (os textos pertencem a quem o criou) */
+void liberarEytzinger(Eytzinger *e) {
+    if (!e) return;
+    free(e->prefixo);
+    free(e->posto);
+    free(e->desloc);
+    free(e);
+}
+
+/*
+ * eytPosto - rank: quantidade de pistas menores que 'texto' (posição em que
+ * ele estaria na ordem alfabética). A descida não tem desvio por nível:
+ * k = 2k + (chave[k] < alvo), e o fim sobe pelos bits de "direita".
+ */
+size_t eytPosto(const Eytzinger *e, const char *texto) {
+    size_t k = 1;
+    while (k <= e->n) {
+        if (8 * k <= e->n)             // sem isso, nos três últimos níveis o endereço passaria do fim do vetor
+            __builtin_prefetch(e->prefixo + 8 * k); // três níveis abaixo: os 8 descendentes ocupam uma linha de cache
+        size_t d = e->desloc[k];       // 'texto' tem ao menos d bytes iguais aos desta subárvore
+        uint64_t p = e->prefixo[k], alvo = eyt_prefixo(texto + d);
+        int menor = (p < alvo) | ((p == alvo) && strcmp(e->textos[e->posto[k]] + d, texto + d) < 0);
+        k = 2 * k + (size_t)menor;
+    }
+    k >>= __builtin_ffsll((long long)~k); // desfaz as descidas à direita do final
+    return k ? e->posto[k] : e->n;
+}
+
+/* eytBuscar - posto (= ID no catálogo) da pista com texto exato, ou -1 */
+long eytBuscar(const Eytzinger *e, const char *texto) {
+    size_t r = eytPosto(e, texto);
+    return (r < e->n && strcmp(e->textos[r], texto) == 0) ? (long)r : -1;
+}
+
+/* eytSelecionar - select: texto da pista de posto 'r' (NULL fora do intervalo) */
+static inline const char *eytSelecionar(const Eytzinger *e, size_t r) {
+    return r < e->n ? e->textos[r] : NULL;
+}
+
+/* cat_buscarIndice - procura 'texto' em vetor de textos com índice aberto; retorna o ID ou -1 */
+static long cat_buscarIndice(const long *indice, size_t cap, const char *const *textos, const char *texto) {
+    for (size_t i = hash_simple(texto, cap); indice[i] >= 0; i = (i + 1) % cap) // sondagem linear
+        if (strcmp(textos[indice[i]], texto) == 0) return indice[i];
+    return -1;
+}
+
+/* cat_numerarPistas - percorre o mapa numerando as salas (sala->id) e cada pista distinta (sala->pistaId) */
+static void cat_numerarPistas(Catalogo *c, Sala *s, long *indice, size_t cap) {
+    if (!s) return;
+    s->id = (int)c->nSalas;            // salas em pré-ordem
+    c->salas[c->nSalas++] = s;
+    const char *p = salaPista(s);
+    s->pistaId = -1;                   // sala sem pista
+    if (p) {
+        long id = cat_buscarIndice(indice, cap, c->pistas, p);
+        if (id < 0) {                  // pista nova: próximo ID livre
+            id = (long)c->nPistas++;
+            c->pistas[id] = p;
+            size_t i = hash_simple(p, cap);
+            while (indice[i] >= 0) i = (i + 1) % cap;
+            indice[i] = id;
+        }
+        s->pistaId = (int)id;
+    }
+    cat_numerarPistas(c, s->esq, indice, cap);
+    cat_numerarPistas(c, s->dir, indice, cap);
+}
+
+/*
+ * cat_indexarNomes - monta o índice nome -> sala. As salas entram de trás
+ * para a frente, então cada lista de homônimos fica em pré-ordem.
+ */
+static void cat_indexarNomes(Catalogo *c) {
+    c->capNomes = 16;
+    while (c->capNomes * 3 < c->nSalas * 4) c->capNomes *= 2; // ocupação <= 75% mesmo sem homônimos
+    c->nomes = calloc(c->capNomes, sizeof(uint64_t));
+    c->mesmoNome = malloc((c->nSalas ? c->nSalas : 1) * sizeof(uint32_t));
+    if (!c->nomes || !c->mesmoNome) { fprintf(stderr, "Erro: memória insuficiente ao criar catálogo.\n"); exit(EXIT_FAILURE); }
+    for (size_t id = c->nSalas; id-- > 0; ) {
+        const char *nome = salaNome(c->salas[id]);
+        uint64_t h = hash_filtro(nome, strlen(nome));
+        size_t i = (size_t)h & (c->capNomes - 1);
+        c->mesmoNome[id] = UINT32_MAX;
+        for (; c->nomes[i]; i = (i + 1) & (c->capNomes - 1)) {
+            uint32_t outra = (uint32_t)c->nomes[i] - 1;
+            if ((c->nomes[i] >> 32) == (h >> 32) && strcmp(salaNome(c->salas[outra]), nome) == 0) {
+                c->mesmoNome[id] = outra; // homônimo: 'id' passa a ser o primeiro da lista
+                break;
+            }
+        }
+        c->nomes[i] = (h >> 32 << 32) | (uint64_t)(id + 1);
+    }
+}
+
+/* cat_compararTextos - comparador de qsort para vetor de textos (ordem de strcmp) */
+static int cat_compararTextos(const void *a, const void *b) {
+    return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+/* contarSalas - número de salas da árvore */
+static size_t contarSalas(const Sala *s) {
+    return s ? 1 + contarSalas(s->esq) + contarSalas(s->dir) : 0;
+}
+
+/*
+ * criarCatalogo - numera as pistas do mapa (preenche sala->pistaId) e os
+ * suspeitos que elas apontam na tabela hash, e pré-calcula as máscaras.
+ */
+Catalogo *criarCatalogo(Sala *mapa, HashTable *ht) {
+    Catalogo *c = calloc(1, sizeof(Catalogo));
+    size_t nSalas = contarSalas(mapa);
+    size_t cap = 2 * nSalas + 1;       // índice aberto com ocupação <= 50%
+    long *indice = malloc(cap * sizeof(long));
+    if (!c || !indice) {
+        fprintf(stderr, "Erro: memória insuficiente ao criar catálogo.\n");
+        exit(EXIT_FAILURE);
+    }
+    c->pistas = malloc((nSalas ? nSalas : 1) * sizeof(char *));
+    c->salas = malloc((nSalas ? nSalas : 1) * sizeof(Sala *));
+    if (!c->pistas || !c->salas) { fprintf(stderr, "Erro: memória insuficiente ao criar catálogo.\n"); exit(EXIT_FAILURE); }
+    for (size_t i = 0; i < cap; ++i) indice[i] = -1;
+    cat_numerarPistas(c, mapa, indice, cap);
+    cat_indexarNomes(c);
+
+    // renumera as pistas em ordem alfabética: ID = posto, e a ordem dos bits é a ordem de exibição
+    const char **ordenadas = malloc((c->nPistas ? c->nPistas : 1) * sizeof(char *));
+    int *novoId = malloc((c->nPistas ? c->nPistas : 1) * sizeof(int));
+    if (!ordenadas || !novoId) { fprintf(stderr, "Erro: memória insuficiente ao criar catálogo.\n"); exit(EXIT_FAILURE); }
+    memcpy(ordenadas, c->pistas, c->nPistas * sizeof(char *));
+    qsort(ordenadas, c->nPistas, sizeof(char *), cat_compararTextos);
+    for (size_t r = 0; r < c->nPistas; ++r)
+        novoId[cat_buscarIndice(indice, cap, c->pistas, ordenadas[r])] = (int)r;
+    for (size_t i = 0; i < c->nSalas; ++i)
+        if (c->salas[i]->pistaId >= 0) c->salas[i]->pistaId = novoId[c->salas[i]->pistaId];
+    free(novoId);
+    free(c->pistas);
+    c->pistas = ordenadas;
+    c->ordem = eytCriar(c->pistas, c->nPistas);
+
+    // suspeitos: um ID por nome distinto apontado por alguma pista do mapa
+    c->suspeitoDaPista = malloc((c->nPistas ? c->nPistas : 1) * sizeof(int));
+    c->suspeitos = malloc((c->nPistas ? c->nPistas : 1) * sizeof(char *));
+    if (!c->suspeitoDaPista || !c->suspeitos) { fprintf(stderr, "Erro: memória insuficiente ao criar catálogo.\n"); exit(EXIT_FAILURE); }
+    for (size_t i = 0; i < cap; ++i) indice[i] = -1; // reaproveita o índice para os nomes
+    for (size_t p = 0; p < c->nPistas; ++p) {
+        const char *sus = encontrarSuspeitoSemMedir(ht, c->pistas[p]); // carga: fora do histograma do jogo
+        long id = -1;
+        if (sus) {
+            id = cat_buscarIndice(indice, cap, (const char *const *)c->suspeitos, sus);
+            if (id < 0) {              // suspeito novo
+                id = (long)c->nSuspeitos++;
+                c->suspeitos[id] = str_dup(sus);
+                size_t i = hash_simple(sus, cap);
+                while (indice[i] >= 0) i = (i + 1) % cap;
+                indice[i] = id;
+            }
+        }
+        c->suspeitoDaPista[p] = (int)id;
+    }
+    free(indice);
+    c->registro = regCriar((const char *const *)c->suspeitos, c->nSuspeitos);
+
+    // máscaras: bit p ligado na máscara do suspeito apontado pela pista p
+    c->nPalavras = (c->nPistas + 63) / 64;
+    if (c->nPalavras == 0) c->nPalavras = 1;
+    c->mascaras = calloc((c->nSuspeitos ? c->nSuspeitos : 1) * c->nPalavras, sizeof(uint64_t));
+    if (!c->mascaras) { fprintf(stderr, "Erro: memória insuficiente ao criar catálogo.\n"); exit(EXIT_FAILURE); }
+    for (size_t p = 0; p < c->nPistas; ++p) {
+        int s = c->suspeitoDaPista[p];
+        if (s >= 0) c->mascaras[(size_t)s * c->nPalavras + (p >> 6)] |= 1ull << (p & 63);
+    }
+    return c;
+}
+
+/*
+ * catalogoImpressao - resumo da numeração das pistas: quantidade e textos na
+ * ordem dos IDs. Quem guarda IDs fora do processo (o diário) confere com ela
+ * que o ID de hoje ainda é a mesma pista de quando foi gravado.
+ */
+uint64_t catalogoImpressao(const Catalogo *c) {
+    uint64_t h = (uint64_t)c->nPistas * 0x9E3779B97F4A7C15ull;
+    for (size_t i = 0; i < c->nPistas; ++i) {
+        h ^= hash_filtro(c->pistas[i], strlen(c->pistas[i]));
+        h = (h ^ (h >> 29)) * 0xBF58476D1CE4E5B9ull; // mistura: a ordem dos textos conta
+    }
+    return h;
+}
+
+/* liberarCatalogo - libera o catálogo (os textos das pistas pertencem ao mapa) */
+void liberarCatalogo(Catalogo *c) {
+    if (!c) return;
+    liberarRegistro(c->registro);
+    for (size_t i = 0; i < c->nSuspeitos; ++i) free(c->suspeitos[i]);
+    free(c->suspeitos);
+    free(c->suspeitoDaPista);
+    liberarEytzinger(c->ordem);
+    free(c->pistas);
+    free(c->salas);
+    free(c->nomes);
+    free(c->mesmoNome);
+    free(c->mascaras);
+    free(c);
+}
+
+/* buscarPistaId - ID (posto alfabético) da pista com texto exato, ou -1 */
+long buscarPistaId(const Catalogo *c, const char *texto) {
+    return eytBuscar(c->ordem, texto);
+}
+
+/*
+ * buscarSalaId - ID da primeira sala (em pré-ordem) com nome exato 'nome',
+ * ou -1. Os homônimos seguem em c->mesmoNome[id] até UINT32_MAX.
+ */
+long buscarSalaId(const Catalogo *c, const char *nome) {
+    uint64_t h = hash_filtro(nome, strlen(nome));
+    for (size_t i = (size_t)h & (c->capNomes - 1); c->nomes[i]; i = (i + 1) & (c->capNomes - 1)) {
+        uint32_t id = (uint32_t)c->nomes[i] - 1;
+        if ((c->nomes[i] >> 32) == (h >> 32) && strcmp(salaNome(c->salas[id]), nome) == 0) return (long)id;
+    }
+    return -1;
+}
+
+/*
+ * exibirPistasConjunto - imprime as pistas do conjunto em ordem alfabética.
+ * Como o ID é o posto, basta varrer os bits em sequência (mesma saída que
+ * exibirPistas sobre a BST, sem percorrer ponteiros).
+ */
+void exibirPistasConjunto(const Catalogo *c, const ConjuntoPistas *conj) {
+    for (size_t w = 0; w < conj->nPalavras; ++w) {
+        for (uint64_t bits = conj->palavras[w]; bits; bits &= bits - 1) { // cada bit ligado, do menor ao maior
+            size_t id = w * 64 + (size_t)__builtin_ctzll(bits);
+            printf(" - %s\n", eytSelecionar(c->ordem, id));
+        }
+    }
+}
+
+/*
+ * buscarSuspeitoId - ID do suspeito chamado 'nome', ou -1. Caixa, acentos e
+ * pontuação não contam (ver RegistroSuspeitos).
+ */
+int buscarSuspeitoId(const Catalogo *c, const char *nome) {
+    return (int)regBuscar(c->registro, nome);
+}
+
+#define SUGESTOES_MAX 3                // nomes oferecidos quando a acusação não reconhece o suspeito
+
+/*
+ * sugerirSuspeitos - escreve em 'buf' até SUGESTOES_MAX nomes de suspeitos
+ * parecidos com 'nome', do mais parecido ao menos, como "A, B ou C".
+ * Retorna quantos nomes foram escritos (0: nenhum parecido, 'buf' vazio).
+ */
+size_t sugerirSuspeitos(const Catalogo *c, const char *nome, char *buf, size_t cap) {
+    uint32_t ids[SUGESTOES_MAX];
+    size_t n = regSugerir(c->registro, nome, ids, SUGESTOES_MAX), usados = 0;
+    if (cap) buf[0] = '\0';
+    for (size_t i = 0; i < n && usados < cap; ++i) {
+        const char *sep = i == 0 ? "" : i + 1 == n ? " ou " : ", ";
+        int k = snprintf(buf + usados, cap - usados, "%s%s", sep, c->suspeitos[ids[i]]);
+        if (k < 0) break;
+        usados += (size_t)k;
+    }
+    return n;
+}
+
+/* evidenciasContra - quantas pistas do conjunto apontam para o suspeito 'sid' (AND + popcount) */
+size_t evidenciasContra(const Catalogo *c, const ConjuntoPistas *conj, int sid) {
+    if (sid < 0 || (size_t)sid >= c->nSuspeitos) return 0;
+    return popcountE(conj->palavras, c->mascaras + (size_t)sid * c->nPalavras, c->nPalavras);
+}
+
+/* ---------- Textos ordenados com front coding (catálogos grandes de pistas) ---------- */
+
+/*
+ * TextosFC - textos distintos em ordem alfabética, comprimidos em blocos de
+ * FC_BLOCO. O primeiro texto de cada bloco é guardado inteiro
+ * (varint tamanho + bytes); cada um dos seguintes guarda só quanto do prefixo
+ * repete do anterior e o sufixo novo (varint prefixo + varint sufixo + bytes).
+ * 'blocos' é o índice amostrado: onde começa cada bloco em 'dados' e uma
+ * chave do primeiro texto do bloco para a busca binária, no mesmo esquema do
+ * Eytzinger: quem chega ao bloco b na busca está entre os dois blocos que
+ * limitam o intervalo de b e compartilha o prefixo deles, então a chave são
+ * os 8 bytes que vêm depois desse prefixo. Quase toda a busca binária fica
+ * dentro do índice (compacto) e só os empates leem o texto em 'dados'.
+ *   busca por texto - busca binária entre os primeiros textos dos blocos
+ *                     e depois varredura de no máximo FC_BLOCO-1 textos;
+ *   texto pelo ID   - decodifica só o bloco do ID (custo constante);
+ *   em ordem        - CursorFC decodifica os textos em sequência.
+ * O ID é o posto do texto na ordem alfabética, como no Catalogo.
+ */
+#define FC_BLOCO 16                   // textos por bloco (1 inteiro + 15 com prefixo compartilhado)
+
+/* IndiceFC - entrada do índice amostrado (uma por bloco) */
+typedef struct IndiceFC {
+    uint64_t desloc;                  // início do bloco em 'dados'
+    uint64_t chave;                   // 8 bytes do primeiro texto a partir de 'pular' (big-endian)
+    uint32_t pular;                   // prefixo garantido a quem chega a este bloco na busca binária
+} IndiceFC;
+
+typedef struct TextosFC {
+    size_t n;                         // quantidade de textos
+    size_t maior;                     // maior comprimento (buffers de decodificação: maior + 1)
+    size_t nBlocos;                   // ceil(n / FC_BLOCO)
+    IndiceFC *blocos;                 // [nBlocos] índice amostrado
+    unsigned char *dados;             // registros codificados
+    size_t tamDados;                  // bytes usados em 'dados'
+} TextosFC;
+
+/* CursorFC - percurso em ordem sobre um TextosFC */
+typedef struct CursorFC {
+    const TextosFC *t;
+    size_t id;                        // ID do próximo texto
+    const unsigned char *p;           // próximo registro em 'dados'
+    size_t tam;                       // comprimento do texto atual
+    char *texto;                      // texto atual (buffer do chamador, t->maior + 1 bytes)
+} CursorFC;
+
+/* fc_gravarVarint - grava 'v' em base 128 (7 bits por byte); retorna os bytes usados */
+static size_t fc_gravarVarint(unsigned char *p, size_t v) {
+    size_t n = 0;
+    while (v >= 0x80) { p[n++] = (unsigned char)(v | 0x80); v >>= 7; }
+    p[n++] = (unsigned char)v;
+    return n;
+}
+
+/* fc_lerVarint - lê um varint gravado por fc_gravarVarint e avança *p */
+static inline size_t fc_lerVarint(const unsigned char **p) {
+    size_t v = 0;
+    int desloc = 0;
+    unsigned char b;
+    do { b = *(*p)++; v |= (size_t)(b & 0x7F) << desloc; desloc += 7; } while (b & 0x80);
+    return v;
+}
+
+/*
+ * fc_indexar - preenche as chaves dos blocos no intervalo (lo, hi) da busca
+ * binária de fcBuscar. 'loValido' = 0 no ramo mais à esquerda, onde não se
+ * sabe se o alvo é >= o primeiro bloco (então nada é pulado).
+ */
+static void fc_indexar(TextosFC *t, const char *const *ordenados, size_t lo, size_t hi, int loValido) {
+    if (hi - lo <= 1) return;
+    size_t meio = lo + (hi - lo) / 2;
+    size_t d = loValido && hi < t->nBlocos ? eyt_lcp(ordenados[lo * FC_BLOCO], ordenados[hi * FC_BLOCO]) : 0;
+    t->blocos[meio].pular = (uint32_t)d;
+    t->blocos[meio].chave = eyt_prefixo(ordenados[meio * FC_BLOCO] + d);
+    fc_indexar(t, ordenados, lo, meio, loValido);
+    fc_indexar(t, ordenados, meio, hi, 1);
+}
+
+/*
+ * fcCriar - comprime 'ordenados' (n textos distintos em ordem de strcmp).
+ * Os textos de entrada não são guardados: podem ser liberados em seguida.
+ */
+TextosFC *fcCriar(const char *const *ordenados, size_t n) {
+    TextosFC *t = calloc(1, sizeof(TextosFC));
+    if (!t) { fprintf(stderr, "Erro: memória insuficiente ao comprimir textos.\n"); exit(EXIT_FAILURE); }
+    t->n = n;
+    t->nBlocos = (n + FC_BLOCO - 1) / FC_BLOCO;
+    size_t cap = 0;                    // pior caso: nenhum prefixo compartilhado
+    for (size_t i = 0; i < n; ++i) {
+        size_t tam = strlen(ordenados[i]);
+        if (tam > t->maior) t->maior = tam;
+        cap += tam + 2 * 10;
+    }
+    t->blocos = calloc(t->nBlocos ? t->nBlocos : 1, sizeof(IndiceFC));
+    t->dados = malloc(cap ? cap : 1);
+    if (!t->blocos || !t->dados) { fprintf(stderr, "Erro: memória insuficiente ao comprimir textos.\n"); exit(EXIT_FAILURE); }
+    size_t pos = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const char *s = ordenados[i];
+        size_t tam = strlen(s), comum = 0;
+        if (i % FC_BLOCO == 0) {
+            t->blocos[i / FC_BLOCO].desloc = pos;
+            pos += fc_gravarVarint(t->dados + pos, tam);
+        } else {
+            const char *ant = ordenados[i - 1];
+            while (s[comum] && s[comum] == ant[comum]) ++comum;
+            pos += fc_gravarVarint(t->dados + pos, comum);
+            pos += fc_gravarVarint(t->dados + pos, tam - comum);
+        }
+        memcpy(t->dados + pos, s + comum, tam - comum);
+        pos += tam - comum;
+    }
+    t->tamDados = pos;
+    fc_indexar(t, ordenados, 0, t->nBlocos, 0);
+    unsigned char *justo = realloc(t->dados, pos ? pos : 1); // devolve a folga do pior caso
+    if (justo) t->dados = justo;
+    return t;
+}
+
+/* liberarTextosFC - libera a estrutura */
+void liberarTextosFC(TextosFC *t) {
+    if (!t) return;
+    free(t->blocos);
+    free(t->dados);
+    free(t);
+}
+
+/* fcCursor - posiciona 'c' antes do texto 'id'; 'buf' tem pelo menos t->maior + 1 bytes */
+void fcCursor(CursorFC *c, const TextosFC *t, size_t id, char *buf) {
+    c->t = t;
+    c->texto = buf;
+    c->tam = 0;
+    c->id = id < t->n ? id - id % FC_BLOCO : t->n;
+    c->p = c->id < t->n ? t->dados + t->blocos[c->id / FC_BLOCO].desloc : NULL;
+    buf[0] = '\0';
+    while (c->id < id && c->id < t->n) { // decodifica o começo do bloco até chegar em 'id'
+        size_t comum = c->id % FC_BLOCO ? fc_lerVarint(&c->p) : 0;
+        size_t sufixo = fc_lerVarint(&c->p);
+        memcpy(buf + comum, c->p, sufixo);
+        c->p += sufixo;
+        c->tam = comum + sufixo;
+        c->id++;
+    }
+}
+
+/* fcProximo - decodifica o próximo texto (válido até a chamada seguinte) ou NULL no fim */
+const char *fcProximo(CursorFC *c) {
+    if (c->id >= c->t->n) return NULL;
+    size_t comum = c->id % FC_BLOCO ? fc_lerVarint(&c->p) : 0; // início de bloco: texto inteiro
+    size_t sufixo = fc_lerVarint(&c->p);
+    memcpy(c->texto + comum, c->p, sufixo);
+    c->p += sufixo;
+    c->tam = comum + sufixo;
+    c->texto[c->tam] = '\0';
+    c->id++;
+    return c->texto;
+}
+
+/* fcTexto - texto de ID 'id' decodificado em 'buf' (t->maior + 1 bytes), ou NULL se não existir */
+const char *fcTexto(const TextosFC *t, size_t id, char *buf) {
+    if (id >= t->n) return NULL;
+    CursorFC c;
+    fcCursor(&c, t, id, buf);
+    return fcProximo(&c);
+}
+
+/* fc_compararCabeca - compara o texto inteiro do início do bloco 'b' com 'alvo' (como strcmp) */
+static int fc_compararCabeca(const TextosFC *t, size_t b, const char *alvo, size_t tamAlvo) {
+    const unsigned char *p = t->dados + t->blocos[b].desloc;
+    size_t tam = fc_lerVarint(&p);
+    int r = memcmp(p, alvo, tam < tamAlvo ? tam : tamAlvo);
+    return r ? r : (tam > tamAlvo) - (tam < tamAlvo);
+}
+
+/*
+ * fcBuscar - ID de 'texto' ou -1. Busca binária nos inícios de bloco (pelas
+ * chaves do índice; o texto do bloco só é lido se a chave empatar) e, no
+ * bloco escolhido, varredura até passar do alvo.
+ * Na varredura só é preciso comparar a partir do prefixo que o texto
+ * decodificado tem em comum com o alvo: enquanto o registro repetir mais
+ * prefixo do que isso, o texto continua menor que o alvo.
+ */
+long fcBuscar(const TextosFC *t, const char *texto) {
+    if (!t->n) return -1;
+    size_t tamAlvo = strlen(texto);
+    size_t lo = 0, hi = t->nBlocos;    // último bloco cujo início <= alvo
+    while (hi - lo > 1) {
+        size_t meio = lo + (hi - lo) / 2;
+        const IndiceFC *ix = &t->blocos[meio];
+        uint64_t alvo = eyt_prefixo(texto + ix->pular); // 'texto' tem ao menos 'pular' bytes (ver fc_indexar)
+        int c = (ix->chave > alvo) - (ix->chave < alvo);
+        if (c == 0) c = fc_compararCabeca(t, meio, texto, tamAlvo);
+        if (c <= 0) lo = meio; else hi = meio;
+    }
+    const unsigned char *p = t->dados + t->blocos[lo].desloc;
+    size_t id = lo * FC_BLOCO, fim = id + FC_BLOCO < t->n ? id + FC_BLOCO : t->n;
+    size_t casado = 0;                 // bytes iniciais do texto atual iguais aos do alvo
+    for (; id < fim; ++id) {
+        size_t comum = id % FC_BLOCO ? fc_lerVarint(&p) : 0;
+        size_t sufixo = fc_lerVarint(&p);
+        const unsigned char *s = p;
+        p += sufixo;
+        if (comum > casado) continue;  // repete mais que o casado: ainda menor que o alvo
+        if (comum < casado) return -1; // divergiu antes: já passou do alvo
+        size_t tam = comum + sufixo, k = 0;
+        while (casado < tam && casado < tamAlvo && (unsigned char)texto[casado] == s[k]) { ++casado; ++k; }
+        if (casado == tam && casado == tamAlvo) return (long)id;
+        if (casado < tam && (casado == tamAlvo || s[k] > (unsigned char)texto[casado])) return -1; // maior que o alvo
+    }
+    return -1;
+}
+
+/* ---------- Coleção persistente de pistas (ramificação "e se...") ---------- */
+
+/*
+ * NoPers - nó de uma treap persistente de IDs de pistas. Inserir não altera
+ * a versão antiga: copia apenas o caminho da raiz até o ponto de inserção
+ * (O(log n) nós esperados) e compartilha o resto. Cada nó conta quantas
+ * versões/pais o referenciam; ramificar uma versão é só incrementar a
+ * contagem da raiz (O(1)), e persLiberar libera o que deixou de ser usado.
+ */
+typedef struct NoPers {
+    int id;                   // ID da pista (chave da árvore de busca)
+    unsigned prio;            // prioridade de heap, derivada do ID (mantém a altura O(log n))
+    unsigned ref;             // número de referências (pais e versões) a este nó
+    unsigned tam;             // número de pistas nesta subárvore
+    struct NoPers *esq, *dir; // filhos (compartilhados entre versões)
+} NoPers;
+
+static unsigned long long g_persVivos;  // nós persistentes alocados e ainda não liberados
+
+/* pers_prio - prioridade pseudoaleatória e determinística para o ID */
+static unsigned pers_prio(int id) {
+    unsigned x = (unsigned)id * 2654435761u;
+    x ^= x >> 16; x *= 0x45d9f3bu; x ^= x >> 16;
+    return x;
+}
+
+static unsigned pers_tam(const NoPers *n) { return n ? n->tam : 0; }
+
+/* pers_novo - cria um nó com ref 1, copiando filhos de 'modelo' (se houver) */
+static NoPers *pers_novo(int id, const NoPers *modelo) {
+    NoPers *n = malloc(sizeof(NoPers));
+    if (!n) {
+        fprintf(stderr, "Erro: memória insuficiente ao criar versão de pistas.\n");
+        exit(EXIT_FAILURE);
+    }
+    g_persVivos++;
+    n->id = id;
+    n->prio = pers_prio(id);
+    n->ref = 1;
+    n->esq = modelo ? modelo->esq : NULL;
+    n->dir = modelo ? modelo->dir : NULL;
+    if (n->esq) n->esq->ref++;         // a cópia também referencia os filhos
+    if (n->dir) n->dir->ref++;
+    n->tam = 1 + pers_tam(n->esq) + pers_tam(n->dir);
+    return n;
+}
+
+/* persLiberar - solta uma referência à versão 'v' (libera os nós que ficarem sem dono) */
+void persLiberar(NoPers *v) {
+    while (v && --v->ref == 0) {       // só desce enquanto o nó morre
+        persLiberar(v->esq);
+        NoPers *dir = v->dir;
+        free(v);
+        g_persVivos--;
+        v = dir;                       // recursão de cauda no filho direito
+    }
+}
+
+/* persRamificar - nova referência à mesma versão, O(1); as duas evoluem independentes */
+NoPers *persRamificar(NoPers *v) {
+    if (v) v->ref++;
+    return v;
+}
+
+/* persContem - retorna 1 se a pista 'id' está na versão 'v' */
+int persContem(const NoPers *v, int id) {
+    while (v && v->id != id) v = id < v->id ? v->esq : v->dir;
+    return v != NULL;
+}
+
+/* pers_ins - insere 'id' (ausente) em 'n' copiando o caminho; devolve nova referência própria */
+static NoPers *pers_ins(NoPers *n, int id) {
+    if (!n) return pers_novo(id, NULL);
+    NoPers *c = pers_novo(n->id, n);   // cópia do nó do caminho
+    if (id < n->id) {
+        NoPers *f = pers_ins(n->esq, id);
+        persLiberar(c->esq);           // solta a referência copiada (a versão antiga continua dona)
+        c->esq = f;
+        if (f->prio > c->prio) {       // f é nó novo (ref 1): rotação à direita sem mexer em refs
+            c->esq = f->dir;
+            f->dir = c;
+            c->tam = 1 + pers_tam(c->esq) + pers_tam(c->dir);
+            c = f;
+        }
+    } else {
+        NoPers *f = pers_ins(n->dir, id);
+        persLiberar(c->dir);
+        c->dir = f;
+        if (f->prio > c->prio) {       // rotação à esquerda
+            c->dir = f->esq;
+            f->esq = c;
+            c->tam = 1 + pers_tam(c->esq) + pers_tam(c->dir);
+            c = f;
+        }
+    }
+    c->tam = 1 + pers_tam(c->esq) + pers_tam(c->dir);
+    return c;
+}
+
+/*
+ * persInserir - devolve uma NOVA versão com a pista 'id' (referência própria,
+ * a liberar com persLiberar); 'v' continua válida e inalterada.
+ */
+NoPers *persInserir(NoPers *v, int id) {
+    if (persContem(v, id)) return persRamificar(v); // já presente: mesma versão
+    return pers_ins(v, id);
+}
+
+/* persContarSuspeitos - soma em 'contagens[s]' as pistas da versão que apontam para cada suspeito */
+void persContarSuspeitos(const NoPers *v, const Catalogo *cat, unsigned *contagens) {
+    for (; v; v = v->dir) {
+        persContarSuspeitos(v->esq, cat, contagens);
+        int s = cat->suspeitoDaPista[v->id];
+        if (s >= 0) contagens[s]++;
+    }
+}
+
+/* ---------- Diário de eventos (registro binário só de acréscimo) ---------- */
+
+/*
+ * Formato do arquivo de diário:
+ *   cabeçalho "DQJ2", u32 número de pistas, u64 catalogoImpressao
+ *   registros: [u32 tamanho do conteúdo][u8 tipo][conteúdo]
+ * Os registros guardam IDs de pista, que só valem para o catálogo em que
+ * foram gravados: um diário de outro catálogo (ou do formato "DQJ1", de
+ * antes da numeração alfabética) é recusado, tanto para reproduzir quanto
+ * para continuar gravando.
+ * Cada sessão começa com um DIARIO_PONTO (ponto de retomada com o estado
+ * acumulado) e é gravada de uma vez, com um único write, ao terminar.
+ * O arquivo "<diário>.idx" ("DQI1" e 4 zeros + entradas de tamanho fixo) guarda o
+ * deslocamento de cada ponto de retomada, para saltar direto a uma sessão.
+ */
+#define DIARIO_MAGICO     "DQJ2"
+#define DIARIO_IDX_MAGICO "DQI1"
+#define DIARIO_INICIO_REG 16           // bytes do cabeçalho do arquivo (os registros começam aqui)
+#define DIARIO_OUTRO_CATALOGO (-2)     // reproduzirDiario: diário de outro catálogo de pistas
+#define DIARIO_CAB        5            // bytes de cabeçalho de registro (tamanho + tipo)
+#define DIARIO_LOTE       (1u << 20)   // grava antes disso se a sessão for muito longa
+
+enum {
+    DIARIO_PONTO = 1,   // u32 sessão, u64 eventos anteriores, u32 nPalavras, u64 palavras[] (pistas já vistas)
+    DIARIO_INICIO,      // u64 instante (ns, relógio de parede)
+    DIARIO_MOVER,       // u32 sala de destino, u8 comando ('e', 'd', 'v' ou 't')
+    DIARIO_PISTA,       // u32 pista coletada
+    DIARIO_CONSULTA,    // u32 pista, u8 1 se a hash associou um suspeito (0 = nenhum)
+    DIARIO_ACUSACAO,    // i32 suspeito (-1 = desconhecido), u8 procedente, texto digitado
+    DIARIO_FIM          // sem conteúdo
+};
+
+/* EntradaIndice - uma entrada do arquivo .idx (um ponto de retomada por sessão) */
+typedef struct EntradaIndice {
+    uint64_t deslocamento;    // posição do DIARIO_PONTO no diário
+    uint64_t eventos;         // eventos gravados antes dele
+    uint32_t sessao;          // número da sessão
+    uint32_t reservado;       // alinhamento (zero)
+} EntradaIndice;
+
+/* Diario - diário aberto para acréscimo, com o lote da sessão atual em memória */
+typedef struct Diario {
+    int fd, fdIdx;            // descritores do diário e do índice
+    unsigned char *buf;       // lote de registros ainda não gravados
+    size_t usado, cap;        // bytes usados e capacidade do lote
+    uint64_t tamArquivo;      // bytes já gravados no diário
+    uint64_t eventos;         // eventos registrados até agora
+    uint32_t sessao;          // número da próxima sessão
+    int temPonto;             // há um ponto de retomada no lote atual?
+    EntradaIndice ponto;      // entrada de índice a gravar junto com o lote
+    ConjuntoPistas *vistas;   // pistas vistas em todas as sessões já gravadas (vai nos pontos)
+    ConjuntoPistas *daSessao; // pistas da sessão atual
+} Diario;
+
+/* Reproducao - estado reconstruído a partir do diário */
+typedef struct Reproducao {
+    uint64_t eventos;         // posição no diário (eventos desde o início do arquivo)
+    uint64_t lidos;           // registros efetivamente decodificados nesta reprodução
+    uint32_t sessoes;         // sessões concluídas (DIARIO_FIM)
+    uint32_t sessaoAtual;     // número da sessão em andamento
+    int32_t salaAtual;        // sala onde o jogador está (-1 fora de sessão)
+    uint64_t movimentos, pistas, consultas, consultasVazias; // totais por tipo
+    uint64_t acusacoes, procedentes;                        // acusações e quantas procederam
+    uint32_t inteiras;        // sessões lidas do início ao fim nesta reprodução
+    ConjuntoPistas *daSessao; // pistas da sessão em andamento
+    ConjuntoPistas *vistas;   // pistas vistas em alguma sessão (união, retomada pelos pontos)
+    ConjuntoPistas *emTodas;  // pistas vistas em todas as sessões inteiras desta reprodução (interseção)
+} Reproducao;
+
+/* definidas na seção de reprodução; diarioAbrir as usa para retomar um diário existente */
+int reproduzirDiario(const char *caminho, uint32_t desde, const Catalogo *cat, Reproducao *r);
+void liberarReproducao(Reproducao *r);
+
+/* diario_gravarTudo - write completo (repete em escrita parcial e em interrupção por sinal) */
+static int diario_gravarTudo(int fd, const void *dados, size_t n) {
+    const unsigned char *p = dados;
+    while (n) {
+        ssize_t w = write(fd, p, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;  // SIGHUP do servidor, por exemplo: nada foi gravado
+            return -1;
+        }
+        p += w;
+        n -= (size_t)w;
+    }
+    return 0;
+}
+
+/*
+ * diarioDescarregar - grava o lote pendente (um write) e a entrada de índice,
+ * se houver. Se os dados não forem gravados, o lote é descartado inteiro: o
+ * arquivo volta ao tamanho anterior (uma escrita parcial deixaria um registro
+ * cortado no meio do diário) e o índice não ganha uma entrada que apontaria
+ * para o vazio. Uma entrada de índice cortada também é desfeita, para que as
+ * seguintes continuem alinhadas.
+ */
+void diarioDescarregar(Diario *d) {
+    if (!d || !d->usado) return;
+    if (diario_gravarTudo(d->fd, d->buf, d->usado) < 0) {
+        fprintf(stderr, "Aviso: falha ao gravar o diário; a sessão em andamento não foi registrada.\n");
+        if (ftruncate(d->fd, (off_t)d->tamArquivo) < 0)
+            fprintf(stderr, "Aviso: o diário ficou com um registro incompleto no fim.\n");
+    } else {
+        if (d->temPonto) {             // índice só depois dos dados: nunca aponta para o vazio
+            if (diario_gravarTudo(d->fdIdx, &d->ponto, sizeof(d->ponto)) < 0) {
+                fprintf(stderr, "Aviso: falha ao gravar o índice do diário.\n");
+                struct stat st;
+                if (fstat(d->fdIdx, &st) == 0 && st.st_size > 8  // volta à última entrada completa
+                    && ftruncate(d->fdIdx, 8 + (st.st_size - 8) / (off_t)sizeof(EntradaIndice) * (off_t)sizeof(EntradaIndice)) < 0) {
+                    /* sem como corrigir: a reprodução confere cada ponto e, se não bater, lê desde o início */
+                }
+            }
+        }
+        d->tamArquivo += d->usado;
+    }
+    d->temPonto = 0;
+    d->usado = 0;
+}
+
+/* diario_registro - reserva no lote um registro do tipo dado com 'n' bytes de conteúdo */
+static unsigned char *diario_registro(Diario *d, uint8_t tipo, size_t n) {
+    if (d->usado + DIARIO_CAB + n > d->cap) {
+        if (d->usado >= DIARIO_LOTE) diarioDescarregar(d); // sessão longa: grava o que já tem
+        size_t novo = d->cap;
+        while (d->usado + DIARIO_CAB + n > novo) novo *= 2;
+        if (novo != d->cap) {
+            unsigned char *b = realloc(d->buf, novo);
+            if (!b) { fprintf(stderr, "Erro: memória insuficiente no diário.\n"); exit(EXIT_FAILURE); }
+            d->buf = b;
+            d->cap = novo;
+        }
+    }
+    unsigned char *r = d->buf + d->usado;
+    uint32_t tam = (uint32_t)n;
+    memcpy(r, &tam, 4);
+    r[4] = tipo;
+    d->usado += DIARIO_CAB + n;
+    d->eventos++;
+    return r + DIARIO_CAB;             // conteúdo a preencher pelo chamador
+}
+
+/* diario_cabecalho - os DIARIO_INICIO_REG bytes do início de um diário gravado com 'cat' */
+static void diario_cabecalho(unsigned char *cab, const Catalogo *cat) {
+    uint32_t n = (uint32_t)cat->nPistas;
+    uint64_t impressao = catalogoImpressao(cat);
+    memcpy(cab, DIARIO_MAGICO, 4);
+    memcpy(cab + 4, &n, 4);
+    memcpy(cab + 8, &impressao, 8);
+}
+
+/*
+ * diarioAbrir - abre (ou cria) o diário e seu índice para acréscimo; NULL em
+ * caso de erro ou se o diário existente for de outro catálogo. Num diário existente, o estado acumulado (sessões, eventos e
+ * pistas vistas) é recuperado reproduzindo só a partir do último ponto.
+ */
+Diario *diarioAbrir(const char *caminho, const Catalogo *cat) {
+    char caminhoIdx[1024];
+    snprintf(caminhoIdx, sizeof(caminhoIdx), "%s.idx", caminho);
+    int fd = open(caminho, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) return NULL;
+    unsigned char cab[DIARIO_INICIO_REG], lido[DIARIO_INICIO_REG];
+    diario_cabecalho(cab, cat);
+    struct stat st, stIdx;
+    if (fstat(fd, &st) < 0) { close(fd); return NULL; }
+    if (st.st_size != 0 && (pread(fd, lido, sizeof(lido), 0) != (ssize_t)sizeof(lido) || memcmp(lido, cab, sizeof(cab)) != 0)) {
+        fprintf(stderr, "Aviso: %s foi gravado com outro catálogo de pistas (ou num formato antigo).\n", caminho);
+        close(fd);
+        return NULL;
+    }
+    int fdIdx = open(caminhoIdx, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fdIdx < 0 || fstat(fdIdx, &stIdx) < 0) {
+        close(fd);
+        if (fdIdx >= 0) close(fdIdx);
+        return NULL;
+    }
+    // arquivos novos: cabeçalhos gravados antes de tudo; se falharem, o diário não é usado
+    // (e o arquivo volta a ficar vazio, para não ser recusado como de outro catálogo depois)
+    if ((st.st_size == 0 && diario_gravarTudo(fd, cab, sizeof(cab)) < 0)
+        || (stIdx.st_size == 0 && diario_gravarTudo(fdIdx, DIARIO_IDX_MAGICO "\0\0\0", 8) < 0)) { // 8 bytes: entradas alinhadas
+        if (st.st_size == 0 && ftruncate(fd, 0) < 0) { /* melhor esforço: o erro já é do disco */ }
+        if (stIdx.st_size == 0 && ftruncate(fdIdx, 0) < 0) { /* idem */ }
+        close(fd);
+        close(fdIdx);
+        return NULL;
+    }
+    Diario *d = calloc(1, sizeof(Diario));
+    if (!d) { fprintf(stderr, "Erro: memória insuficiente no diário.\n"); exit(EXIT_FAILURE); }
+    d->fd = fd;
+    d->fdIdx = fdIdx;
+    d->cap = 4096;
+    d->buf = malloc(d->cap);
+    if (!d->buf) { fprintf(stderr, "Erro: memória insuficiente no diário.\n"); exit(EXIT_FAILURE); }
+    d->vistas = conjCriar(cat->nPistas);
+    d->daSessao = conjCriar(cat->nPistas);
+
+    d->tamArquivo = st.st_size ? (uint64_t)st.st_size : sizeof(cab);
+    if ((size_t)stIdx.st_size >= 8 + sizeof(EntradaIndice)) { // continua a numeração anterior
+        EntradaIndice ult;
+        Reproducao r;
+        if (pread(fdIdx, &ult, sizeof(ult), stIdx.st_size - (off_t)sizeof(ult)) == (ssize_t)sizeof(ult)
+            && reproduzirDiario(caminho, ult.sessao, cat, &r) == 0) {
+            d->sessao = ult.sessao + 1;
+            d->eventos = r.eventos;    // eventos até o fim do arquivo
+            conjCopiar(d->vistas, r.vistas);
+            liberarReproducao(&r);
+        }
+    }
+    return d;
+}
+
+/* diarioFechar - grava o que falta e fecha os arquivos */
+void diarioFechar(Diario *d) {
+    if (!d) return;
+    diarioDescarregar(d);
+    close(d->fd);
+    close(d->fdIdx);
+    conjLiberar(d->vistas);
+    conjLiberar(d->daSessao);
+    free(d->buf);
+    free(d);
+}
+
+/* diarioSessaoInicio - abre uma sessão com um ponto de retomada (inclui as pistas das sessões anteriores) */
+void diarioSessaoInicio(Diario *d) {
+    if (!d) return;
+    const ConjuntoPistas *vistas = d->vistas;
+    conjLimpar(d->daSessao);
+    d->ponto.deslocamento = d->tamArquivo + d->usado;
+    d->ponto.eventos = d->eventos;
+    d->ponto.sessao = d->sessao;
+    d->ponto.reservado = 0;
+    d->temPonto = 1;
+    uint32_t nPal = (uint32_t)vistas->nPalavras;
+    unsigned char *p = diario_registro(d, DIARIO_PONTO, 16 + (size_t)nPal * 8);
+    memcpy(p, &d->sessao, 4);
+    memcpy(p + 4, &d->ponto.eventos, 8);
+    memcpy(p + 12, &nPal, 4);
+    memcpy(p + 16, vistas->palavras, (size_t)nPal * 8);
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t instante = (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+    memcpy(diario_registro(d, DIARIO_INICIO, 8), &instante, 8);
+    d->sessao++;
+}
+
+/* diarioMover - registra a chegada à sala 'sala' pelo comando 'cmd' */
+void diarioMover(Diario *d, int sala, char cmd) {
+    if (!d) return;
+    unsigned char *p = diario_registro(d, DIARIO_MOVER, 5);
+    uint32_t s = (uint32_t)sala;
+    memcpy(p, &s, 4);
+    p[4] = (unsigned char)cmd;
+}
+
+/* diarioPista - registra a coleta da pista 'pista' */
+void diarioPista(Diario *d, int pista) {
+    if (!d) return;
+    uint32_t v = (uint32_t)pista;
+    memcpy(diario_registro(d, DIARIO_PISTA, 4), &v, 4);
+    if ((size_t)pista < d->daSessao->nPalavras * 64) conjInserir(d->daSessao, (size_t)pista);
+}
+
+/* diarioConsulta - registra a consulta de 'pista' à hash e se ela apontou algum suspeito */
+void diarioConsulta(Diario *d, int pista, int encontrado) {
+    if (!d) return;
+    unsigned char *p = diario_registro(d, DIARIO_CONSULTA, 5);
+    uint32_t v = (uint32_t)pista;
+    memcpy(p, &v, 4);
+    p[4] = (unsigned char)(encontrado ? 1 : 0);
+}
+
+/* diarioAcusacao - registra a acusação digitada, o suspeito reconhecido e o veredito */
+void diarioAcusacao(Diario *d, int suspeito, int procedente, const char *texto) {
+    if (!d) return;
+    size_t n = strlen(texto);
+    unsigned char *p = diario_registro(d, DIARIO_ACUSACAO, 5 + n);
+    int32_t s = suspeito;
+    memcpy(p, &s, 4);
+    p[4] = (unsigned char)(procedente ? 1 : 0);
+    memcpy(p + 5, texto, n);
+}
+
+/* diarioSessaoFim - fecha a sessão e grava o lote inteiro */
+void diarioSessaoFim(Diario *d) {
+    if (!d) return;
+    diario_registro(d, DIARIO_FIM, 0);
+    conjUniao(d->vistas, d->daSessao);
+    diarioDescarregar(d);
+}
+
+/* ---------- Reprodução do diário (modo linha de comando: ./mestre --reproduzir) ---------- */
+
+
+/* diario_mapear - mapeia um arquivo inteiro em memória só para leitura; NULL se falhar */
+static const unsigned char *diario_mapear(const char *caminho, size_t *tam) {
+    int fd = open(caminho, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size == 0) { close(fd); return NULL; }
+    void *m = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);                         // o mapeamento continua válido
+    if (m == MAP_FAILED) return NULL;
+    madvise(m, (size_t)st.st_size, MADV_SEQUENTIAL); // leitura de ponta a ponta
+    *tam = (size_t)st.st_size;
+    return m;
+}
+
+/*
+ * diario_buscarPonto - deslocamento do ponto de retomada da primeira sessão
+ * >= 'sessao' (0 se não houver índice), com o número dela em *achada
+ */
+static uint64_t diario_buscarPonto(const char *caminho, uint32_t sessao, uint32_t *achada) {
+    char caminhoIdx[1024];
+    snprintf(caminhoIdx, sizeof(caminhoIdx), "%s.idx", caminho);
+    size_t tam;
+    const unsigned char *m = diario_mapear(caminhoIdx, &tam);
+    if (!m) return 0;
+    const EntradaIndice *e = (const EntradaIndice *)(m + 8); // entradas após o mágico (alinhadas em 8)
+    size_t n = tam >= 8 ? (tam - 8) / sizeof(EntradaIndice) : 0;
+    uint64_t desl = 0;
+    if (memcmp(m, DIARIO_IDX_MAGICO, 4) == 0) {
+        size_t ini = 0, fim = n;       // busca binária: o índice cresce com a sessão
+        while (ini < fim) {
+            size_t meio = (ini + fim) / 2;
+            if (e[meio].sessao < sessao) ini = meio + 1; else fim = meio;
+        }
+        if (ini < n) {
+            desl = e[ini].deslocamento;
+            *achada = e[ini].sessao;
+        }
+    }
+    munmap((void *)m, tam);
+    return desl;
+}
+
+/* diario_ehPonto - há em 'desl' um DIARIO_PONTO inteiro da sessão 'sessao'? (índice velho ou de outro diário) */
+static int diario_ehPonto(const unsigned char *m, size_t tam, uint64_t desl, uint32_t sessao) {
+    if (desl < DIARIO_INICIO_REG || desl > tam || tam - desl < DIARIO_CAB + 16) return 0;
+    uint32_t n, s;
+    memcpy(&n, m + desl, 4);
+    memcpy(&s, m + desl + DIARIO_CAB, 4);
+    return m[desl + 4] == DIARIO_PONTO && n >= 16 && n <= tam - desl - DIARIO_CAB && s == sessao;
+}
+
+/*
+ * reproduzirDiario - decodifica o diário a partir da sessão 'desde' (0 = início),
+ * reconstruindo o estado em 'r'. Retorna 0 se o arquivo for válido; um
+ * registro menor que o conteúdo do seu tipo torna o diário inválido (-1),
+ * e um diário de outro catálogo é recusado (DIARIO_OUTRO_CATALOGO).
+ */
+int reproduzirDiario(const char *caminho, uint32_t desde, const Catalogo *cat, Reproducao *r) {
+    size_t tam;
+    const unsigned char *m = diario_mapear(caminho, &tam);
+    unsigned char cab[DIARIO_INICIO_REG];
+    diario_cabecalho(cab, cat);
+    if (!m || tam < 4 || (memcmp(m, DIARIO_MAGICO, 4) != 0 && memcmp(m, "DQJ1", 4) != 0)) {
+        if (m) munmap((void *)m, tam);
+        return -1;
+    }
+    if (tam < DIARIO_INICIO_REG || memcmp(m, cab, sizeof(cab)) != 0) { // "DQJ1" ou outra numeração de pistas
+        munmap((void *)m, tam);
+        return DIARIO_OUTRO_CATALOGO;
+    }
+    memset(r, 0, sizeof(*r));
+    r->salaAtual = -1;
+    r->daSessao = conjCriar(cat->nPistas);
+    r->vistas = conjCriar(cat->nPistas);
+    r->emTodas = conjCriar(cat->nPistas);
+    // conteúdo mínimo de cada tipo (o PONTO ainda precisa das suas palavras)
+    static const uint32_t minimo[] = { [DIARIO_PONTO] = 16, [DIARIO_MOVER] = 4, [DIARIO_PISTA] = 4,
+                                       [DIARIO_CONSULTA] = 5, [DIARIO_ACUSACAO] = 5 };
+    size_t pos = DIARIO_INICIO_REG;
+    if (desde > 0) {                   // salta direto ao ponto de retomada pelo índice
+        uint32_t achada = 0;
+        uint64_t desl = diario_buscarPonto(caminho, desde, &achada);
+        if (diario_ehPonto(m, tam, desl, achada)) pos = (size_t)desl; // senão lê desde o início
+    }
+    int corrompido = 0;
+    while (!corrompido && pos + DIARIO_CAB <= tam) {
+        uint32_t n;
+        memcpy(&n, m + pos, 4);
+        uint8_t tipo = m[pos + 4];
+        const unsigned char *p = m + pos + DIARIO_CAB;
+        if (n > tam - pos - DIARIO_CAB) break; // registro truncado (gravação interrompida)
+        if (tipo < sizeof(minimo) / sizeof(minimo[0]) && n < minimo[tipo]) { corrompido = 1; break; }
+        pos += DIARIO_CAB + n;
+        r->eventos++;
+        r->lidos++;
+        uint32_t u;
+        switch (tipo) {
+        case DIARIO_PONTO: {           // estado acumulado até aqui
+            uint32_t nPal;
+            memcpy(&nPal, p + 12, 4);
+            if (n < 16 + (uint64_t)nPal * 8) { corrompido = 1; break; }
+            memcpy(&r->sessaoAtual, p, 4);
+            r->sessoes = r->sessaoAtual; // sessões anteriores já concluídas
+            memcpy(&r->eventos, p + 4, 8);
+            r->eventos++;              // conta o próprio ponto
+            if (nPal > r->vistas->nPalavras) nPal = (uint32_t)r->vistas->nPalavras; // mapa menor que o do diário
+            memcpy(r->vistas->palavras, p + 16, (size_t)nPal * 8);
+            conjLimpar(r->daSessao);
+            r->salaAtual = 0;          // toda sessão começa na raiz
+            break;
+        }
+        case DIARIO_MOVER:
+            memcpy(&u, p, 4);
+            r->salaAtual = (int32_t)u;
+            r->movimentos++;
+            break;
+        case DIARIO_PISTA:
+            memcpy(&u, p, 4);
+            if (u < cat->nPistas) conjInserir(r->daSessao, u);
+            r->pistas++;
+            break;
+        case DIARIO_CONSULTA:
+            r->consultas++;
+            if (!p[4]) r->consultasVazias++;
+            break;
+        case DIARIO_ACUSACAO:
+            r->acusacoes++;
+            r->procedentes += p[4];
+            break;
+        case DIARIO_FIM:
+            conjUniao(r->vistas, r->daSessao);
+            if (r->salaAtual >= 0) {   // sessão lida desde o ponto dela (não apenas o fim)
+                if (r->inteiras++ == 0) conjCopiar(r->emTodas, r->daSessao);
+                else conjIntersecao(r->emTodas, r->daSessao);
+            }
+            r->sessoes++;
+            r->salaAtual = -1;
+            break;
+        default:                       // tipo desconhecido: o tamanho permite pular
+            break;
+        }
+    }
+    munmap((void *)m, tam);
+    if (corrompido) {
+        liberarReproducao(r);
+        return -1;
+    }
+    return 0;
+}
+
+/* liberarReproducao - libera os conjuntos da reprodução */
+void liberarReproducao(Reproducao *r) {
+    conjLiberar(r->daSessao);
+    conjLiberar(r->vistas);
+    conjLiberar(r->emTodas);
+}
+
+/* ---------- Sessão de exploração (máquina de estados retomável) ---------- */
+
+/*
+ * A lógica de uma exploração não mora mais num laço bloqueante: todo o estado
+ * de uma sessão cabe em Sessao (sala atual, fase e o conjunto de pistas), e
+ * sessaoAlimentar recebe uma entrada e devolve os eventos que ela produziu.
+ * Quem desenha a tela, lê o teclado ou escreve no socket é o front-end (jogo
+ * interativo, modo lote e servidor), que pode alternar entre quantas sessões
+ * quiser numa única thread. O mapa, a tabela hash e o catálogo ficam em
+ * Mundo, compartilhado e somente leitura.
+ *
+ * Os movimentos e/d/v/s são os da sessão do motor (motor.c): Mundo embute o
+ * Motor e Sessao embute a SessaoMotor, e o Mestre só acrescenta pelos
+ * ganchos do motor o que é dele — o conjunto de pistas (aoColetar), o "t"
+ * (comandoExtra) e a acusação depois do 's'.
+ */
+#define SESSAO_MAX_EVENTOS MOTOR_MAX_EVENTOS // eventos que uma única entrada pode gerar
+#define SESSAO_MAX_NOME    128         // maior nome de sala aceito por "t <nome>"
+
+/* Mundo - dados compartilhados por todas as sessões (somente leitura) */
+typedef struct Mundo {
+    Motor motor;                      // mapa e tabela hash (primeiro membro: os ganchos recebem &motor)
+    const Catalogo *cat;              // veredito e índice de nomes ('t'); NULL = sem acusação nem teletransporte
+} Mundo;
+
+/* fases da sessão */
+enum { SES_EXPLORANDO, SES_ACUSANDO, SES_ENCERRADA };
+
+/* tipos de evento: os do motor e os do Mestre */
+enum {
+    EV_INICIO = MOTOR_INICIO,         // sessão começou em 'sala'
+    EV_MOVEU = MOTOR_MOVEU,           // 'cmd' levou o jogador até 'sala'
+    EV_PISTA = MOTOR_PISTA,           // pista de 'sala' coletada ('suspeito' = NULL se desconhecido)
+    EV_SEM_PASSAGEM = MOTOR_SEM_PASSAGEM, // não há sala na direção de 'cmd'
+    EV_INVALIDO = MOTOR_INVALIDO,     // comando desconhecido
+    EV_FIM_EXPLORACAO = MOTOR_FIM,    // 's': a próxima entrada é o nome do acusado
+    EV_VEREDITO = MOTOR_EXTENSAO,     // acusação julgada ('valor' = 1 se procedente; 'suspeito' = NULL se não reconhecido)
+    EV_SALA_DESCONHECIDA,             // 't': nenhuma sala com esse nome (ou número de homônimo fora da faixa)
+    EV_SALA_AMBIGUA                   // 't': 'valor' salas com esse nome, a primeira em 'sala'
+};
+
+/* EventoSessao - o que uma entrada produziu (os ponteiros apontam para o Mundo) */
+typedef EventoMotor EventoSessao;
+
+/* Sessao - estado completo de uma exploração em andamento */
+typedef struct Sessao {
+    SessaoMotor base;                 // sala atual (primeiro membro: os ganchos recebem &base)
+    ConjuntoPistas coletadas;         // pistas desta sessão (palavras de quem criou a sessão)
+    uint8_t fase;                     // SES_*
+} Sessao;
+
+/* sessaoSala - sala onde o jogador da sessão está */
+static inline const Sala *sessaoSala(const Sessao *s) { return s->base.atual; }
+
+/* ses_coletar - gancho aoColetar: marca a pista no conjunto da sessão */
+static void ses_coletar(SessaoMotor *base, const EventoMotor *e) {
+    Sessao *s = (Sessao *)base;
+    const Sala *sala = e->sala;
+    if (sala->pistaId >= 0 && (size_t)sala->pistaId < s->coletadas.nPalavras * 64)
+        conjInserir(&s->coletadas, (size_t)sala->pistaId);
+}
+
+/*
+ * ses_teletransportar - gancho comandoExtra, comando "t <nome da sala> [#k]":
+ * vai direto para a sala pelo índice de nomes do catálogo e coleta a pista
+ * dela. Com homônimos, "#k" escolhe o k-ésimo em pré-ordem; sem ele a sessão
+ * não se move e devolve EV_SALA_AMBIGUA. A sala de destino já tem a cadeia
+ * de 'pai' até o Hall, então "voltar" segue o caminho do mapa a partir dela.
+ */
+static size_t ses_teletransportar(SessaoMotor *s, const char *entrada, EventoMotor *ev) {
+    const Catalogo *cat = ((const Mundo *)s->motor)->cat;
+    if (tolower((unsigned char)entrada[0]) != 't') return 0;
+    char nome[SESSAO_MAX_NOME];
+    const char *ini = entrada + 1;     // depois do 't'
+    while (isspace((unsigned char)*ini)) ++ini;
+    size_t n = strlen(ini);
+    while (n && isspace((unsigned char)ini[n - 1])) --n;
+    unsigned long k = 0;               // homônimo pedido (0 = nenhum)
+    const char *cerquilha = memchr(ini, '#', n);
+    if (cerquilha) {
+        char *fim;
+        k = strtoul(cerquilha + 1, &fim, 10);
+        n = fim == cerquilha + 1 || fim != ini + n || k == 0 ? 0 : (size_t)(cerquilha - ini); // "#" sem número válido: nenhuma sala
+        while (n && isspace((unsigned char)ini[n - 1])) --n;
+    }
+    long id = -1;
+    if (n && n < sizeof(nome)) {       // nomes maiores que o buffer não existem no mapa
+        memcpy(nome, ini, n);
+        nome[n] = '\0';
+        id = buscarSalaId(cat, nome);
+    }
+    if (id >= 0 && k == 0 && cat->mesmoNome[id] != UINT32_MAX) { // homônimos e nenhum escolhido
+        uint32_t q = 0;
+        for (uint32_t i = (uint32_t)id; i != UINT32_MAX; i = cat->mesmoNome[i]) ++q;
+        ev[0] = (EventoSessao){ .tipo = EV_SALA_AMBIGUA, .cmd = 't', .valor = q, .sala = cat->salas[id] };
+        return 1;
+    }
+    for (; id >= 0 && k > 1; --k)      // k-ésimo homônimo
+        id = cat->mesmoNome[id] == UINT32_MAX ? -1 : (long)cat->mesmoNome[id];
+    if (id < 0) {
+        ev[0] = (EventoSessao){ .tipo = EV_SALA_DESCONHECIDA, .cmd = 't' };
+        return 1;
+    }
+    return motorEntrar(s, cat->salas[id], 't', ev);
+}
+
+/*
+ * mundoCriar - junta mapa, tabela hash e catálogo num Mundo. Sem catálogo
+ * não há 't' (o comando fica inválido) nem acusação reconhecida.
+ */
+Mundo mundoCriar(const Sala *mapa, HashTable *ht, const Catalogo *cat) {
+    return (Mundo){ { &MAPA_ARVORE, mapa, NULL, &ASSOC_ENCADEADA, ht, cat ? ses_teletransportar : NULL, ses_coletar },
+                    cat };
+}
+
+/* definida na verificação final; julga as sessões de mundos com coleção do motor */
+int verificarSuspeitoFinal(const ColecaoOps *ops, const void *pistas, HashTable *ht, const char *acusado);
+
+/*
+ * sessaoIniciar - prepara 's' no Hall de entrada do mundo 'm'. 'coletadas'
+ * guarda as pistas (pode ser NULL: a sessão só explora, ou o mundo tem uma
+ * coleção do motor, que a sessão cria e sessaoEncerrar libera). Devolve em
+ * 'ev' os eventos da chegada (início e a pista do Hall, se houver).
+ */
+size_t sessaoIniciar(Sessao *s, const Mundo *m, ConjuntoPistas *coletadas, EventoSessao ev[SESSAO_MAX_EVENTOS]) {
+    s->coletadas = coletadas ? *coletadas : (ConjuntoPistas){ NULL, 0 };
+    s->fase = SES_EXPLORANDO;
+    return motorIniciar(&s->base, &m->motor, ev);
+}
+
+/*
+ * sessaoAlimentar - aplica uma entrada à sessão e devolve quantos eventos
+ * foram escritos em 'ev'. Explorando, a entrada vai para o motor (e/d/v/s,
+ * maiúsculo ou minúsculo, ou "t <sala>" com catálogo no mundo); depois de
+ * 's', a entrada inteira é o nome do acusado. Sessões encerradas não reagem.
+ */
+size_t sessaoAlimentar(Sessao *s, const Mundo *m, const char *entrada, EventoSessao ev[SESSAO_MAX_EVENTOS]) {
+    if (s->fase == SES_ENCERRADA) return 0;
+    if (s->fase == SES_ACUSANDO) {
+        s->fase = SES_ENCERRADA;
+        int sid = m->cat ? buscarSuspeitoId(m->cat, entrada) : -1; // o veredito compara IDs
+        const char *acusado = sid >= 0 ? m->cat->suspeitos[sid] : NULL;
+        int procedente = m->motor.colecaoOps // com coleção do motor, as pistas estão nela
+                         ? acusado && verificarSuspeitoFinal(m->motor.colecaoOps, s->base.pistas, m->motor.assoc, acusado)
+                         : evidenciasContra(m->cat, &s->coletadas, sid) >= 2;
+        ev[0] = (EventoSessao){ .tipo = EV_VEREDITO, .valor = (uint32_t)procedente, .suspeito = acusado };
+        return 1;
+    }
+    size_t n = motorComando(&s->base, entrada, ev);
+    if (s->base.encerrada) s->fase = SES_ACUSANDO;
+    return n;
+}
+
+/* sessaoEncerrar - libera a coleção do motor da sessão, se houver (na BST, os nós voltam ao pool) */
+void sessaoEncerrar(Sessao *s) {
+    motorEncerrar(&s->base);
+}
+
+/* ---------- Exploração: coleta de pistas (atualizada para mostrar suspeitos) ---------- */
+
+/* exp_mostrarSugestoes - acusação sem suspeito reconhecido: oferece os nomes mais parecidos */
+static void exp_mostrarSugestoes(const Catalogo *cat, const char *acusacao) {
+    char sugestoes[256];
+    if (sugerirSuspeitos(cat, acusacao, sugestoes, sizeof(sugestoes)))
+        printf("Nenhum suspeito com esse nome. Você quis dizer: %s?\n", sugestoes);
+    else
+        printf("Nenhum suspeito com esse nome.\n");
+}
+
+/* exp_imprimirPista - visitante da coleção do motor: uma linha por pista, como exibirPistasConjunto */
+static void exp_imprimirPista(const char *texto, void *ctx) {
+    (void)ctx;
+    printf(" - %s\n", texto);
+}
+
+/* ExploracaoInterativa - Sessao do jogo interativo, com o diário do menu */
+typedef struct ExploracaoInterativa {
+    Sessao sessao;                    // primeiro membro: os ganchos do motor recebem &sessao.base
+    Diario *diario;                   // movimentos, coletas e consultas (pode ser NULL)
+} ExploracaoInterativa;
+
+/*
+ * exp_completarComando - 't': o nome da sala é o resto da linha ("t Torre de
+ * vigia"); com o 't' sozinho, ele é pedido numa linha própria
+ */
+static void exp_completarComando(const SessaoMotor *base, char *entrada, size_t cap) {
+    (void)base;
+    if (entrada[0] != 't' && entrada[0] != 'T') return;
+    const char *resto = entradaRestoDaLinha();
+    while (isspace((unsigned char)*resto)) ++resto;
+    entrada[1] = ' ';
+    if (*resto) {
+        snprintf(entrada + 2, cap - 2, "%s", resto);
+        return;
+    }
+    printf("Nome da sala (acrescente #k para escolher entre homônimos): ");
+    if (!lerLinha(entrada + 2, cap - 2)) entrada[2] = '\0';
+}
+
+/*
+ * exp_mostrarEvento - gancho mostrarEvento do jogo interativo: registra
+ * movimentos, coletas e consultas no diário (aqui, e não em exp_coletar,
+ * para os registros saírem na ordem dos eventos) e mostra o que o motor não
+ * conhece (teletransporte, salas do 't' e a lista de comandos com o 't').
+ * O resto fica com o texto padrão do motor.
+ */
+#define EXP_HOMONIMOS 10               // homônimos listados quando o nome é ambíguo
+static int exp_mostrarEvento(const SessaoMotor *base, const EventoMotor *e) {
+    const ExploracaoInterativa *x = (const ExploracaoInterativa *)base;
+    const Catalogo *cat = ((const Mundo *)base->motor)->cat;
+    const Sala *sala = e->sala;
+    char caminho[512];
+    switch (e->tipo) {
+    case EV_MOVEU:
+        diarioMover(x->diario, sala->id, e->cmd);
+        if (e->cmd != 't') return 0;   // teletransporte: mostra por onde "voltar" vai levar
+        printf("\n-- Teletransporte para %s --\n", salaNome(sala));
+        printf("Caminho: %s\n\n", formatarCaminho(sala, caminho, sizeof(caminho)));
+        return 1;
+    case EV_PISTA:
+        diarioPista(x->diario, sala->pistaId);
+        diarioConsulta(x->diario, sala->pistaId, e->suspeito != NULL);
+        return 0;
+    case EV_INVALIDO:
+        printf("Opção inválida. Use 'e', 'd', 'v', 't' ou 's'.\n\n"); // entrada inválida
+        return 1;
+    case EV_SALA_DESCONHECIDA:
+        printf("Nenhuma sala com esse nome.\n\n");
+        return 1;
+    case EV_SALA_AMBIGUA: {            // lista os homônimos para o jogador escolher com #k
+        printf("Há %u salas com esse nome; escolha uma com \"#k\" depois do nome:\n", e->valor);
+        uint32_t id = (uint32_t)sala->id;
+        for (uint32_t k = 1; id != UINT32_MAX && k <= EXP_HOMONIMOS; ++k, id = cat->mesmoNome[id])
+            printf("  #%u  %s\n", k, formatarCaminho(cat->salas[id], caminho, sizeof(caminho)));
+        if (e->valor > EXP_HOMONIMOS) printf("  ... e mais %u\n", e->valor - EXP_HOMONIMOS);
+        printf("\n");
+        return 1;
+    }
+    }
+    return 0;
+}
+
+/*
+ * explorarSalasComPistas - permite a navegação do jogador pela árvore a partir da raiz.
+ * Quando o jogador entra em uma sala que contém pista, a pista é marcada no conjunto
+ * (ou inserida na coleção do motor, se houver uma) e o suspeito associado (se houver)
+ * é mostrado imediatamente utilizando a tabela hash passada como parâmetro.
+ * O laço é o explorarMotor, comum aos três níveis; o Mestre entra só com os
+ * textos e os ganchos (exp_*).
+ *
+ * Comandos:
+ *   e - esquerda
+ *   d - direita
+ *   v - voltar (pai)
+ *   t - ir direto para uma sala pelo nome (pede o nome; só com catálogo)
+ *   s - encerrar exploração atual
+ *
+ * Parâmetros:
+ *   raiz     - raiz do mapa (Sala*)
+ *   colecao  - coleção do motor que recebe as pistas (COLECAO_BST, COLECAO_AVL), ou NULL.
+ *   pistas   - recebe a coleção da exploração quando 'colecao' não é NULL; o chamador
+ *             a libera com colecao->liberar (na BST, os nós voltam ao pool).
+ *   coletadas - conjunto em bitset que recebe as pistas (pode ser NULL).
+ *   diario   - diário de eventos que recebe movimentos, coletas e consultas (pode ser NULL).
+ *   ht       - tabela hash (pista -> suspeito) usada para mostrar associação imediatamente.
+ *   cat      - catálogo do mapa, com o índice de nomes do 't' (pode ser NULL: sem teletransporte).
+ */
+void explorarSalasComPistas(Sala *raiz, const ColecaoOps *colecao, void **pistas, ConjuntoPistas *coletadas,
+                            HashTable *ht, Diario *diario, const Catalogo *cat) { // inicia sessão de exploração com coleta de pistas
+    static const TextosExploracao TEXTOS_MESTRE = {
+        "Iniciando exploração da mansão (coleta de pistas)",      // cabeçalho da exploração
+        "Encerrar exploração atual e mostrar pistas coletadas",   // descrição da opção (s)
+        "Encerrando exploração e compilando pistas...",           // mensagem ao escolher 's'
+        NULL, NULL, NULL, exp_mostrarEvento
+    };
+    static const TextosExploracao TEXTOS_MESTRE_T = {           // com catálogo: o 't' entra no menu
+        "Iniciando exploração da mansão (coleta de pistas)",
+        "Encerrar exploração atual e mostrar pistas coletadas",
+        "Encerrando exploração e compilando pistas...",
+        "  (t) Ir direto para uma sala pelo nome\n",
+        "Escolha (e/d/v/t/s): ",
+        exp_completarComando, exp_mostrarEvento
+    };
+    Mundo mundo = mundoCriar(raiz, ht, cat); // a acusação é feita pelo menu; o catálogo serve ao 't'
+    mundo.motor.colecaoOps = colecao;
+    ExploracaoInterativa x = { .diario = diario };
+    x.sessao.coletadas = coletadas ? *coletadas : (ConjuntoPistas){ NULL, 0 };
+    x.sessao.fase = SES_EXPLORANDO;
+    explorarMotor(&x.sessao.base, &mundo.motor, cat ? &TEXTOS_MESTRE_T : &TEXTOS_MESTRE);
+    if (pistas) *pistas = x.sessao.base.pistas;
+    else motorEncerrar(&x.sessao.base);
+}
+
+/* ---------- Mapa em grafo (salas com N portas, em formato CSR) ---------- */
+
+/*
+ * MapaGrafo - mapa geral: cada sala pode ter qualquer número de portas, e
+ * as portas podem levar de volta a salas anteriores (ciclos). A adjacência
+ * fica em CSR (compressed sparse row): as portas da sala s ocupam as
+ * posições [inicio[s], inicio[s+1]) dos vetores 'destino' e 'rotulo', de
+ * modo que percorrer as saídas de uma sala é ler um trecho contíguo.
+ * A árvore de Sala continua sendo o mapa do jogo normal; grafoDaArvore
+ * converte-a para este formato (portas 'esquerda', 'direita' e 'voltar').
+ */
+typedef struct MapaGrafo {
+    uint32_t nSalas;          // quantidade de salas (IDs 0..nSalas-1)
+    uint64_t nPortas;         // quantidade de portas (arestas dirigidas)
+    uint64_t *inicio;         // nSalas+1 deslocamentos no vetor de portas
+    uint32_t *destino;        // sala de destino de cada porta
+    uint8_t *rotulo;          // rótulo de cada porta (índice em 'rotulos')
+    const char **rotulos;     // textos dos rótulos ("esquerda", "porta secreta", ...)
+    uint32_t nRotulos;        // quantidade de rótulos
+    const char **nomes;       // nome de cada sala (textos pertencem a quem montou o grafo)
+    int32_t *pistaId;         // pista de cada sala no catálogo (-1 se não houver)
+} MapaGrafo;
+
+/* Porta - aresta de entrada para grafoCriar */
+typedef struct Porta {
+    uint32_t origem, destino; // salas ligadas pela porta (sentido origem -> destino)
+    uint8_t rotulo;           // índice do rótulo
+} Porta;
+
+/*
+ * grafoCriar - monta o CSR a partir de uma lista de portas em qualquer ordem
+ * (contagem por origem + soma de prefixos + distribuição: O(salas + portas)).
+ * 'nomes' e 'pistaId' (nSalas posições) e 'rotulos' são copiados como ponteiros.
+ */
+MapaGrafo *grafoCriar(uint32_t nSalas, const Porta *portas, uint64_t nPortas,
+                      const char **nomes, const int32_t *pistaId, const char **rotulos, uint32_t nRotulos) {
+    MapaGrafo *g = calloc(1, sizeof(MapaGrafo));
+    if (!g) { fprintf(stderr, "Erro: memória insuficiente ao criar grafo.\n"); exit(EXIT_FAILURE); }
+    g->nSalas = nSalas;
+    g->nPortas = nPortas;
+    g->inicio = calloc((size_t)nSalas + 1, sizeof(uint64_t));
+    g->destino = malloc((nPortas ? nPortas : 1) * sizeof(uint32_t));
+    g->rotulo = malloc(nPortas ? nPortas : 1);
+    g->nomes = malloc((nSalas ? nSalas : 1) * sizeof(char *));
+    g->pistaId = malloc((nSalas ? nSalas : 1) * sizeof(int32_t));
+    g->rotulos = rotulos;
+    g->nRotulos = nRotulos;
+    if (!g->inicio || !g->destino || !g->rotulo || !g->nomes || !g->pistaId) {
+        fprintf(stderr, "Erro: memória insuficiente ao criar grafo.\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(g->nomes, nomes, (size_t)nSalas * sizeof(char *));
+    memcpy(g->pistaId, pistaId, (size_t)nSalas * sizeof(int32_t));
+
+    for (uint64_t i = 0; i < nPortas; ++i) g->inicio[portas[i].origem + 1]++; // grau de saída
+    for (uint32_t s = 0; s < nSalas; ++s) g->inicio[s + 1] += g->inicio[s];     // soma de prefixos
+    uint64_t *pos = malloc(((size_t)nSalas + 1) * sizeof(uint64_t)); // próxima posição livre por sala
+    if (!pos) { fprintf(stderr, "Erro: memória insuficiente ao criar grafo.\n"); exit(EXIT_FAILURE); }
+    memcpy(pos, g->inicio, ((size_t)nSalas + 1) * sizeof(uint64_t));
+    for (uint64_t i = 0; i < nPortas; ++i) {  // distribuição estável (mantém a ordem das portas)
+        uint64_t k = pos[portas[i].origem]++;
+        g->destino[k] = portas[i].destino;
+        g->rotulo[k] = portas[i].rotulo;
+    }
+    free(pos);
+    return g;
+}
+
+/* liberarGrafo - libera o grafo (nomes e rótulos pertencem a quem os forneceu) */
+void liberarGrafo(MapaGrafo *g) {
+    if (!g) return;
+    free(g->inicio);
+    free(g->destino);
+    free(g->rotulo);
+    free(g->nomes);
+    free(g->pistaId);
+    free(g);
+}
+
+static const char *ROTULOS_ARVORE[] = { "esquerda", "direita", "voltar" };
+
+/* grafoDaArvore - converte o mapa em árvore (já numerado pelo catálogo) para CSR */
+MapaGrafo *grafoDaArvore(const Catalogo *cat) {
+    uint32_t n = (uint32_t)cat->nSalas;
+    Porta *portas = malloc((3 * (size_t)n + 1) * sizeof(Porta));
+    const char **nomes = malloc((n ? n : 1) * sizeof(char *));
+    int32_t *pistas = malloc((n ? n : 1) * sizeof(int32_t));
+    if (!portas || !nomes || !pistas) { fprintf(stderr, "Erro: memória insuficiente ao criar grafo.\n"); exit(EXIT_FAILURE); }
+    uint64_t np = 0;
+    for (uint32_t i = 0; i < n; ++i) {
+        const Sala *s = cat->salas[i];
+        nomes[i] = salaNome(s);
+        pistas[i] = s->pistaId;
+        if (s->esq) portas[np++] = (Porta){ i, (uint32_t)s->esq->id, 0 };
+        if (s->dir) portas[np++] = (Porta){ i, (uint32_t)s->dir->id, 1 };
+        if (s->pai) portas[np++] = (Porta){ i, (uint32_t)s->pai->id, 2 };
+    }
+    MapaGrafo *g = grafoCriar(n, portas, np, nomes, pistas, ROTULOS_ARVORE, 3);
+    free(portas);
+    free(nomes);
+    free(pistas);
+    return g;
+}
+
+/*
+ * grafoColetarAlcancaveis - busca em largura a partir de 'origem' marcando
+ * as salas em 'visitadas' (cada sala entra uma vez, mesmo com ciclos) e
+ * ligando em 'pistas' a pista de cada sala alcançada. Retorna as salas novas.
+ */
+uint64_t grafoColetarAlcancaveis(const MapaGrafo *g, uint32_t origem, ConjuntoPistas *visitadas, ConjuntoPistas *pistas) {
+    uint32_t *fila = malloc(((size_t)g->nSalas ? g->nSalas : 1) * sizeof(uint32_t));
+    if (!fila) { fprintf(stderr, "Erro: memória insuficiente na busca.\n"); exit(EXIT_FAILURE); }
+    uint64_t ini = 0, fim = 0;
+    if (conjInserir(visitadas, origem)) fila[fim++] = origem;
+    while (ini < fim) {
+        uint32_t s = fila[ini++];
+        if (g->pistaId[s] >= 0) conjInserir(pistas, (size_t)g->pistaId[s]);
+        for (uint64_t k = g->inicio[s]; k < g->inicio[s + 1]; ++k) { // portas contíguas
+            uint32_t d = g->destino[k];
+            if (conjInserir(visitadas, d)) fila[fim++] = d;
+        }
+    }
+    free(fila);
+    return fim;
+}
+
+#define GRAFO_LINHA 4096               // maior linha de comandos da exploração em grafo
+
+/*
+ * grafo_lerToken - próximo comando da exploração em grafo: uma palavra da
+ * linha em 'linha' a partir de *cursor, lendo outra linha quando ela acaba.
+ * Ao contrário de get_choice, o número de uma porta vem inteiro ("12" é a
+ * porta 12, e "1 2" são duas portas). NULL no fim da entrada ou numa linha
+ * em branco.
+ */
+static char *grafo_lerToken(char *linha, size_t cap, char **cursor) {
+    char *p = *cursor;
+    while (p && isspace((unsigned char)*p)) ++p;
+    if (!p || !*p) {                   // linha esgotada: lê a próxima
+        *cursor = NULL;
+        if (!lerLinha(linha, cap)) return NULL;
+        for (p = linha; isspace((unsigned char)*p); ++p) {}
+        if (!*p) return NULL;          // linha em branco
+    }
+    char *ini = p;
+    while (*p && !isspace((unsigned char)*p)) ++p;
+    if (*p) *p++ = '\0';
+    *cursor = p;
+    return ini;
+}
+
+/* grafo_temTokens - ainda há comandos na linha lida? (a sala só é redesenhada com a linha esgotada) */
+static int grafo_temTokens(const char *cursor) {
+    while (cursor && isspace((unsigned char)*cursor)) ++cursor;
+    return cursor && *cursor;
+}
+
+/*
+ * explorarGrafo - exploração interativa no mapa em grafo. As portas da sala
+ * atual são numeradas (1, 2, ...); 's' encerra. Salas já visitadas são
+ * marcadas e suas pistas não são coletadas de novo, mesmo em ciclos.
+ * Uma linha pode trazer várias escolhas separadas por espaço ("3 12 1").
+ */
+void explorarGrafo(const MapaGrafo *g, HashTable *ht, ConjuntoPistas *coletadas, const Catalogo *cat) {
+    if (!g->nSalas) {
+        printf("Mapa vazio. Nada a explorar.\n");
+        return;
+    }
+    ConjuntoPistas *visitadas = conjCriar(g->nSalas); // salas já visitadas nesta exploração
+    uint32_t atual = 0;
+    char linha[GRAFO_LINHA], *cursor = NULL; // linha de comandos e o que falta dela
+    printf("\n--- Iniciando exploração da mansão (mapa em grafo) ---\n");
+    while (1) {
+        if (conjInserir(visitadas, atual) && g->pistaId[atual] >= 0) { // primeira visita: coleta a pista
+            int pid = g->pistaId[atual];
+            conjInserir(coletadas, (size_t)pid);
+            const char *texto = cat->pistas[pid];
+            const char *sus = encontrarSuspeito(ht, texto);
+            printf("[Pista encontrada] %s\n", texto);
+            if (sus) printf("  -> Esta pista aponta para: %s\n\n", sus);
+            else printf("  -> Nenhum suspeito associado a esta pista (desconhecido)\n\n");
+        }
+        if (!grafo_temTokens(cursor)) {
+            printf("Você está na sala: %s\n", g->nomes[atual]);
+            printf("Portas:\n");
+            uint64_t n = 0;
+            for (uint64_t k = g->inicio[atual]; k < g->inicio[atual + 1]; ++k, ++n)
+                printf("  (%llu) %s -> %s%s\n", (unsigned long long)n + 1, g->rotulos[g->rotulo[k]],
+                       g->nomes[g->destino[k]], conjContem(visitadas, g->destino[k]) ? " (já visitada)" : "");
+            printf("  (s) Encerrar exploração\n");
+            printf("Escolha: ");
+        }
+        const char *tok = grafo_lerToken(linha, sizeof(linha), &cursor);
+        if (!tok || strcmp(tok, "s") == 0 || strcmp(tok, "S") == 0) {
+            printf("\nEncerrando exploração.\n\n"); // o resto da linha não vale para o menu
+            break;
+        }
+        uint64_t grau = g->inicio[atual + 1] - g->inicio[atual];
+        char *fim;
+        unsigned long porta = isdigit((unsigned char)tok[0]) ? strtoul(tok, &fim, 10) : 0;
+        if (porta >= 1 && porta <= grau && *fim == '\0') { // porta escolhida pelo número (token inteiro)
+            uint64_t k = g->inicio[atual] + (porta - 1);
+            printf("\n-- Porta '%s'... --\n\n", g->rotulos[g->rotulo[k]]);
+            atual = g->destino[k];
+        } else {
+            printf("Opção inválida. Use o número de uma porta ou 's'.\n\n");
+        }
+    }
+    printf("Salas visitadas: %zu de %u; pistas coletadas: %zu\n", conjContar(visitadas), g->nSalas, conjContar(coletadas));
+    conjLiberar(visitadas);
+}
+
+/* ---------- Mapa da mansão (com pistas) ---------- */
+
+/*
+ * montarMapaComPistas - cria e retorna o mapa fixo da mansão (árvore binária),
+ * com pistas associadas a algumas salas.
+ */
+Sala *montarMapaComPistas(void) {     // monta a árvore do mapa com pistas em algumas salas
+    // criar nós com nome e pista (pista = NULL se não houver)
+    Sala *hall = criarSala("Hall de entrada", "Uma luva de couro com sangue seco"); // raiz com pista
+
+    Sala *salaEstar = criarSala("Sala de estar", "Vidro quebrado perto do lareira"); // nó com pista
+    Sala *biblioteca = criarSala("Biblioteca", NULL); // sem pista
+
+    Sala *cozinha = criarSala("Cozinha", "Pegadas molhadas levando à despensa"); // nó com pista
+    Sala *salaJantar = criarSala("Sala de jantar", "Uma vela apagada com cera vermelha"); // nó com pista
+
+    Sala *escritorio = criarSala("Escritório", "Um bilhete amassado com iniciais 'R.M.'"); // pista
+    Sala *observatorio = criarSala("Observatório", "Lentes riscada e uma gota de óleo"); // pista
+
+    Sala *despensa = criarSala("Despensa", "Caixa vazia de comprimidos"); // folha com pista
+    Sala *jardimInterno = criarSala("Jardim interno", NULL); // sem pista
+    Sala *torre = criarSala("Torre de vigia", "Pegada solitária no corrimão"); // folha com pista
+
+    // conectar árvore e ajustar ponteiros 'pai'
+    conectarFilhos(hall, salaEstar, biblioteca);       // hall -> (salaEstar, biblioteca)
+    conectarFilhos(salaEstar, cozinha, salaJantar);    // salaEstar -> (cozinha, salaJantar)
+    conectarFilhos(biblioteca, escritorio, observatorio); // biblioteca -> (escritorio, observatorio)
+    conectarFilhos(cozinha, despensa, jardimInterno); // cozinha -> (despensa, jardimInterno)
+    conectarFilhos(observatorio, NULL, torre);         // observatorio -> (NULL, torre)
+
+    return hall;                                      // retorna a raiz do mapa montado
+}
+
+/*
+ * montarAssociacoes - cria a tabela hash e registra as associações
+ * conhecidas (chave = texto da pista, valor = suspeito).
+ */
+HashTable *montarAssociacoes(void) {
+    HashTable *ht = criarHashTable(97); // cria tabela hash com 97 buckets (primo razoável para demo)
+    inserirNaHash(ht, "Uma luva de couro com sangue seco", "Sr. Andrade");
+    inserirNaHash(ht, "Vidro quebrado perto do lareira", "Sra. Monteiro");
+    inserirNaHash(ht, "Pegadas molhadas levando à despensa", "Sr. Andrade");
+    inserirNaHash(ht, "Uma vela apagada com cera vermelha", "Sra. Monteiro");
+    inserirNaHash(ht, "Um bilhete amassado com iniciais 'R.M.'", "R. Martins");
+    inserirNaHash(ht, "Lentes riscada e uma gota de óleo", "Dr. Silva");
+    inserirNaHash(ht, "Caixa vazia de comprimidos", "Dr. Silva");
+    inserirNaHash(ht, "Pegada solitária no corrimão", "R. Martins");
+    return ht;
+}
+
+/* ---------- Verificação final: acusação e julgamento (mantida) ---------- */
+
+/* ContagemAcusado - estado do percurso de verificarSuspeitoFinal */
+typedef struct ContagemAcusado {
+    HashTable *ht;                     // pista -> suspeito
+    const char *acusado;               // nome comparado com o suspeito de cada pista
+    int contador;                      // pistas que apontam para o acusado
+} ContagemAcusado;
+
+/* ver_contar - visitante de verificarSuspeitoFinal: conta a pista se ela aponta para o acusado */
+static void ver_contar(const char *texto, void *ctx) {
+    ContagemAcusado *c = ctx;
+    const char *s = encontrarSuspeito(c->ht, texto); // consulta suspeito associado à pista
+    if (s && strcmp(s, c->acusado) == 0) c->contador++;
+}
+
+/*
+ * verificarSuspeitoFinal - dada a coleção de pistas coletadas ('ops' diz se é
+ * BST ou AVL) e a tabela hash (pista -> suspeito), conta quantas pistas
+ * apontam para o suspeito acusado.
+ * Retorna 1 se existirem pelo menos 2 pistas que apontam para o acusado, 0 caso contrário.
+ */
+int verificarSuspeitoFinal(const ColecaoOps *ops, const void *pistas, HashTable *ht, const char *acusado) {
+    if (!acusado || !pistas) return 0; // proteção: acusado ou coleção inválidos
+    ContagemAcusado c = { ht, acusado, 0 };
+    ops->emOrdem(pistas, ver_contar, &c); // percorre a coleção em ordem alfabética
+    return (c.contador >= 2) ? 1 : 0;  // retorna verdadeiro se houver ao menos duas pistas
+}
+
+/*
+ * verificarSuspeitoFinalBits - mesma regra de verificarSuspeitoFinal (pelo menos
+ * 2 pistas contra o acusado), mas sobre o conjunto em bitset: uma busca do ID
+ * do suspeito e um AND + popcount contra a máscara pré-calculada.
+ */
+int verificarSuspeitoFinalBits(const Catalogo *cat, const ConjuntoPistas *coletadas, const char *acusado) {
+    if (!acusado) return 0;            // proteção: acusado inválido
+    int sid = buscarSuspeitoId(cat, acusado); // nome desconhecido -> nenhuma evidência
+    return evidenciasContra(cat, coletadas, sid) >= 2 ? 1 : 0;
+}
+
+/* ---------- Montagem paralela do mapa (lista de salas e arenas por thread) ---------- */
+
+/*
+ * Mundos muito grandes (milhões de salas) não são montados sala a sala: as
+ * linhas "sala" do arquivo primeiro viram uma ListaSalas, e montarMapaParalelo
+ * monta a árvore a partir dela. As salas são separadas pelos 'corte' primeiros
+ * passos do caminho; cada grupo é uma subárvore independente, montada por uma
+ * thread dentro da arena dela (ver ArenaSalas), e no fim a thread principal
+ * monta as poucas salas acima do corte e pendura nelas as raízes dos grupos.
+ * Liberar o mapa é liberar as arenas: um free por bloco, sem visitar salas.
+ * Um mapa degenerado (tudo no mesmo ramo) cai num grupo só e não acelera.
+ */
+#define LISTA_SEM_PISTA        SIZE_MAX // SalaListada.pista de sala sem pista
+#define MONT_THREADS_MAX       64      // threads de montagem (e arenas) no máximo
+#define MONT_GRUPOS_POR_THREAD 8       // grupos por thread: sobra para equilibrar a carga
+#define MONT_CORTE_MAX         20      // profundidade máxima das raízes dos grupos
+#define MONT_MIN_PARALELO      (1u << 16) // abaixo disso carregarMundo monta com uma thread só
 
-/* Nó da árvore BST que guarda as pistas coletadas */
-typedef struct NoPista {      // início da definição do nó da BST de pistas
-    char *texto;              // texto da pista (alocado dinamicamente)
-    struct NoPista *esq;      // filho esquerdo (itens "menores" alfabeticamente)
-    struct NoPista *dir;      // filho direito (itens "maiores" alfabeticamente)
-} NoPista;                    // typedef para usar 'NoPista' diretamente
+/* SalaListada - uma linha "sala" já validada; os textos ficam em ListaSalas.textos */
+typedef struct SalaListada {
+    size_t rota, nome, pista;         // deslocamentos em 'textos' (pista: LISTA_SEM_PISTA)
+    size_t tamRota;                   // passos do caminho (0 = Hall de entrada)
+    unsigned long linha;              // linha do arquivo (mensagens de erro)
+} SalaListada;
 
-/* Nó para lista encadeada usada na tabela hash (encadeamento separado) */
-typedef struct HashNode {     // nó que guarda par chave/valor na tabela hash
-    char *chave;              // chave = texto da pista (alocado dinamicamente)
-    char *suspeito;           // valor = nome do suspeito associado à pista
-    struct HashNode *prox;    // ponteiro para o próximo nó na lista (encadeamento)
-} HashNode;
+/* ListaSalas - salas na ordem do arquivo, antes de virarem árvore */
+typedef struct ListaSalas {
+    SalaListada *v;
+    size_t n, cap;
+    char *textos;                     // caminhos, nomes e pistas terminados em '\0'
+    size_t tamTextos, capTextos;
+} ListaSalas;
 
-/* Estrutura da tabela hash (vetor de ponteiros para HashNode) */
-typedef struct HashTable {    // wrapper da tabela hash
-    HashNode **buckets;       // vetor de buckets (cada bucket é lista encadeada)
-    size_t tamanho;           // número de buckets no vetor
-} HashTable;
+/* ArenasMapa - as arenas de um mapa montado por montarMapaParalelo */
+typedef struct ArenasMapa {
+    ArenaSalas *v;
+    unsigned n;
+} ArenasMapa;
 
-/* ---------- Funções utilitárias ---------- */
+/* MedidasMontagem - nanossegundos de cada fase de montarMapaParalelo (medições) */
+typedef struct MedidasMontagem {
+    unsigned long long particao, grupos, ligacao;
+} MedidasMontagem;
 
-/* duplicar string (substitui strdup para portabilidade) */
-static char *str_dup(const char *s) {   // função estática que duplica uma string
-    if (!s) return NULL;               // se o argumento for NULL, retorna NULL (proteção)
-    size_t n = strlen(s) + 1;          // tamanho necessário incluindo caractere nulo '\0'
-    char *r = malloc(n);               // aloca memória para a cópia
-    if (!r) {                          // se malloc falhar...
-        fprintf(stderr, "Erro: memória insuficiente ao duplicar string.\n"); // informa erro
-        exit(EXIT_FAILURE);            // encerra o programa com código de erro
+/* lista_texto - copia 't' (com o '\0') para o fim de l->textos e devolve o deslocamento */
+static size_t lista_texto(ListaSalas *l, const char *t) {
+    size_t tam = strlen(t) + 1;
+    if (l->tamTextos + tam > l->capTextos) {
+        size_t cap = l->capTextos ? 2 * l->capTextos : 4096;
+        while (cap < l->tamTextos + tam) cap *= 2;
+        char *novo = realloc(l->textos, cap);
+        if (!novo) { fprintf(stderr, "Erro: memória insuficiente na lista de salas.\n"); exit(EXIT_FAILURE); }
+        l->textos = novo;
+        l->capTextos = cap;
     }
-    memcpy(r, s, n);                   // copia os bytes (incluindo '\0') para a nova área
-    return r;                          // retorna o ponteiro para a string duplicada
+    memcpy(l->textos + l->tamTextos, t, tam);
+    l->tamTextos += tam;
+    return l->tamTextos - tam;
 }
 
-/* lê primeira letra não-branca da entrada do usuário; retorna '\0' se falhar */
-char get_choice(void) {                // lê uma linha de stdin e retorna primeiro caractere não branco
-    char buf[128];                     // buffer temporário para a linha de entrada
-    if (!fgets(buf, sizeof(buf), stdin)) return '\0'; // se leitura falhar, retorna '\0'
-    for (size_t i = 0; buf[i] != '\0'; ++i) { // percorre até o fim da string lida
-        if (!isspace((unsigned char)buf[i])) return buf[i]; // retorna o primeiro caractere não branco
+/* listaAcrescentar - guarda uma sala ('rota' "-" = Hall de entrada; 'pista' pode ser NULL) */
+void listaAcrescentar(ListaSalas *l, const char *rota, const char *nome, const char *pista, unsigned long linha) {
+    if (l->n == l->cap) {
+        size_t cap = l->cap ? 2 * l->cap : 64;
+        SalaListada *novo = realloc(l->v, cap * sizeof(SalaListada));
+        if (!novo) { fprintf(stderr, "Erro: memória insuficiente na lista de salas.\n"); exit(EXIT_FAILURE); }
+        l->v = novo;
+        l->cap = cap;
     }
-    return '\0';                       // se só houver espaços, retorna '\0'
+    SalaListada *s = &l->v[l->n++];
+    if (strcmp(rota, "-") == 0) rota = "";
+    s->tamRota = strlen(rota);
+    s->rota = lista_texto(l, rota);
+    s->nome = lista_texto(l, nome);
+    s->pista = pista ? lista_texto(l, pista) : LISTA_SEM_PISTA;
+    s->linha = linha;
 }
 
-/* ---------- Funções para salas (mapa) ---------- */
+/* liberarListaSalas - libera vetor e textos (a lista fica vazia e reutilizável) */
+void liberarListaSalas(ListaSalas *l) {
+    free(l->v);
+    free(l->textos);
+    memset(l, 0, sizeof(*l));
+}
+
+/* liberarArenasMapa - libera o mapa inteiro junto com as arenas */
+void liberarArenasMapa(ArenasMapa *a) {
+    for (unsigned i = 0; i < a->n; ++i) liberarArena(&a->v[i]);
+    free(a->v);
+    a->v = NULL;
+    a->n = 0;
+}
+
+/* Montagem - estado compartilhado pelas threads de montarMapaParalelo */
+typedef struct Montagem {
+    const ListaSalas *lista;
+    unsigned nThreads;
+    size_t corte;                     // profundidade das raízes dos grupos
+    size_t nGrupos;                   // 2^corte grupos, mais um (o último) para as salas acima do corte
+    size_t *posicoes;                 // nThreads x nGrupos: contagem de cada trecho, depois posição de escrita
+    size_t *ordem;                    // índices da lista agrupados, na ordem do arquivo dentro do grupo
+    size_t *inicio;                   // grupo g ocupa ordem[inicio[g] .. inicio[g + 1])
+    Sala **raizes;                    // raiz montada de cada grupo (NULL = vazio ou erro na raiz)
+    size_t *falha;                    // primeira sala com erro em cada grupo (SIZE_MAX = nenhuma)
+    const char **motivo;              // mensagem do erro em falha[g]
+    ArenaSalas *arenas;               // uma por thread
+} Montagem;
+
+enum { MONT_CONTAR, MONT_ESPALHAR, MONT_GRUPOS };
+
+typedef struct TarefaMontagem {
+    Montagem *m;
+    unsigned id;
+    int fase;
+} TarefaMontagem;
+
+/* mont_bits - os 'k' primeiros passos de 'rota' como número ('e' = 0, 'd' = 1, primeiro passo no bit alto) */
+static inline size_t mont_bits(const char *rota, size_t k) {
+    size_t b = 0;
+    for (size_t i = 0; i < k; ++i) b = 2 * b + (rota[i] == 'd');
+    return b;
+}
+
+/* mont_grupo - grupo da sala 'i' da lista */
+static inline size_t mont_grupo(const Montagem *m, size_t i) {
+    const SalaListada *s = &m->lista->v[i];
+    if (s->tamRota < m->corte) return m->nGrupos - 1;
+    return mont_bits(m->lista->textos + s->rota, m->corte);
+}
+
+/* mont_sala - cria a sala 'i' da lista na arena 'a' */
+static Sala *mont_sala(const ListaSalas *l, size_t i, ArenaSalas *a) {
+    const SalaListada *s = &l->v[i];
+    return arenaCriarSala(a, l->textos + s->nome, s->pista == LISTA_SEM_PISTA ? NULL : l->textos + s->pista);
+}
 
 /*
- * criarSala - cria, de forma dinâmica, uma sala com o nome informado e pista opcional.
- * Parâmetros:
- *   nome  - nome da sala (string)
- *   pista - pista associada à sala (string) ou NULL para sem pista
- * Retorno: ponteiro para Sala criada (filhos e pai inicializados em NULL)
+ * mont_montarGrupo - monta a subárvore do grupo 'g' na arena 'a', como a
+ * carga sala a sala faria: a primeira sala do grupo precisa ser a raiz dele,
+ * e cada sala seguinte é pendurada andando a partir dessa raiz. Para no
+ * primeiro erro e o registra em falha[g].
  */
-Sala *criarSala(const char *nome, const char *pista) { // cria uma Sala e inicializa campos
-    Sala *s = malloc(sizeof(Sala));    // aloca memória para a estrutura Sala
-    if (!s) {                          // verifica se alocação ocorreu com sucesso
-        fprintf(stderr, "Erro: memória insuficiente ao criar sala.\n"); // mensagem de erro
-        exit(EXIT_FAILURE);            // encerra o programa se falhar alocação
+static void mont_montarGrupo(Montagem *m, size_t g, ArenaSalas *a) {
+    const ListaSalas *l = m->lista;
+    Sala *raiz = NULL;
+    for (size_t j = m->inicio[g]; j < m->inicio[g + 1]; ++j) {
+        size_t i = m->ordem[j];
+        const SalaListada *s = &l->v[i];
+        const char *rota = l->textos + s->rota, *motivo = NULL;
+        if (!raiz) {
+            if (s->tamRota == m->corte) raiz = mont_sala(l, i, a);
+            else motivo = "sala pai ainda não declarada";
+        } else if (s->tamRota == m->corte) {
+            motivo = "caminho já ocupado";
+        } else {
+            Sala *pai = raiz;
+            for (size_t k = m->corte; pai && k + 1 < s->tamRota; ++k) pai = rota[k] == 'e' ? pai->esq : pai->dir;
+            Sala **vaga = !pai ? NULL : rota[s->tamRota - 1] == 'e' ? &pai->esq : &pai->dir;
+            if (!vaga) motivo = "sala pai ainda não declarada";
+            else if (*vaga) motivo = "caminho já ocupado";
+            else {
+                *vaga = mont_sala(l, i, a);
+                (*vaga)->pai = pai;
+            }
+        }
+        if (motivo) {
+            m->falha[g] = i;
+            m->motivo[g] = motivo;
+            break;
+        }
+    }
+    m->raizes[g] = raiz;
+}
+
+/* mont_thread - uma fase da montagem para a thread t->id (trecho fixo da lista ou grupos alternados) */
+static void *mont_thread(void *arg) {
+    TarefaMontagem *t = arg;
+    Montagem *m = t->m;
+    size_t n = m->lista->n;
+    size_t ini = n * t->id / m->nThreads, fim = n * (t->id + 1) / m->nThreads;
+    size_t *pos = m->posicoes + (size_t)t->id * m->nGrupos;
+    if (t->fase == MONT_CONTAR) {
+        for (size_t i = ini; i < fim; ++i) ++pos[mont_grupo(m, i)];
+    } else if (t->fase == MONT_ESPALHAR) {
+        for (size_t i = ini; i < fim; ++i) m->ordem[pos[mont_grupo(m, i)]++] = i;
+    } else {
+        for (size_t g = t->id; g + 1 < m->nGrupos; g += m->nThreads) mont_montarGrupo(m, g, &m->arenas[t->id]);
+    }
+    return NULL;
+}
+
+/* mont_fase - roda a fase em todas as threads (a principal faz a parte da thread 0) */
+static void mont_fase(Montagem *m, int fase) {
+    pthread_t threads[MONT_THREADS_MAX];
+    TarefaMontagem tarefas[MONT_THREADS_MAX];
+    int criada[MONT_THREADS_MAX] = { 0 };
+    for (unsigned i = 0; i < m->nThreads; ++i) tarefas[i] = (TarefaMontagem){ m, i, fase };
+    for (unsigned i = 1; i < m->nThreads; ++i) {
+        criada[i] = pthread_create(&threads[i], NULL, mont_thread, &tarefas[i]) == 0;
+        if (!criada[i]) mont_thread(&tarefas[i]); // sem thread disponível: faz a parte dela aqui mesmo
     }
-    s->nome = str_dup(nome);           // duplica e armazena o nome da sala
-    s->pista = pista ? str_dup(pista) : NULL; // duplica a pista se fornecida, senão NULL
-    s->esq = NULL;                     // inicializa filho esquerdo como NULL
-    s->dir = NULL;                     // inicializa filho direito como NULL
-    s->pai = NULL;                     // inicializa ponteiro para pai como NULL
-    return s;                          // retorna o ponteiro para a sala criada
+    mont_thread(&tarefas[0]);
+    for (unsigned i = 1; i < m->nThreads; ++i)
+        if (criada[i]) pthread_join(threads[i], NULL);
 }
 
 /*
- * conectarFilhos - conecta filhos a um nó pai e ajusta ponteiros 'pai' dos filhos.
+ * montarMapaParalelo - monta o mapa da lista 'l' com 'nThreads' threads.
+ * Devolve o Hall de entrada, com todas as salas em 'arenas' (liberar com
+ * liberarArenasMapa). Em caso de erro devolve NULL, sem nada alocado, e
+ * põe em *falha a primeira sala da lista (na ordem do arquivo) em que a
+ * carga sala a sala também pararia, com a mensagem em *motivo; lista vazia
+ * devolve NULL com *falha = SIZE_MAX. 'medidas' pode ser NULL.
  */
-void conectarFilhos(Sala *pai, Sala *esq, Sala *dir) { // conecta esq/dir a pai e ajusta 'pai' dos filhos
-    if (!pai) return;                // proteção: se pai for NULL, não faz nada
-    pai->esq = esq;                  // atribui filho esquerdo
-    pai->dir = dir;                  // atribui filho direito
-    if (esq) esq->pai = pai;         // se filho esquerdo existe, define seu ponteiro para o pai
-    if (dir) dir->pai = pai;         // se filho direito existe, define seu ponteiro para o pai
+Sala *montarMapaParalelo(const ListaSalas *l, unsigned nThreads, ArenasMapa *arenas,
+                         size_t *falha, const char **motivo, MedidasMontagem *medidas) {
+    if (nThreads < 1) nThreads = 1;
+    if (nThreads > MONT_THREADS_MAX) nThreads = MONT_THREADS_MAX;
+    arenas->v = NULL;
+    arenas->n = 0;
+    *falha = SIZE_MAX;
+    *motivo = NULL;
+    if (!l->n) return NULL;
+
+    Montagem m = { .lista = l, .nThreads = nThreads, .corte = 1 };
+    while (((size_t)1 << m.corte) < (size_t)MONT_GRUPOS_POR_THREAD * nThreads && m.corte < MONT_CORTE_MAX) ++m.corte;
+    m.nGrupos = ((size_t)1 << m.corte) + 1;
+    size_t nTopo = ((size_t)1 << m.corte) - 1; // salas acima do corte, em heap implícito (filhos de p: 2p+1, 2p+2)
+    m.posicoes = calloc((size_t)nThreads * m.nGrupos, sizeof(size_t));
+    m.ordem = malloc(l->n * sizeof(size_t));
+    m.inicio = malloc((m.nGrupos + 1) * sizeof(size_t));
+    m.raizes = calloc(m.nGrupos, sizeof(Sala *));
+    m.falha = malloc(m.nGrupos * sizeof(size_t));
+    m.motivo = calloc(m.nGrupos, sizeof(const char *));
+    m.arenas = calloc(nThreads, sizeof(ArenaSalas));
+    Sala **topo = calloc(nTopo, sizeof(Sala *));
+    size_t *topoIndice = malloc(nTopo * sizeof(size_t));
+    if (!m.posicoes || !m.ordem || !m.inicio || !m.raizes || !m.falha || !m.motivo || !m.arenas || !topo || !topoIndice) {
+        fprintf(stderr, "Erro: memória insuficiente na montagem do mapa.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t g = 0; g < m.nGrupos; ++g) m.falha[g] = SIZE_MAX;
+
+    // partição estável (ordenação por contagem): cada thread conta e depois espalha o seu trecho da lista
+    unsigned long long t0 = agora_ns();
+    mont_fase(&m, MONT_CONTAR);
+    size_t total = 0;
+    for (size_t g = 0; g < m.nGrupos; ++g) {
+        m.inicio[g] = total;
+        for (unsigned t = 0; t < nThreads; ++t) {
+            size_t *c = &m.posicoes[(size_t)t * m.nGrupos + g];
+            size_t qtd = *c;
+            *c = total;
+            total += qtd;
+        }
+    }
+    m.inicio[m.nGrupos] = total;
+    mont_fase(&m, MONT_ESPALHAR);
+    unsigned long long t1 = agora_ns();
+
+    mont_fase(&m, MONT_GRUPOS);
+    unsigned long long t2 = agora_ns();
+
+    // salas acima do corte (na ordem do arquivo) e ligação das raízes dos grupos
+    size_t erro = SIZE_MAX;
+    const char *erroMotivo = NULL;
+    for (size_t j = m.inicio[m.nGrupos - 1]; j < m.inicio[m.nGrupos]; ++j) {
+        size_t i = m.ordem[j];
+        const SalaListada *s = &l->v[i];
+        size_t bits = mont_bits(l->textos + s->rota, s->tamRota);
+        size_t p = ((size_t)1 << s->tamRota) - 1 + bits;
+        size_t pai = s->tamRota ? ((size_t)1 << (s->tamRota - 1)) - 1 + (bits >> 1) : 0;
+        if (topo[p]) erroMotivo = s->tamRota ? "caminho já ocupado" : "Hall de entrada repetido";
+        else if (s->tamRota && !topo[pai]) erroMotivo = "sala pai ainda não declarada";
+        if (erroMotivo) { erro = i; break; }
+        topo[p] = mont_sala(l, i, &m.arenas[0]);
+        topoIndice[p] = i;
+        if (s->tamRota) {
+            topo[p]->pai = topo[pai];
+            if (bits & 1) topo[pai]->dir = topo[p];
+            else topo[pai]->esq = topo[p];
+        }
+    }
+    for (size_t g = 0; g + 1 < m.nGrupos; ++g) {
+        if (m.falha[g] < erro) { erro = m.falha[g]; erroMotivo = m.motivo[g]; }
+        Sala *raiz = m.raizes[g];
+        if (!raiz) continue;
+        size_t i = m.ordem[m.inicio[g]];
+        size_t pai = ((size_t)1 << (m.corte - 1)) - 1 + (g >> 1);
+        if (!topo[pai] || topoIndice[pai] > i) { // o pai não veio antes da raiz no arquivo
+            if (i < erro) { erro = i; erroMotivo = "sala pai ainda não declarada"; }
+            continue;
+        }
+        raiz->pai = topo[pai];
+        if (g & 1) topo[pai]->dir = raiz;
+        else topo[pai]->esq = raiz;
+    }
+    unsigned long long t3 = agora_ns();
+    if (medidas) *medidas = (MedidasMontagem){ t1 - t0, t2 - t1, t3 - t2 };
+
+    Sala *hall = topo[0];
+    arenas->v = m.arenas;
+    arenas->n = nThreads;
+    if (erro != SIZE_MAX) {
+        liberarArenasMapa(arenas);
+        hall = NULL;
+        *falha = erro;
+        *motivo = erroMotivo;
+    }
+    free(topo);
+    free(topoIndice);
+    free(m.posicoes);
+    free(m.ordem);
+    free(m.inicio);
+    free(m.raizes);
+    free(m.falha);
+    free(m.motivo);
+    return hall;
 }
 
+/* ---------- Mundo versionado (arquivo de mundo e recarga a quente) ---------- */
+
 /*
- * liberarSalas - libera recursivamente a memória da árvore de salas,
- * incluindo strings de nome e pista.
+ * O mapa e as associações podem vir de um arquivo de texto em vez do código:
+ *
+ *   # comentário
+ *   versao <rótulo livre>
+ *   sala <caminho> | <nome> | <pista, opcional>
+ *   associacao <pista> | <suspeito>
+ *
+ * O caminho da sala é "-" para o Hall de entrada ou a sequência de 'e'/'d'
+ * que leva até ela a partir do Hall; a sala pai precisa vir antes. Cada
+ * carga vira uma VersaoMundo completa (mapa, hash e catálogo próprios) que
+ * nunca muda depois de publicada. No servidor, cada sessão guarda a versão
+ * em que começou até terminar; versões novas só valem para sessões novas,
+ * e uma versão antiga é liberada quando a última sessão dela acaba. Carregar
+ * e liberar versões (a parte cara) fica numa thread própria, o Recarregador;
+ * o laço do servidor só troca ponteiros e conta referências.
  */
-void liberarSalas(Sala *raiz) {      // libera recursivamente todas as salas da árvore
-    if (!raiz) return;               // caso base: nó NULL -> nada a fazer
-    liberarSalas(raiz->esq);         // libera subárvore esquerda
-    liberarSalas(raiz->dir);         // libera subárvore direita
-    free(raiz->nome);                // libera string do nome alocada
-    if (raiz->pista) free(raiz->pista); // libera string da pista, se existir
-    free(raiz);                      // libera a estrutura Sala em si
+#define MUNDO_LINHA  4096              // maior linha aceita no arquivo de mundo
+#define MUNDO_ROTULO 64                // bytes do rótulo de versão
+
+/* VersaoMundo - um mundo completo e imutável, com contagem de referências */
+typedef struct VersaoMundo {
+    Mundo mundo;                      // o que as sessões leem (aponta para os campos abaixo)
+    Sala *mapa;
+    ArenasMapa arenas;                // de onde vêm as salas do mapa (vazio = salas de criarSala)
+    HashTable *ht;
+    Catalogo *cat;
+    unsigned long numero;             // ordem de publicação (1 = mundo inicial)
+    char rotulo[MUNDO_ROTULO];        // linha "versao" do arquivo ("" se não houver)
+    size_t referencias;               // sessões nesta versão, +1 enquanto ela é a atual
+    struct VersaoMundo *prox;         // fila de versões a liberar (Recarregador)
+} VersaoMundo;
+
+/* versaoCriar - embrulha um mapa e uma tabela já montados (cria o catálogo) */
+VersaoMundo *versaoCriar(Sala *mapa, HashTable *ht, const char *rotulo) {
+    VersaoMundo *v = calloc(1, sizeof(VersaoMundo));
+    if (!v) { fprintf(stderr, "Erro: memória insuficiente ao criar versão do mundo.\n"); exit(EXIT_FAILURE); }
+    v->mapa = mapa;
+    v->ht = ht;
+    v->cat = criarCatalogo(mapa, ht);
+    v->mundo = mundoCriar(mapa, ht, v->cat);
+    snprintf(v->rotulo, sizeof(v->rotulo), "%s", rotulo ? rotulo : "");
+    return v;
+}
+
+/* liberarVersaoMundo - libera mapa, tabela e catálogo da versão */
+void liberarVersaoMundo(VersaoMundo *v) {
+    if (!v) return;
+    liberarCatalogo(v->cat);
+    liberarHashTable(v->ht);
+    if (v->arenas.v) liberarArenasMapa(&v->arenas);
+    else liberarSalas(v->mapa);
+    free(v);
 }
 
-/* ---------- Funções para a árvore de pistas (BST) ---------- */
+/* mundo_campo - próximo campo separado por '|' em *cursor, sem espaços nas pontas (NULL se acabou) */
+static char *mundo_campo(char **cursor) {
+    char *ini = *cursor;
+    if (!ini) return NULL;
+    char *barra = strchr(ini, '|');
+    *cursor = barra ? barra + 1 : NULL;
+    if (barra) *barra = '\0';
+    while (isspace((unsigned char)*ini)) ++ini;
+    char *fim = ini + strlen(ini);
+    while (fim > ini && isspace((unsigned char)fim[-1])) *--fim = '\0';
+    return ini;
+}
 
 /*
- * criarNoPista - cria um nó de BST para armazenar uma pista (texto).
+ * carregarMundo - lê o arquivo de mundo 'caminho' e monta uma versão nova.
+ * Em caso de erro devolve NULL e descreve o problema (com o número da
+ * linha) em 'erro'; nada do que foi montado sobra. As salas são guardadas
+ * numa ListaSalas e o mapa sai de montarMapaParalelo, com uma thread por
+ * núcleo em mundos grandes (na thread do Recarregador elas herdam o nice).
  */
-NoPista *criarNoPista(const char *texto) { // cria e inicializa um NoPista com a string fornecida
-    if (!texto) return NULL;          // proteção: não cria se texto for NULL
-    NoPista *n = malloc(sizeof(NoPista)); // aloca memória para o nó
-    if (!n) {                         // verifica sucesso da alocação
-        fprintf(stderr, "Erro: memória insuficiente ao criar nó de pista.\n");
-        exit(EXIT_FAILURE);           // encerra em caso de falha
+VersaoMundo *carregarMundo(const char *caminho, char *erro, size_t capErro) {
+    FILE *f = fopen(caminho, "r");
+    if (!f) { snprintf(erro, capErro, "%s: %s", caminho, strerror(errno)); return NULL; }
+    char linha[MUNDO_LINHA], rotulo[MUNDO_ROTULO] = "";
+    size_t nAssoc = 0;
+    while (fgets(linha, sizeof(linha), f)) {  // primeira passada: tamanho da hash
+        const char *p = linha;
+        while (isspace((unsigned char)*p)) ++p;
+        nAssoc += strncmp(p, "associacao ", 11) == 0;
+    }
+    rewind(f);
+
+    ListaSalas lista = { 0 };
+    HashTable *ht = criarHashTable(nAssoc | 1);
+    unsigned long n = 0;
+    erro[0] = '\0';                    // erros de leitura; um erro do mapa numa linha anterior passa na frente
+    while (!erro[0] && fgets(linha, sizeof(linha), f)) {
+        ++n;
+        size_t tam = strlen(linha);
+        if (tam == sizeof(linha) - 1 && linha[tam - 1] != '\n' && !feof(f)) {
+            snprintf(erro, capErro, "%s:%lu: linha longa demais", caminho, n);
+            break;
+        }
+        linha[strcspn(linha, "\r\n")] = '\0';
+        char *p = linha;
+        while (isspace((unsigned char)*p)) ++p;
+        if (!*p || *p == '#') continue;
+        if (strncmp(p, "versao ", 7) == 0) {
+            char *cursor = p + 7;
+            snprintf(rotulo, sizeof(rotulo), "%s", mundo_campo(&cursor));
+        } else if (strncmp(p, "associacao ", 11) == 0) {
+            char *cursor = p + 11, *pista = mundo_campo(&cursor), *suspeito = mundo_campo(&cursor);
+            if (!suspeito || !*pista || !*suspeito) snprintf(erro, capErro, "%s:%lu: esperado \"associacao <pista> | <suspeito>\"", caminho, n);
+            else inserirNaHash(ht, pista, suspeito);
+        } else if (strncmp(p, "sala ", 5) == 0) {
+            char *cursor = p + 5;
+            char *rota = mundo_campo(&cursor), *nome = mundo_campo(&cursor), *pista = mundo_campo(&cursor);
+            if (!nome || !*nome || !*rota || strspn(rota, strcmp(rota, "-") ? "ed" : "-") != strlen(rota)) {
+                snprintf(erro, capErro, "%s:%lu: esperado \"sala <caminho: - ou e/d...> | <nome> | <pista>\"", caminho, n);
+                continue;
+            }
+            listaAcrescentar(&lista, rota, nome, pista && *pista ? pista : NULL, n);
+        } else {
+            snprintf(erro, capErro, "%s:%lu: linha desconhecida (use versao, sala ou associacao)", caminho, n);
+        }
+    }
+    int falhaLeitura = ferror(f);
+    fclose(f);
+
+    long nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned nThreads = lista.n >= MONT_MIN_PARALELO && nucleos > 1 ? (unsigned)nucleos : 1;
+    ArenasMapa arenas;
+    size_t falha;
+    const char *motivo;
+    Sala *mapa = montarMapaParalelo(&lista, nThreads, &arenas, &falha, &motivo, NULL);
+    if (falha != SIZE_MAX) snprintf(erro, capErro, "%s:%lu: %s", caminho, lista.v[falha].linha, motivo);
+    if (!erro[0] && falhaLeitura) snprintf(erro, capErro, "%s: erro de leitura", caminho);
+    if (!erro[0] && !mapa) snprintf(erro, capErro, "%s: nenhuma sala \"-\" (Hall de entrada)", caminho);
+    liberarListaSalas(&lista);
+    if (erro[0]) {
+        liberarHashTable(ht);
+        liberarArenasMapa(&arenas);
+        return NULL;
     }
-    n->texto = str_dup(texto);        // duplica e guarda o texto da pista
-    n->esq = NULL;                    // inicializa filho esquerdo
-    n->dir = NULL;                    // inicializa filho direito
-    return n;                         // retorna o nó criado
+    VersaoMundo *v = versaoCriar(mapa, ht, rotulo);
+    v->arenas = arenas;
+    return v;
+}
+
+/* mundo_exportarSalas - escreve 's' e a subárvore dela em pré-ordem ('rota' tem espaço para a profundidade) */
+static void mundo_exportarSalas(FILE *f, const Sala *s, char *rota, size_t prof) {
+    if (!s) return;
+    rota[prof] = '\0';
+    fprintf(f, "sala %s | %s", prof ? rota : "-", salaNome(s));
+    if (salaPista(s)) fprintf(f, " | %s", salaPista(s));
+    fputc('\n', f);
+    rota[prof] = 'e';
+    mundo_exportarSalas(f, s->esq, rota, prof + 1);
+    rota[prof] = 'd';
+    mundo_exportarSalas(f, s->dir, rota, prof + 1);
+}
+
+/* mundo_altura - maior profundidade do mapa (tamanho do caminho mais longo) */
+static size_t mundo_altura(const Sala *s) {
+    if (!s) return 0;
+    size_t e = mundo_altura(s->esq), d = mundo_altura(s->dir);
+    return 1 + (e > d ? e : d);
+}
+
+/* exportarMundo - escreve mapa e associações no formato de carregarMundo */
+void exportarMundo(FILE *f, const Sala *mapa, const HashTable *ht, const char *rotulo) {
+    char *rota = malloc(mundo_altura(mapa) + 1);
+    if (!rota) { fprintf(stderr, "Erro: memória insuficiente ao exportar o mundo.\n"); exit(EXIT_FAILURE); }
+    fprintf(f, "# Detective Quest - arquivo de mundo (./mestre --servidor <endereço> <arquivo>; SIGHUP recarrega)\n");
+    if (rotulo && *rotulo) fprintf(f, "versao %s\n", rotulo);
+    mundo_exportarSalas(f, mapa, rota, 0);
+    for (size_t i = 0; i < ht->tamanho; ++i)
+        for (const HashNode *n = ht->buckets[i]; n; n = n->prox) fprintf(f, "associacao %s | %s\n", n->chave, n->suspeito);
+    free(rota);
 }
 
 /*
- * inserirPista - insere uma pista na BST em ordem alfabética.
- * Se a pista já existir (strcmp == 0), não insere duplicata.
- * Retorna a raiz (possivelmente alterada) da BST.
+ * Recarregador - thread que carrega versões novas do arquivo quando pedido
+ * e libera as versões que ficaram sem referências. Quem consome (o laço do
+ * servidor) é avisado pelo eventfd 'aviso' e pega a versão em 'nova'.
  */
-NoPista *inserirPista(NoPista *raiz, const char *texto) { // insere texto na BST mantendo ordem
-    if (!texto) return raiz;          // se texto inválido, retorna raiz sem alteração
-    if (!raiz) {                      // se árvore vazia, cria novo nó como raiz
-        return criarNoPista(texto);
-    }
-    int cmp = strcmp(texto, raiz->texto); // compara alfabeticamente com nó atual
-    if (cmp == 0) {                    // se igual -> já existe, não insere duplicata
-        return raiz;
-    } else if (cmp < 0) {              // se texto < raiz->texto -> vai para subárvore esquerda
-        raiz->esq = inserirPista(raiz->esq, texto);
-    } else {                           // se texto > raiz->texto -> vai para subárvore direita
-        raiz->dir = inserirPista(raiz->dir, texto);
+typedef struct Recarregador {
+    const char *caminho;              // arquivo de mundo
+    pthread_t thread;
+    pthread_mutex_t trava;            // protege os campos abaixo
+    pthread_cond_t sinal;
+    int pedidos;                      // recargas pedidas e ainda não atendidas
+    int parar;
+    VersaoMundo *nova;                // carregada e ainda não adotada (NULL = nenhuma)
+    VersaoMundo *aposentadas;         // sem referências: a liberar
+    unsigned long numero;             // número da última versão carregada
+    int aviso;                        // eventfd: conta as versões publicadas em 'nova'
+} Recarregador;
+
+/*
+ * rec_thread - laço do Recarregador. Roda com nice 19: se a CPU for
+ * disputada com o laço do servidor, a recarga demora mais em vez de atrasar
+ * as sessões, mas continua andando mesmo sob carga constante.
+ */
+static void *rec_thread(void *arg) {
+    Recarregador *r = arg;
+    setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), 19); // no Linux o nice vale por thread
+    pthread_mutex_lock(&r->trava);
+    while (!r->parar) {
+        if (!r->pedidos && !r->aposentadas) { pthread_cond_wait(&r->sinal, &r->trava); continue; }
+        VersaoMundo *lixo = r->aposentadas;
+        int pedido = r->pedidos;
+        r->aposentadas = NULL;
+        r->pedidos = 0;
+        pthread_mutex_unlock(&r->trava);
+
+        while (lixo) {                 // liberar um mundo grande é caro: fora do laço do servidor
+            VersaoMundo *prox = lixo->prox;
+            liberarVersaoMundo(lixo);
+            lixo = prox;
+        }
+        VersaoMundo *v = NULL;
+        if (pedido) {                  // vários pedidos seguidos viram uma carga só
+            char erro[256];
+            unsigned long long t0 = agora_ns();
+            v = carregarMundo(r->caminho, erro, sizeof(erro));
+            if (!v) fprintf(stderr, "Recarga ignorada (o mundo atual continua): %s\n", erro);
+            else fprintf(stderr, "Mundo recarregado de %s em %.1f ms\n", r->caminho, (double)(agora_ns() - t0) / 1e6);
+        }
+
+        pthread_mutex_lock(&r->trava);
+        if (v) {
+            v->numero = ++r->numero;
+            if (r->nova) {             // a anterior nem chegou a ser adotada
+                r->nova->prox = r->aposentadas;
+                r->aposentadas = r->nova;
+            }
+            r->nova = v;
+            uint64_t um = 1;
+            if (write(r->aviso, &um, sizeof(um)) < 0) { /* contador cheio: o laço já tem aviso pendente */ }
+        }
     }
-    return raiz;                       // retorna a raiz (inalterada na maioria dos casos)
+    pthread_mutex_unlock(&r->trava);
+    return NULL;
 }
 
 /*
- * exibirPistas - imprime as pistas em ordem alfabética (percorrendo BST em-order).
+ * recarregadorIniciar - cria o eventfd e a thread. A thread bloqueia os
+ * sinais de encerramento e de recarga, que assim sempre interrompem o laço
+ * principal. Retorna 0 se deu certo.
  */
-void exibirPistas(NoPista *raiz) {    // percorre a BST em ordem e imprime cada pista
-    if (!raiz) return;                // caso base: nó NULL -> retorna
-    exibirPistas(raiz->esq);          // visita recursivamente a subárvore esquerda (menores)
-    printf(" - %s\n", raiz->texto);   // imprime o texto da pista do nó atual
-    exibirPistas(raiz->dir);          // visita recursivamente a subárvore direita (maiores)
+int recarregadorIniciar(Recarregador *r, const char *caminho, unsigned long numeroAtual) {
+    memset(r, 0, sizeof(*r));
+    r->caminho = caminho;
+    r->numero = numeroAtual;
+    r->aviso = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (r->aviso < 0) return -1;
+    pthread_mutex_init(&r->trava, NULL);
+    pthread_cond_init(&r->sinal, NULL);
+    sigset_t bloquear, antes;
+    sigemptyset(&bloquear);
+    sigaddset(&bloquear, SIGINT);
+    sigaddset(&bloquear, SIGTERM);
+    sigaddset(&bloquear, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &bloquear, &antes);
+    int erro = pthread_create(&r->thread, NULL, rec_thread, r);
+    pthread_sigmask(SIG_SETMASK, &antes, NULL);
+    if (erro) { close(r->aviso); return -1; }
+    return 0;
+}
+
+/* recarregadorPedir - pede uma recarga do arquivo (não espera) */
+void recarregadorPedir(Recarregador *r) {
+    pthread_mutex_lock(&r->trava);
+    r->pedidos++;
+    pthread_cond_signal(&r->sinal);
+    pthread_mutex_unlock(&r->trava);
+}
+
+/* recarregadorPegar - versão carregada desde a última chamada, ou NULL */
+VersaoMundo *recarregadorPegar(Recarregador *r) {
+    uint64_t lixo;
+    if (read(r->aviso, &lixo, sizeof(lixo)) < 0) { /* EAGAIN: nenhum aviso */ }
+    pthread_mutex_lock(&r->trava);
+    VersaoMundo *v = r->nova;
+    r->nova = NULL;
+    pthread_mutex_unlock(&r->trava);
+    return v;
+}
+
+/* recarregadorAposentar - entrega uma versão sem referências para ser liberada na thread */
+void recarregadorAposentar(Recarregador *r, VersaoMundo *v) {
+    pthread_mutex_lock(&r->trava);
+    v->prox = r->aposentadas;
+    r->aposentadas = v;
+    pthread_cond_signal(&r->sinal);
+    pthread_mutex_unlock(&r->trava);
+}
+
+/* recarregadorEncerrar - para a thread e libera o que ficou pendente */
+void recarregadorEncerrar(Recarregador *r) {
+    pthread_mutex_lock(&r->trava);
+    r->parar = 1;
+    pthread_cond_signal(&r->sinal);
+    pthread_mutex_unlock(&r->trava);
+    pthread_join(r->thread, NULL);
+    liberarVersaoMundo(r->nova);
+    while (r->aposentadas) {
+        VersaoMundo *prox = r->aposentadas->prox;
+        liberarVersaoMundo(r->aposentadas);
+        r->aposentadas = prox;
+    }
+    close(r->aviso);
+    pthread_cond_destroy(&r->sinal);
+    pthread_mutex_destroy(&r->trava);
 }
 
+/* ---------- Servidor de jogo (modo linha de comando: ./mestre --servidor) ---------- */
+
 /*
- * liberarPistas - libera recursivamente a BST de pistas e suas strings.
+ * Um processo atende muitas sessões. Um laço epoll multiplexa as conexões
+ * (socket Unix ou TCP em 127.0.0.1), e cada uma lê a VersaoMundo que era a
+ * atual quando ela chegou. Com um arquivo de mundo, SIGHUP recarrega o
+ * arquivo (ver Recarregador) e a versão nova vale para as próximas
+ * conexões; as que estão em andamento terminam no mundo em que começaram.
+ * Protocolo em texto: o
+ * cliente manda um comando por linha (e/d/v/s e, depois de 's', o nome do
+ * acusado) e cada resposta termina com o prompt da próxima entrada
+ * ("Escolha (e/d/v/s): " ou "... nome do suspeito: "); depois do veredito o
+ * servidor fecha a conexão. As leituras não bloqueiam, e cada resposta é
+ * montada como uma lista de pedaços (textos do mapa referenciados sem cópia
+ * + trechos formatados) enviada com um único writev. O que o socket não
+ * aceitar fica em 'pendente' e sai quando o epoll avisar (EPOLLOUT); enquanto
+ * isso a conexão não é lida, e o cliente que não lê as respostas é freado
+ * pelo próprio socket em vez de acumular saída no servidor.
  */
-void liberarPistas(NoPista *raiz) {   // libera toda a BST de pistas
-    if (!raiz) return;                // caso base: nó NULL -> nada a fazer
-    liberarPistas(raiz->esq);         // libera subárvore esquerda
-    liberarPistas(raiz->dir);         // libera subárvore direita
-    free(raiz->texto);                // libera string do texto
-    free(raiz);                       // libera estrutura NoPista
-}
+#define SERV_ENTRADA      512          // bytes de comando pendentes por conexão
+#define SERV_PEDACOS      64           // pedaços de uma resposta antes de um writev
+#define SERV_RASCUNHO     1024         // bytes formatados de uma resposta
+#define SERV_PENDENTE_MAX (1u << 20)   // saída acumulada acima disso derruba a conexão
+#define SERV_EVENTOS      256          // eventos por epoll_wait
+#define SERV_PAUSA_MS     100          // com a escuta pausada, intervalo entre tentativas de retomar
+#define SERV_PROMPT_MOVER "Escolha (e/d/v/s): "
+#define SERV_PROMPT_ACUSAR "Quem você acusa? Digite o nome do suspeito: "
 
-/* ---------- Tabela hash (pista -> suspeito) ---------- */
+/* Conexao - estado de uma sessão no servidor */
+typedef struct Conexao {
+    int fd;
+    int falhou;                       // erro de escrita: fechar na próxima oportunidade
+    int querSaida;                    // EPOLLOUT registrado (há bytes pendentes)
+    Sessao sessao;                    // estado do jogo (o resto da Conexao é só E/S)
+    VersaoMundo *versao;              // mundo da sessão (uma referência dela)
+    ConjuntoPistas *coletadas;        // palavras do conjunto de pistas da sessão
+    struct Conexao *ant, *prox;       // lista das conexões abertas (para encerrar o servidor)
+    size_t nEntrada;                  // bytes de comando ainda sem '\n'
+    char entrada[SERV_ENTRADA];
+    int nPedacos;                     // pedaços da resposta em montagem
+    struct iovec pedacos[SERV_PEDACOS];
+    size_t nRascunho;                 // bytes usados de 'rascunho' pelos pedaços formatados
+    char rascunho[SERV_RASCUNHO];
+    char *pendente;                   // saída que o socket ainda não aceitou
+    size_t inicioPendente, nPendente, capPendente;
+} Conexao;
 
-/* criarHashTable - cria uma tabela hash com 'tamanho' buckets */
-HashTable *criarHashTable(size_t tamanho) { // cria e inicializa a estrutura HashTable
-    HashTable *ht = malloc(sizeof(HashTable)); // aloca estrutura da tabela
-    if (!ht) {                          // checa alocação
-        fprintf(stderr, "Erro: memória insuficiente ao criar hash table.\n");
-        exit(EXIT_FAILURE);
+/* Servidor - estado compartilhado do laço de eventos */
+typedef struct Servidor {
+    int ep, escuta;                   // epoll e socket de escuta
+    int reserva;                      // descritor guardado para recusar conexões sem descritores (-1 = nenhum)
+    int escutaPausada;                // sem reserva e sem descritores: escuta fora do epoll até sobrar um
+    VersaoMundo *atual;               // mundo das conexões novas (uma referência do servidor)
+    Recarregador *rec;                // NULL = sem arquivo de mundo (sem recarga)
+    Conexao *abertas;                 // lista das conexões abertas
+    size_t nAbertas, picoAbertas;
+    unsigned long long aceitas, concluidas, comandos, recargas, recusadas;
+} Servidor;
+
+static volatile sig_atomic_t g_servParar = 0, g_servRecarregar = 0;
+static void serv_sinal(int sig) { if (sig == SIGHUP) g_servRecarregar = 1; else g_servParar = 1; }
+
+/* elevarLimiteDescritores - sobe o limite flexível de descritores até o rígido (uma conexão = um descritor) */
+void elevarLimiteDescritores(void) {
+    struct rlimit lim;
+    if (getrlimit(RLIMIT_NOFILE, &lim) == 0 && lim.rlim_cur < lim.rlim_max) {
+        lim.rlim_cur = lim.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &lim);
     }
-    ht->tamanho = tamanho;              // armazena o número de buckets
-    ht->buckets = calloc(tamanho, sizeof(HashNode*)); // cria vetor de ponteiros (inicializados NULL)
-    if (!ht->buckets) {                 // checa alocação do vetor
-        fprintf(stderr, "Erro: memória insuficiente ao criar buckets.\n");
-        exit(EXIT_FAILURE);
+}
+
+/*
+ * abrirEndereco - abre o socket de 'endereco': um caminho (contém '/') é um
+ * socket Unix; senão é uma porta TCP em 127.0.0.1 ("porta" ou
+ * "127.0.0.1:porta"). escutar=1 faz bind + listen (não bloqueante);
+ * escutar=0 conecta (bloqueante). Retorna o descritor ou -1.
+ */
+int abrirEndereco(const char *endereco, int escutar) {
+    int fd, um = 1;
+    if (strchr(endereco, '/')) {
+        struct sockaddr_un un;
+        memset(&un, 0, sizeof(un));
+        un.sun_family = AF_UNIX;
+        if (strlen(endereco) >= sizeof(un.sun_path)) return -1;
+        strcpy(un.sun_path, endereco);
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | (escutar ? SOCK_NONBLOCK : 0), 0);
+        if (fd < 0) return -1;
+        if (escutar) unlink(endereco);  // socket velho de uma execução anterior
+        if (escutar ? bind(fd, (struct sockaddr *)&un, sizeof(un)) || listen(fd, SOMAXCONN)
+                    : connect(fd, (struct sockaddr *)&un, sizeof(un))) { close(fd); return -1; }
+        return fd;
     }
-    return ht;                          // retorna a tabela inicializada
+    const char *porta = strrchr(endereco, ':');
+    struct sockaddr_in in;
+    memset(&in, 0, sizeof(in));
+    in.sin_family = AF_INET;
+    in.sin_port = htons((uint16_t)strtoul(porta ? porta + 1 : endereco, NULL, 10));
+    in.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // só local: o servidor não é exposto à rede
+    fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC | (escutar ? SOCK_NONBLOCK : 0), 0);
+    if (fd < 0) return -1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &um, sizeof(um));
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &um, sizeof(um)); // respostas curtas saem na hora
+    if (escutar ? bind(fd, (struct sockaddr *)&in, sizeof(in)) || listen(fd, SOMAXCONN)
+                : connect(fd, (struct sockaddr *)&in, sizeof(in))) { close(fd); return -1; }
+    return fd;
+}
+
+/* serv_aguardarSaida - troca a espera da conexão entre leitura (EPOLLIN) e envio do pendente (EPOLLOUT) */
+static void serv_aguardarSaida(Servidor *srv, Conexao *c, int quer) {
+    if (c->querSaida == quer) return;
+    struct epoll_event ev = { .events = quer ? EPOLLOUT : EPOLLIN | EPOLLRDHUP, .data.ptr = c };
+    epoll_ctl(srv->ep, EPOLL_CTL_MOD, c->fd, &ev);
+    c->querSaida = quer;
 }
 
-/* hash_simple - função hash simples que usa soma de bytes e módulo (suficiente para demo) */
-size_t hash_simple(const char *s, size_t mod) { // calcula índice do bucket para a chave s
-    size_t h = 0;                       // inicializa acumulador
-    for (size_t i = 0; s[i] != '\0'; ++i) h = h * 31 + (unsigned char)s[i]; // multiplicativa simples
-    return h % mod;                     // reduz ao intervalo de buckets
+/* serv_guardar - acrescenta bytes à saída pendente (ordem preservada) */
+static void serv_guardar(Conexao *c, const char *s, size_t n) {
+    if (c->nPendente + n > SERV_PENDENTE_MAX) { c->falhou = 1; return; } // cliente não lê: desiste dele
+    if (c->inicioPendente + c->nPendente + n > c->capPendente) {
+        if (c->nPendente) memmove(c->pendente, c->pendente + c->inicioPendente, c->nPendente);
+        c->inicioPendente = 0;
+        if (c->nPendente + n > c->capPendente) {
+            size_t cap = c->capPendente ? c->capPendente : 4096;
+            while (cap < c->nPendente + n) cap *= 2;
+            char *p = realloc(c->pendente, cap);
+            if (!p) { fprintf(stderr, "Erro: memória insuficiente no servidor.\n"); exit(EXIT_FAILURE); }
+            c->pendente = p;
+            c->capPendente = cap;
+        }
+    }
+    memcpy(c->pendente + c->inicioPendente + c->nPendente, s, n);
+    c->nPendente += n;
 }
 
 /*
- * inserirNaHash - insere associação (pista -> suspeito) na tabela hash.
- * Se a chave já existir, atualiza o suspeito.
+ * serv_descarregar - envia os pedaços montados com um writev. O que não
+ * couber no socket é copiado para 'pendente' (os pedaços apontam para o
+ * rascunho, que é reaproveitado em seguida).
  */
-void inserirNaHash(HashTable *ht, const char *pista, const char *suspeito) {
-    if (!ht || !pista || !suspeito) return; // proteção contra parâmetros inválidos
-    size_t idx = hash_simple(pista, ht->tamanho); // calcula bucket
-    HashNode *node = ht->buckets[idx];    // ponteiro para início da lista do bucket
+static void serv_descarregar(Servidor *srv, Conexao *c) {
+    if (!c->nPedacos) return;
+    ssize_t escritos = 0;
+    if (!c->nPendente && !c->falhou) { // com saída pendente, escrever agora trocaria a ordem
+        do escritos = writev(c->fd, c->pedacos, c->nPedacos); while (escritos < 0 && errno == EINTR);
+        if (escritos < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) c->falhou = 1;
+            escritos = 0;
+        }
+    }
+    for (int i = 0; i < c->nPedacos && !c->falhou; ++i) {
+        size_t n = c->pedacos[i].iov_len;
+        if ((size_t)escritos >= n) { escritos -= (ssize_t)n; continue; }
+        serv_guardar(c, (const char *)c->pedacos[i].iov_base + escritos, n - (size_t)escritos);
+        escritos = 0;
+    }
+    c->nPedacos = 0;
+    c->nRascunho = 0;
+    if (c->nPendente && !c->falhou) serv_aguardarSaida(srv, c, 1);
+}
+
+/* serv_texto - acrescenta um texto que vive até o envio (mapa, literais) à resposta */
+static void serv_texto(Servidor *srv, Conexao *c, const char *s) {
+    if (c->nPedacos == SERV_PEDACOS) serv_descarregar(srv, c);
+    c->pedacos[c->nPedacos].iov_base = (void *)s;
+    c->pedacos[c->nPedacos++].iov_len = strlen(s);
+}
 
-    // procurar chave existente: se achar, atualizar valor e retornar
-    for (HashNode *cur = node; cur != NULL; cur = cur->prox) {
-        if (strcmp(cur->chave, pista) == 0) { // chave já presente
-            free(cur->suspeito);           // liberar suspeito antigo
-            cur->suspeito = str_dup(suspeito); // atualizar suspeito associado
-            return;                         // fim
+/* serv_formatar - acrescenta um trecho formatado (copiado para o rascunho) à resposta */
+static void serv_formatar(Servidor *srv, Conexao *c, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(c->rascunho + c->nRascunho, SERV_RASCUNHO - c->nRascunho, fmt, ap);
+    va_end(ap);
+    if (n >= 0 && (size_t)n >= SERV_RASCUNHO - c->nRascunho && c->nRascunho) { // não coube: esvazia e tenta de novo
+        serv_descarregar(srv, c);
+        va_start(ap, fmt);
+        n = vsnprintf(c->rascunho, SERV_RASCUNHO, fmt, ap);
+        va_end(ap);
+    }
+    if (n < 0) return;
+    if ((size_t)n >= SERV_RASCUNHO - c->nRascunho) n = (int)(SERV_RASCUNHO - c->nRascunho - 1); // trunca
+    if (c->nPedacos == SERV_PEDACOS) serv_descarregar(srv, c);
+    c->pedacos[c->nPedacos].iov_base = c->rascunho + c->nRascunho;
+    c->pedacos[c->nPedacos++].iov_len = (size_t)n;
+    c->nRascunho += (size_t)n;
+}
+
+/* serv_mostrarEvento - acrescenta à resposta o texto de um evento da sessão */
+static void serv_mostrarEvento(Servidor *srv, Conexao *c, const EventoSessao *e, const char *entrada) {
+    switch (e->tipo) {
+    case EV_INICIO:
+        serv_texto(srv, c, "--- Detective Quest (servidor) ---\n");
+        break;
+    case EV_PISTA:
+        serv_texto(srv, c, "[Pista encontrada] ");
+        serv_texto(srv, c, salaPista(e->sala));
+        serv_texto(srv, c, e->suspeito ? "\n  -> Esta pista aponta para: " : "\n  -> Nenhum suspeito associado a esta pista (desconhecido)\n\n");
+        if (e->suspeito) { serv_texto(srv, c, e->suspeito); serv_texto(srv, c, "\n\n"); }
+        break;
+    case EV_SEM_PASSAGEM:
+        serv_texto(srv, c, "Não há sala nessa direção. Tente outra opção.\n");
+        break;
+    case EV_INVALIDO:
+        serv_texto(srv, c, "Opção inválida. Use 'e', 'd', 'v', 't <sala>' ou 's'.\n");
+        break;
+    case EV_MOVEU:
+        if (e->cmd == 't') serv_formatar(srv, c, "-- Teletransporte para %s --\n", salaNome(e->sala));
+        break;
+    case EV_SALA_DESCONHECIDA:
+        serv_texto(srv, c, "Nenhuma sala com esse nome.\n");
+        break;
+    case EV_SALA_AMBIGUA:
+        serv_formatar(srv, c, "Há %u salas com esse nome; use \"t <sala> #k\" para escolher.\n", e->valor);
+        break;
+    case EV_FIM_EXPLORACAO:
+        serv_texto(srv, c, "Encerrando exploração...\nPistas coletadas (ordem alfabética):\n");
+        for (size_t w = 0; w < c->coletadas->nPalavras; ++w)
+            for (uint64_t bits = c->coletadas->palavras[w]; bits; bits &= bits - 1) {
+                serv_texto(srv, c, " - ");
+                serv_texto(srv, c, eytSelecionar(c->versao->cat->ordem, w * 64 + (size_t)__builtin_ctzll(bits)));
+                serv_texto(srv, c, "\n");
+            }
+        serv_texto(srv, c, SERV_PROMPT_ACUSAR);
+        break;
+    case EV_VEREDITO:
+        serv_formatar(srv, c, "\nVocê acusou: %s\n", e->suspeito ? e->suspeito : entrada);
+        if (!e->suspeito) {
+            char sugestoes[256];
+            serv_texto(srv, c, "Nenhum suspeito com esse nome.");
+            if (sugerirSuspeitos(c->versao->cat, entrada, sugestoes, sizeof(sugestoes)))
+                serv_formatar(srv, c, " Você quis dizer: %s?", sugestoes);
+            serv_texto(srv, c, "\n");
         }
+        serv_texto(srv, c, e->valor ? "Desfecho: Acusação procedente — caso encaminhado às autoridades.\n"
+                                    : "Desfecho: Acusação improcedente — investigue mais pistas.\n");
+        srv->concluidas++;
+        break;
     }
+}
 
-    // se não existe, criar novo HashNode e inserir no início da lista
-    HashNode *novo = malloc(sizeof(HashNode)); // alocar novo nó
-    if (!novo) {                            // checar alocação
-        fprintf(stderr, "Erro: memória insuficiente ao criar HashNode.\n");
-        exit(EXIT_FAILURE);
+/* serv_responder - mostra os eventos de uma entrada e, se a exploração continua, a sala e o prompt */
+static void serv_responder(Servidor *srv, Conexao *c, const EventoSessao *ev, size_t nEv, const char *entrada) {
+    for (size_t i = 0; i < nEv; ++i) serv_mostrarEvento(srv, c, &ev[i], entrada);
+    if (c->sessao.fase == SES_EXPLORANDO) {
+        serv_texto(srv, c, "Você está na sala: ");
+        serv_texto(srv, c, salaNome(sessaoSala(&c->sessao)));
+        serv_texto(srv, c, "\n" SERV_PROMPT_MOVER);
     }
-    novo->chave = str_dup(pista);           // duplicar chave
-    novo->suspeito = str_dup(suspeito);     // duplicar valor
-    novo->prox = ht->buckets[idx];          // inserir no início da lista
-    ht->buckets[idx] = novo;                // atualizar cabeça do bucket
+}
+
+/* serv_comando - executa uma linha de comando da conexão */
+static void serv_comando(Servidor *srv, Conexao *c, char *linha) {
+    EventoSessao ev[SESSAO_MAX_EVENTOS];
+    srv->comandos++;
+    if (c->sessao.fase == SES_EXPLORANDO)
+        while (isspace((unsigned char)*linha)) ++linha;
+    size_t nEv = sessaoAlimentar(&c->sessao, &c->versao->mundo, linha, ev);
+    serv_responder(srv, c, ev, nEv, linha);
+}
+
+/* serv_soltar - solta uma referência de 'v'; a última entrega a versão para ser liberada */
+static void serv_soltar(Servidor *srv, VersaoMundo *v) {
+    if (--v->referencias) return;
+    if (srv->rec) recarregadorAposentar(srv->rec, v); // liberar fica com a thread do Recarregador
+    else liberarVersaoMundo(v);
+}
+
+/* serv_adotar - passa a usar a versão recém-carregada nas conexões novas */
+static void serv_adotar(Servidor *srv) {
+    VersaoMundo *v = recarregadorPegar(srv->rec);
+    if (!v) return;
+    VersaoMundo *antiga = srv->atual;
+    v->referencias = 1;
+    srv->atual = v;
+    srv->recargas++;
+    printf("Mundo v%lu%s%s%s em uso: %zu salas, %zu pistas, %zu suspeitos (v%lu segue com %zu sessões)\n",
+           v->numero, *v->rotulo ? " (" : "", v->rotulo, *v->rotulo ? ")" : "", v->cat->nSalas, v->cat->nPistas,
+           v->cat->nSuspeitos, antiga->numero, antiga->referencias - 1);
+    fflush(stdout);
+    serv_soltar(srv, antiga);
 }
 
 /*
- * encontrarSuspeito - busca na hash o suspeito associado a uma pista.
- * Retorna ponteiro para string (interno da hash) ou NULL se não encontrar.
+ * serv_retomarEscuta - refaz a reserva, se faltar, e devolve a escuta pausada
+ * ao epoll assim que a reserva existir (chamada quando uma conexão fecha e, com
+ * a escuta pausada, a cada SERV_PAUSA_MS: o descritor pode voltar por fora)
  */
-const char *encontrarSuspeito(HashTable *ht, const char *pista) {
-    if (!ht || !pista) return NULL;        // proteção
-    size_t idx = hash_simple(pista, ht->tamanho); // índice do bucket
-    for (HashNode *cur = ht->buckets[idx]; cur != NULL; cur = cur->prox) {
-        if (strcmp(cur->chave, pista) == 0) return cur->suspeito; // retorna suspeito associado
+static void serv_retomarEscuta(Servidor *srv) {
+    if (srv->reserva < 0) srv->reserva = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    if (srv->escutaPausada && srv->reserva >= 0) { // sobrou um descritor: volta a aceitar
+        struct epoll_event ev = { .events = EPOLLIN, .data.ptr = NULL };
+        srv->escutaPausada = epoll_ctl(srv->ep, EPOLL_CTL_MOD, srv->escuta, &ev) < 0;
     }
-    return NULL;                            // não encontrada
 }
 
-/* liberarHashTable - libera toda a estrutura da tabela hash e strings */
-void liberarHashTable(HashTable *ht) {
-    if (!ht) return;                       // proteção
-    for (size_t i = 0; i < ht->tamanho; ++i) { // para cada bucket...
-        HashNode *cur = ht->buckets[i];
-        while (cur) {                      // liberar lista encadeada
-            HashNode *next = cur->prox;
-            free(cur->chave);              // libera chave
-            free(cur->suspeito);           // libera valor
-            free(cur);                     // libera nó
-            cur = next;
+/* serv_fechar - encerra a conexão e libera seu estado */
+static void serv_fechar(Servidor *srv, Conexao *c) {
+    close(c->fd);                      // também a remove do epoll
+    if (c->ant) c->ant->prox = c->prox; else srv->abertas = c->prox;
+    if (c->prox) c->prox->ant = c->ant;
+    srv->nAbertas--;
+    serv_retomarEscuta(srv);
+    serv_soltar(srv, c->versao);
+    conjLiberar(c->coletadas);
+    free(c->pendente);
+    free(c);
+}
+
+/*
+ * serv_semDescritores - accept4 falhou com EMFILE/ENFILE. A escuta é
+ * avisada por nível: se a conexão ficasse na fila, o epoll_wait voltaria na
+ * hora e o laço giraria a 100% de CPU enquanto durasse a falta. Com a
+ * reserva, a conexão sai da fila e é recusada com um aviso. Se a fila já
+ * estava vazia, basta refazer a reserva. A escuta só sai do epoll quando a
+ * reserva não pôde ser refeita; ela volta quando serv_retomarEscuta
+ * conseguir o descritor (ao fechar uma conexão ou no tempo limite do
+ * epoll_wait, para o caso de não haver conexão nenhuma). Retorna 1 se ainda
+ * vale tentar o próximo da fila.
+ */
+static int serv_semDescritores(Servidor *srv) {
+    static const char lotado[] = "Servidor lotado. Tente de novo mais tarde.\n";
+    int fd = -1;
+    if (srv->reserva >= 0) {
+        close(srv->reserva);
+        fd = accept4(srv->escuta, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd >= 0) {
+            send(fd, lotado, sizeof(lotado) - 1, MSG_NOSIGNAL);
+            close(fd);
+            srv->recusadas++;
         }
+        srv->reserva = open("/dev/null", O_RDONLY | O_CLOEXEC);
     }
-    free(ht->buckets);                     // libera vetor de buckets
-    free(ht);                              // libera estrutura da tabela
+    if (srv->reserva >= 0) return fd >= 0;
+    struct epoll_event ev = { .events = 0, .data.ptr = NULL };
+    srv->escutaPausada = epoll_ctl(srv->ep, EPOLL_CTL_MOD, srv->escuta, &ev) == 0;
+    return 0;
 }
 
-/* mostrarAssociacoes - imprime todas as associações pista -> suspeito */
-void mostrarAssociacoes(HashTable *ht) {  // exibe todas as associações presentes na hash
-    if (!ht) {                            // se tabela inexistente, informa
-        printf("(Tabela de associações vazia)\n");
-        return;
+/* serv_aceitar - aceita todas as conexões na fila e envia a abertura de cada uma */
+static void serv_aceitar(Servidor *srv) {
+    for (;;) {
+        int fd = accept4(srv->escuta, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0 && (errno == EINTR || errno == ECONNABORTED)) continue;
+        if (fd < 0 && (errno == EMFILE || errno == ENFILE) && serv_semDescritores(srv)) continue;
+        if (fd < 0) return;            // EAGAIN: fila vazia (ou erro transitório)
+        int um = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &um, sizeof(um)); // ignorado em socket Unix
+        Conexao *c = calloc(1, sizeof(Conexao));
+        if (!c) { fprintf(stderr, "Erro: memória insuficiente no servidor.\n"); exit(EXIT_FAILURE); }
+        c->fd = fd;
+        c->versao = srv->atual;         // a sessão fica neste mundo até acabar
+        c->coletadas = conjCriar(c->versao->cat->nPistas);
+        struct epoll_event ev = { .events = EPOLLIN | EPOLLRDHUP, .data.ptr = c };
+        if (epoll_ctl(srv->ep, EPOLL_CTL_ADD, fd, &ev) < 0) { close(fd); conjLiberar(c->coletadas); free(c); continue; }
+        c->versao->referencias++;
+        c->prox = srv->abertas;
+        if (c->prox) c->prox->ant = c;
+        srv->abertas = c;
+        if (++srv->nAbertas > srv->picoAbertas) srv->picoAbertas = srv->nAbertas;
+        srv->aceitas++;
+        EventoSessao chegada[SESSAO_MAX_EVENTOS];
+        size_t nEv = sessaoIniciar(&c->sessao, &c->versao->mundo, c->coletadas, chegada);
+        serv_responder(srv, c, chegada, nEv, NULL);
+        serv_descarregar(srv, c);
+        if (c->falhou) serv_fechar(srv, c);
     }
-    printf("\n--- Associações conhecidas (pista -> suspeito) ---\n");
-    for (size_t i = 0; i < ht->tamanho; ++i) { // percorre todos os buckets
-        for (HashNode *cur = ht->buckets[i]; cur != NULL; cur = cur->prox) {
-            printf(" - \"%s\"  =>  %s\n", cur->chave, cur->suspeito); // imprime cada par
+}
+
+/* serv_ler - lê tudo o que chegou, executa as linhas completas e responde; retorna -1 se a conexão acabou */
+static int serv_ler(Servidor *srv, Conexao *c) {
+    int acabou = 0;
+    for (;;) {
+        ssize_t n = read(c->fd, c->entrada + c->nEntrada, SERV_ENTRADA - c->nEntrada);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n <= 0) { acabou = 1; break; } // fim da conexão ou erro: responde o que já foi lido
+        size_t ini = 0, fim = c->nEntrada + (size_t)n;
+        for (size_t i = c->nEntrada; i < fim && c->sessao.fase != SES_ENCERRADA; ++i) {
+            if (c->entrada[i] != '\n') continue;
+            c->entrada[i] = '\0';
+            if (i > ini && c->entrada[i - 1] == '\r') c->entrada[i - 1] = '\0';
+            serv_comando(srv, c, c->entrada + ini);
+            ini = i + 1;
         }
+        if (c->sessao.fase == SES_ENCERRADA) break; // o que vier depois do veredito não vale
+        c->nEntrada = fim - ini;
+        if (c->nEntrada == SERV_ENTRADA) c->nEntrada = 0; // linha longa demais: descartada
+        else memmove(c->entrada, c->entrada + ini, c->nEntrada);
+        serv_descarregar(srv, c);
+        if (c->nPendente || c->falhou) break; // socket cheio: volta a ler quando o pendente sair
     }
-    printf("---------------------------------------------------\n\n");
+    serv_descarregar(srv, c);
+    if (c->falhou || acabou) return -1;
+    return c->sessao.fase == SES_ENCERRADA && !c->nPendente ? -1 : 0;
 }
 
-/* ---------- Exploração: coleta de pistas (atualizada para mostrar suspeitos) ---------- */
+/* serv_escreverPendente - envia a saída acumulada quando o socket volta a aceitar bytes */
+static int serv_escreverPendente(Servidor *srv, Conexao *c) {
+    while (c->nPendente) {
+        ssize_t n = write(c->fd, c->pendente + c->inicioPendente, c->nPendente);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return 0;
+        if (n < 0) return -1;
+        c->inicioPendente += (size_t)n;
+        c->nPendente -= (size_t)n;
+    }
+    c->inicioPendente = 0;
+    serv_aguardarSaida(srv, c, 0);
+    return c->sessao.fase == SES_ENCERRADA ? -1 : 0;
+}
 
 /*
- * explorarSalasComPistas - permite a navegação do jogador pela árvore a partir da raiz.
- * Quando o jogador entra em uma sala que contém pista, a pista é inserida automaticamente
- * na árvore de pistas (BST passada por referência) e o suspeito associado (se houver)
- * é mostrado imediatamente utilizando a tabela hash passada como parâmetro.
- *
- * Comandos:
- *   e - esquerda
- *   d - direita
- *   v - voltar (pai)
- *   s - encerrar exploração atual
- *
- * Parâmetros:
- *   raiz     - raiz do mapa (Sala*)
- *   pistas   - ponteiro para a raiz da BST de pistas coletadas (NoPista**).
- *             A função atualiza *pistas para incluir as novas pistas.
- *   ht       - tabela hash (pista -> suspeito) usada para mostrar associação imediatamente.
+ * servidorJogo - atende sessões em 'endereco' no mundo 'inicial' (o servidor
+ * passa a ser dono dele) até receber SIGINT/SIGTERM e então mostra quantas
+ * conexões e sessões foram atendidas. Com 'arquivo' (de onde veio o mundo
+ * inicial), SIGHUP recarrega o mundo dele sem parar as sessões.
  */
-void explorarSalasComPistas(Sala *raiz, NoPista **pistas, HashTable *ht) { // inicia sessão de exploração com coleta de pistas
-    if (!raiz) {                      // se o mapa for vazio, informa e retorna
-        printf("Mapa vazio. Nada a explorar.\n");
-        return;
+int servidorJogo(const char *endereco, VersaoMundo *inicial, const char *arquivo) {
+    if (!inicial->cat->nSalas) { printf("Mapa vazio. Nada a servir.\n"); liberarVersaoMundo(inicial); return 1; }
+    Servidor srv;
+    Recarregador rec;
+    memset(&srv, 0, sizeof(srv));
+    elevarLimiteDescritores();
+    srv.reserva = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    srv.atual = inicial;
+    srv.atual->numero = 1;
+    srv.atual->referencias = 1;
+    srv.escuta = abrirEndereco(endereco, 1);
+    srv.ep = epoll_create1(EPOLL_CLOEXEC);
+    if (srv.escuta < 0 || srv.ep < 0) {
+        fprintf(stderr, "Erro: não foi possível escutar em %s: %s\n", endereco, strerror(errno));
+        liberarVersaoMundo(inicial);
+        return 1;
     }
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = NULL }; // ptr NULL = socket de escuta
+    epoll_ctl(srv.ep, EPOLL_CTL_ADD, srv.escuta, &ev);
+    if (arquivo) {
+        if (recarregadorIniciar(&rec, arquivo, srv.atual->numero) == 0) {
+            srv.rec = &rec;
+            ev = (struct epoll_event){ .events = EPOLLIN, .data.ptr = srv.rec }; // aviso de versão nova
+            epoll_ctl(srv.ep, EPOLL_CTL_ADD, rec.aviso, &ev);
+        } else {
+            fprintf(stderr, "Aviso: recarga indisponível (%s).\n", strerror(errno));
+        }
+    }
+    signal(SIGPIPE, SIG_IGN);          // cliente que some no meio de um writev vira EPIPE, não sinal
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = serv_sinal;        // sem SA_RESTART: epoll_wait volta com EINTR
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    sigaction(SIGHUP, &sa, NULL);
+    printf("Servidor ouvindo em %s (Ctrl+C encerra%s)\n", endereco, srv.rec ? "; SIGHUP recarrega o mundo" : "");
+    fflush(stdout);
 
-    const int MAX_VISITAS = 1024;     // limite para histórico de visitas (prevenção de overflow)
-    const char *visitadas[MAX_VISITAS]; // array de ponteiros para nomes das salas visitadas
-    int cont = 0;                     // contador de visitas registradas
+    struct epoll_event eventos[SERV_EVENTOS];
+    while (!g_servParar) {
+        int n = epoll_wait(srv.ep, eventos, SERV_EVENTOS, srv.escutaPausada ? SERV_PAUSA_MS : -1);
+        if (n < 0 && errno != EINTR) { perror("epoll_wait"); break; }
+        if (srv.escutaPausada) serv_retomarEscuta(&srv);
+        if (g_servRecarregar) {        // SIGHUP: a carga roda na thread do Recarregador
+            g_servRecarregar = 0;
+            if (srv.rec) recarregadorPedir(srv.rec);
+            else fprintf(stderr, "Sem arquivo de mundo: nada a recarregar.\n");
+        }
+        for (int i = 0; i < n; ++i) {
+            Conexao *c = eventos[i].data.ptr;
+            if (!c) { serv_aceitar(&srv); continue; }
+            if ((void *)c == srv.rec) { serv_adotar(&srv); continue; }
+            int fim = 0;
+            if (c->querSaida) fim = serv_escreverPendente(&srv, c) < 0; // esperando para enviar: não lê
+            else fim = serv_ler(&srv, c) < 0;
+            if (fim) serv_fechar(&srv, c);
+        }
+    }
 
-    Sala *atual = raiz;               // sala atual (inicia na raiz)
-    printf("\n--- Iniciando exploração da mansão (coleta de pistas) ---\n"); // cabeçalho
-    printf("Você começa no Hall de entrada: \"%s\"\n\n", atual->nome); // mostra a sala inicial
+    while (srv.abertas) serv_fechar(&srv, srv.abertas);
+    serv_soltar(&srv, srv.atual);
+    if (srv.rec) recarregadorEncerrar(srv.rec); // libera as versões aposentadas que faltarem
+    close(srv.ep);
+    close(srv.escuta);
+    if (srv.reserva >= 0) close(srv.reserva);
+    if (strchr(endereco, '/')) unlink(endereco);
+    printf("\nServidor encerrado: %llu conexões, %llu sessões concluídas, %llu comandos, pico de %zu conexões simultâneas, %llu recargas\n",
+           srv.aceitas, srv.concluidas, srv.comandos, srv.picoAbertas, srv.recargas);
+    if (srv.recusadas) printf("Conexões recusadas por falta de descritores: %llu\n", srv.recusadas);
+    return 0;
+}
 
-    // inserir pista da sala inicial (se houver) e mostrar suspeito associado
-    if (atual->pista) {               // se a sala inicial tem pista...
-        *pistas = inserirPista(*pistas, atual->pista); // insere na BST de pistas
-        printf("[Pista encontrada] %s\n", atual->pista); // informa a pista
-        const char *sus = encontrarSuspeito(ht, atual->pista); // procura suspeito na hash
-        if (sus) {
-            printf("  -> Esta pista aponta para: %s\n\n", sus); // mostra suspeito imediatamente
-        } else {
-            printf("  -> Nenhum suspeito associado a esta pista (desconhecido)\n\n"); // indica falta de associação
+/* ---------- Modo lote (linha de comando: ./mestre --lote [bitset|bst|avl] [arquivo de mundo] < entradas) ---------- */
+
+/*
+ * Cada linha da entrada é "<sessão> <entrada>": o número identifica a sessão
+ * (criada na primeira menção) e o resto da linha é alimentado a ela. Linhas
+ * de sessões diferentes podem vir intercaladas em qualquer ordem; cada evento
+ * sai numa linha "<sessão> <evento> ...". Depois do veredito a sessão é
+ * descartada e o número pode começar outra. Com bst ou avl, as pistas de cada
+ * sessão vão para a coleção do motor em vez do bitset; na BST, os nós de uma
+ * sessão descartada voltam ao pool e servem às sessões seguintes.
+ */
+#define LOTE_MAX_SESSOES (1u << 24)    // maior número de sessão aceito
+
+/* SessaoLote - Sessao que guarda as palavras do próprio conjunto de pistas no mesmo bloco (nenhuma com coleção) */
+typedef struct SessaoLote {
+    Sessao sessao;
+    uint64_t palavras[];
+} SessaoLote;
+
+/* sessaoLoteCriar - aloca e inicia uma sessão avulsa; devolve em 'ev' os eventos da chegada */
+SessaoLote *sessaoLoteCriar(const Mundo *m, EventoSessao ev[SESSAO_MAX_EVENTOS], size_t *nEv) {
+    size_t nPalavras = m->motor.colecaoOps ? 0 : m->cat->nPalavras; // com coleção do motor, nada de bitset
+    SessaoLote *l = calloc(1, sizeof(SessaoLote) + nPalavras * sizeof(uint64_t));
+    if (!l) { fprintf(stderr, "Erro: memória insuficiente ao criar sessão.\n"); exit(EXIT_FAILURE); }
+    ConjuntoPistas conj = { l->palavras, nPalavras };
+    *nEv = sessaoIniciar(&l->sessao, m, nPalavras ? &conj : NULL, ev);
+    return l;
+}
+
+/* lote_mostrarEvento - uma linha por evento, prefixada pelo número da sessão */
+static void lote_mostrarEvento(unsigned long id, const EventoSessao *e) {
+    switch (e->tipo) {
+    case EV_INICIO:         printf("%lu inicio %s\n", id, salaNome(e->sala)); break;
+    case EV_MOVEU:          printf("%lu sala %s\n", id, salaNome(e->sala)); break;
+    case EV_PISTA:          printf("%lu pista %s => %s\n", id, salaPista(e->sala), e->suspeito ? e->suspeito : "?"); break;
+    case EV_SEM_PASSAGEM:   printf("%lu sem-passagem %c\n", id, e->cmd); break;
+    case EV_INVALIDO:       printf("%lu invalido\n", id); break;
+    case EV_FIM_EXPLORACAO: printf("%lu acusar\n", id); break;
+    case EV_VEREDITO:       printf("%lu veredito %s\n", id, e->valor ? "procedente" : "improcedente"); break;
+    case EV_SALA_DESCONHECIDA: printf("%lu sala-desconhecida\n", id); break;
+    case EV_SALA_AMBIGUA:   printf("%lu sala-ambigua %u\n", id, e->valor); break;
+    }
+}
+
+/* jogarLote - executa as linhas da entrada padrão; o resumo vai para stderr */
+int jogarLote(const Mundo *m) {
+    SessaoLote **sessoes = NULL;       // sessão de cada número (NULL = nenhuma em andamento)
+    size_t cap = 0, vivas = 0, pico = 0, encerradas = 0, linhas = 0, ignoradas = 0;
+    EventoSessao ev[SESSAO_MAX_EVENTOS];
+    char linha[512];
+    while (lerLinha(linha, sizeof(linha))) {
+        linhas++;
+        linha[strcspn(linha, "\r\n")] = '\0';
+        char *resto;
+        unsigned long id = strtoul(linha, &resto, 10);
+        if (resto == linha || id >= LOTE_MAX_SESSOES) { ignoradas++; continue; }
+        while (*resto == ' ' || *resto == '\t') ++resto;
+        if (id >= cap) {
+            size_t novo = cap ? cap : 64;
+            while (novo <= id) novo *= 2;
+            SessaoLote **p = realloc(sessoes, novo * sizeof(SessaoLote *));
+            if (!p) { fprintf(stderr, "Erro: memória insuficiente no modo lote.\n"); exit(EXIT_FAILURE); }
+            memset(p + cap, 0, (novo - cap) * sizeof(SessaoLote *));
+            sessoes = p;
+            cap = novo;
+        }
+        size_t nEv;
+        if (!sessoes[id]) {            // primeira menção: começa no Hall
+            sessoes[id] = sessaoLoteCriar(m, ev, &nEv);
+            for (size_t i = 0; i < nEv; ++i) lote_mostrarEvento(id, &ev[i]);
+            if (++vivas > pico) pico = vivas;
+            if (!*resto) continue;
         }
+        nEv = sessaoAlimentar(&sessoes[id]->sessao, m, resto, ev);
+        for (size_t i = 0; i < nEv; ++i) lote_mostrarEvento(id, &ev[i]);
+        if (sessoes[id]->sessao.fase == SES_ENCERRADA) {
+            sessaoEncerrar(&sessoes[id]->sessao);
+            free(sessoes[id]);
+            sessoes[id] = NULL;
+            vivas--;
+            encerradas++;
+        }
+    }
+    for (size_t i = 0; i < cap; ++i) {
+        if (sessoes[i]) sessaoEncerrar(&sessoes[i]->sessao);
+        free(sessoes[i]);
+    }
+    free(sessoes);
+    fprintf(stderr, "Lote: %zu linhas (%zu ignoradas), %zu sessões encerradas, %zu sem veredito, pico de %zu sessões em andamento\n",
+            linhas, ignoradas, encerradas, vivas, pico);
+    return 0;
+}
+
+/* ---------- Relatório de estatísticas (somente com -DDQ_ESTATISTICAS) ---------- */
+
+#ifdef DQ_ESTATISTICAS
+/* est_imprimirHistograma - mostra um histograma com barras proporcionais */
+static void est_imprimirHistograma(const char *titulo, const Histograma *h) {
+    printf("%s: %llu amostras", titulo, h->amostras);
+    if (h->amostras) printf(", média %.1f, máx %llu", (double)h->soma / (double)h->amostras, h->maximo);
+    printf("\n");
+    unsigned long long pico = 1;       // maior faixa (escala das barras)
+    for (int i = 0; i < EST_FAIXAS; ++i) if (h->faixas[i] > pico) pico = h->faixas[i];
+    for (int i = 0; i < EST_FAIXAS; ++i) {
+        if (!h->faixas[i]) continue;   // omite faixas vazias
+        unsigned long long ini = i ? 1ull << (i - 1) : 0; // limite inferior da faixa
+        unsigned long long fim = i ? (1ull << i) - 1 : 0; // limite superior da faixa
+        int largura = (int)(h->faixas[i] * 40 / pico); // barra de até 40 colunas
+        printf("  [%10llu .. %10llu] %8llu ", ini, fim, h->faixas[i]);
+        for (int k = 0; k < largura; ++k) putchar('#');
+        putchar('\n');
     }
+}
 
-    while (1) {                       // loop principal da exploração (até 's' ser escolhido)
-        if (cont < MAX_VISITAS) visitadas[cont++] = atual->nome; // registra visita atual
+/* est_jsonHistograma - escreve um histograma como objeto JSON */
+static void est_jsonHistograma(FILE *f, const char *nome, const Histograma *h, int ultimo) {
+    fprintf(f, "  \"%s\": {\"amostras\": %llu, \"soma\": %llu, \"maximo\": %llu, \"faixas\": [",
+            nome, h->amostras, h->soma, h->maximo);
+    for (int i = 0; i < EST_FAIXAS; ++i) fprintf(f, "%s%llu", i ? ", " : "", h->faixas[i]);
+    fprintf(f, "]}%s\n", ultimo ? "" : ",");
+}
 
-        printf("Você está na sala: %s\n", atual->nome); // informa a sala atual
+/* mostrarEstatisticas - imprime contadores e histogramas e grava cópia em JSON no arquivo 'caminho' */
+void mostrarEstatisticas(const char *caminho) {
+    printf("\n--- Estatísticas de desempenho ---\n");
+    printf("str_dup:      %llu alocações, %llu bytes\n", g_est.alocStr, g_est.bytesStr);
+    printf("criarSala:    %llu alocações, %llu bytes\n", g_est.alocSala, g_est.bytesSala);
+    printf("criarNoPista: %llu alocações (slabs do pool), %llu bytes\n", g_est.alocNoPista, g_est.bytesNoPista);
+    mostrarPool();                     // reaproveitamento de nós e textos de pista
+    unsigned long long ausentes = g_est.filtroRejeicoes + g_est.filtroFalsos;
+    printf("filtro hash:  %llu filtros, %llu bytes; %llu buscas ausentes, %llu barradas, %llu falsos positivos (%.2f%%)\n",
+           g_est.alocFiltro, g_est.bytesFiltro, ausentes, g_est.filtroRejeicoes, g_est.filtroFalsos,
+           ausentes ? 100.0 * (double)g_est.filtroFalsos / (double)ausentes : 0.0);
+    est_imprimirHistograma("Sondagens por encontrarSuspeito (buscas do jogo)", &g_est.sondagensHash);
+    est_imprimirHistograma("Profundidade ao coletar na BST/AVL (--colecao bst|avl)", &g_est.profundidadeBST);
+    est_imprimirHistograma("Latência por movimento (ns)", &g_est.latenciaMovNs);
 
-        // mostrar opções dinâmicas dependendo de filhos/pai
-        printf("Opções:\n");
-        if (atual->esq) printf("  (e) Ir para a esquerda -> %s\n", atual->esq->nome); // mostra esquerda se existir
-        if (atual->dir) printf("  (d) Ir para a direita -> %s\n", atual->dir->nome);  // mostra direita se existir
-        if (atual->pai) printf("  (v) Voltar para a sala anterior -> %s\n", atual->pai->nome); // mostra voltar se houver pai
-        else printf("  (v) Voltar (não disponível - você está no Hall de entrada)\n"); // senão, informa indisponibilidade
-        printf("  (s) Encerrar exploração atual e mostrar pistas coletadas\n"); // opção para encerrar
-        printf("Escolha (e/d/v/s): "); // prompt para o usuário
+    FILE *f = fopen(caminho, "w");     // cópia legível por máquina
+    if (!f) {
+        printf("(não foi possível gravar %s)\n", caminho);
+    } else {
+        fprintf(f, "{\n");
+        fprintf(f, "  \"str_dup\": {\"alocacoes\": %llu, \"bytes\": %llu},\n", g_est.alocStr, g_est.bytesStr);
+        fprintf(f, "  \"criarSala\": {\"alocacoes\": %llu, \"bytes\": %llu},\n", g_est.alocSala, g_est.bytesSala);
+        fprintf(f, "  \"criarNoPista\": {\"alocacoes\": %llu, \"bytes\": %llu},\n", g_est.alocNoPista, g_est.bytesNoPista);
+        fprintf(f, "  \"pool_pistas\": {\"pedidos_no\": %llu, \"acertos_no\": %llu, \"pedidos_texto\": %llu, "
+                   "\"acertos_texto\": %llu, \"chamadas_malloc\": %llu, \"bytes_reservados\": %zu},\n",
+                g_pool.pedidosNo, g_pool.acertosNo, g_pool.pedidosTexto, g_pool.acertosTexto,
+                g_pool.chamadasMalloc, g_pool.bytesReservados);
+        fprintf(f, "  \"filtro_hash\": {\"filtros\": %llu, \"bytes\": %llu, \"rejeicoes\": %llu, \"falsos_positivos\": %llu},\n",
+                g_est.alocFiltro, g_est.bytesFiltro, g_est.filtroRejeicoes, g_est.filtroFalsos);
+        est_jsonHistograma(f, "sondagens_hash", &g_est.sondagensHash, 0);
+        est_jsonHistograma(f, "profundidade_bst", &g_est.profundidadeBST, 0);
+        est_jsonHistograma(f, "latencia_movimento_ns", &g_est.latenciaMovNs, 1);
+        fprintf(f, "}\n");
+        fclose(f);
+        printf("(cópia em JSON gravada em %s)\n", caminho);
+    }
+    printf("----------------------------------\n\n");
+}
+#endif
 
-        char c = get_choice();        // lê a escolha (primeiro caractere não branco)
-        if (c == '\0') {              // se leitura falhar ou só espaços
-            printf("\nEntrada finalizada. Retornando ao menu principal.\n");
-            break;
-        }
+/* ---------- Análise de ramificações (modo linha de comando: ./mestre --ramos) ---------- */
 
-        if (c == 's' || c == 'S') {   // encerrar exploração
-            printf("Encerrando exploração e compilando pistas...\n\n");
-            break;                    // sai do loop e volta ao menu
-        } else if ((c == 'e' || c == 'E')) { // ir para a esquerda
-            if (atual->esq) {          // se há sala à esquerda
-                atual = atual->esq;    // atualiza ponteiro para a sala à esquerda
-                printf("\n-- Indo para a esquerda... --\n\n");
-                if (atual->pista) {   // se a nova sala contém pista
-                    *pistas = inserirPista(*pistas, atual->pista); // insere na BST
-                    printf("[Pista encontrada] %s\n", atual->pista); // informa a pista
-                    const char *sus = encontrarSuspeito(ht, atual->pista); // procura suspeito
-                    if (sus) {
-                        printf("  -> Esta pista aponta para: %s\n\n", sus); // mostra suspeito
-                    } else {
-                        printf("  -> Nenhum suspeito associado a esta pista (desconhecido)\n\n");
-                    }
-                }
-            } else {
-                printf("Não há sala à esquerda. Tente outra opção.\n\n"); // caminho inexistente
-            }
-        } else if ((c == 'd' || c == 'D')) { // ir para a direita
-            if (atual->dir) {           // se há sala à direita
-                atual = atual->dir;     // atualiza ponteiro para a sala à direita
-                printf("\n-- Indo para a direita... --\n\n");
-                if (atual->pista) {     // se a nova sala contém pista
-                    *pistas = inserirPista(*pistas, atual->pista); // insere na BST
-                    printf("[Pista encontrada] %s\n", atual->pista); // informa a pista
-                    const char *sus = encontrarSuspeito(ht, atual->pista); // procura suspeito
-                    if (sus) {
-                        printf("  -> Esta pista aponta para: %s\n\n", sus); // mostra suspeito
-                    } else {
-                        printf("  -> Nenhum suspeito associado a esta pista (desconhecido)\n\n");
-                    }
-                }
-            } else {
-                printf("Não há sala à direita. Tente outra opção.\n\n"); // caminho inexistente
-            }
-        } else if ((c == 'v' || c == 'V')) { // voltar ao pai
-            if (atual->pai) {           // se existe nó pai
-                atual = atual->pai;     // atualiza para o nó pai
-                printf("\n-- Voltando para a sala anterior... --\n\n");
-            } else {
-                printf("Você está na raiz (Hall de entrada). Não é possível voltar.\n\n"); // aviso na raiz
-            }
-        } else {
-            printf("Opção inválida. Use 'e', 'd', 'v' ou 's'.\n\n"); // entrada inválida
+/* Estado do percurso de analisarRamos */
+typedef struct Ramos {
+    const Catalogo *cat;      // catálogo (para saber o suspeito de cada pista)
+    const char **caminho;     // nomes das salas do caminho atual
+    unsigned *contagens;      // área de trabalho: evidências por suspeito
+    int imprimir;             // 1 = imprime cada caminho; 0 = só acumula (medições)
+    NoPers **folhas;          // versões finais guardadas (NULL = não guardar)
+    size_t nFolhas;           // caminhos completos encontrados
+    size_t somaTamanhos;      // soma das pistas de todas as versões finais (custo de copiar)
+} Ramos;
+
+/* ramos_visitar - entra em 's' a partir da versão 'v' (ramifica em cada porta) */
+static void ramos_visitar(Ramos *r, const Sala *s, NoPers *v, size_t prof) {
+    NoPers *aqui = s->pistaId >= 0 ? persInserir(v, s->pistaId) : persRamificar(v); // versão desta sala
+    r->caminho[prof] = salaNome(s);
+    if (!s->esq && !s->dir) {          // fim do caminho: relata e/ou guarda a versão
+        r->nFolhas++;
+        r->somaTamanhos += pers_tam(aqui);
+        if (r->imprimir) {
+            for (size_t i = 0; i <= prof; ++i) printf("%s%s", i ? " > " : "  ", r->caminho[i]);
+            printf("\n      %u pistas; provas suficientes contra:", pers_tam(aqui));
+            memset(r->contagens, 0, r->cat->nSuspeitos * sizeof(unsigned));
+            persContarSuspeitos(aqui, r->cat, r->contagens);
+            int algum = 0;
+            for (size_t k = 0; k < r->cat->nSuspeitos; ++k)
+                if (r->contagens[k] >= 2) { printf("%s %s", algum++ ? "," : "", r->cat->suspeitos[k]); }
+            printf("%s\n", algum ? "" : " ninguém");
         }
+        if (r->folhas) r->folhas[r->nFolhas - 1] = persRamificar(aqui);
     }
+    if (s->esq) ramos_visitar(r, s->esq, aqui, prof + 1); // "e se fosse para a esquerda"
+    if (s->dir) ramos_visitar(r, s->dir, aqui, prof + 1); // "e se fosse para a direita"
+    persLiberar(aqui);
+}
 
-    // exibir percurso
-    printf("\n--- Salas visitadas nesta exploração ---\n");
-    for (int i = 0; i < cont; ++i) {     // percorre histórico de visitas
-        printf("%d) %s\n", i + 1, visitadas[i]); // imprime cada sala visitada
-    }
-    printf("----------------------------------------\n\n");
+/* analisarRamos - percorre todos os caminhos do mapa, um ramo persistente por escolha */
+void analisarRamos(const Sala *mapa, const Catalogo *cat) {
+    if (!mapa) return;
+    size_t n = contarSalas(mapa);
+    Ramos r = { cat, malloc(n * sizeof(char *)), calloc(cat->nSuspeitos + 1, sizeof(unsigned)), 1, NULL, 0, 0 };
+    if (!r.caminho || !r.contagens) { fprintf(stderr, "Erro: memória insuficiente na análise.\n"); exit(EXIT_FAILURE); }
+    printf("--- Ramificações do mapa (cada caminho da entrada até um fim) ---\n");
+    ramos_visitar(&r, mapa, NULL, 0);
+    printf("%zu caminhos analisados\n", r.nFolhas);
+    free(r.caminho);
+    free(r.contagens);
 }
 
-/* ---------- Mapa da mansão (com pistas) ---------- */
+/* ---------- Simulação de jogadores (modo linha de comando: ./mestre --simular) ---------- */
+
+/* rng_proximo - gerador xorshift64* (rápido e reprodutível para a simulação) */
+static unsigned long long rng_proximo(unsigned long long *estado) {
+    unsigned long long x = *estado;
+    x ^= x >> 12; x ^= x << 25; x ^= x >> 27;
+    *estado = x;
+    return x * 2685821657736338717ull;
+}
 
 /*
- * montarMapaComPistas - cria e retorna o mapa fixo da mansão (árvore binária),
- * com pistas associadas a algumas salas.
+ * Cada sessão simulada começa no Hall, coleta a pista de toda sala em que
+ * entra (como explorarSalasComPistas) e termina quando o jogador desiste.
+ * Dois perfis de jogador:
+ *   aleatório - a cada passo desiste com a probabilidade dada; senão escolhe
+ *               uniformemente entre as portas existentes (e/d/v);
+ *   guloso    - desiste com a mesma probabilidade, mas entra numa sala filha
+ *               ainda não visitada sempre que houver e só volta quando não
+ *               há nenhuma; encerra ao voltar ao Hall com tudo visitado.
+ * As sessões são divididas em lotes de SIM_LOTE. O lote b usa um gerador
+ * semeado com (semente, b) e é sempre simulado pela thread b % nThreads, que
+ * soma contagens inteiras no seu próprio SimAcumulador; a soma final não
+ * depende da ordem, então a mesma semente dá o mesmo resultado com qualquer
+ * número de threads.
  */
-Sala *montarMapaComPistas(void) {     // monta a árvore do mapa com pistas em algumas salas
-    // criar nós com nome e pista (pista = NULL se não houver)
-    Sala *hall = criarSala("Hall de entrada", "Uma luva de couro com sangue seco"); // raiz com pista
+#define SIM_LOTE       4096            // sessões por lote (unidade de semeadura do gerador)
+#define SIM_MAX_PASSOS 100000          // passos por sessão (proteção contra desistência 0)
 
-    Sala *salaEstar = criarSala("Sala de estar", "Vidro quebrado perto do lareira"); // nó com pista
-    Sala *biblioteca = criarSala("Biblioteca", NULL); // sem pista
+/* SimAcumulador - contagens de uma thread (somadas às das outras ao final) */
+typedef struct SimAcumulador {
+    unsigned long long *visitas;      // [nSalas] sessões que entraram em cada sala
+    unsigned long long *descobertas;  // [nPistas] sessões que encontraram cada pista
+    unsigned long long *procedentes;  // [nSuspeitos] sessões em que acusar o suspeito seria procedente
+    unsigned long long nenhum;        // sessões sem provas suficientes contra ninguém
+    unsigned long long sessoes;       // sessões simuladas
+    unsigned long long passos;        // movimentos somados de todas as sessões
+} SimAcumulador;
 
-    Sala *cozinha = criarSala("Cozinha", "Pegadas molhadas levando à despensa"); // nó com pista
-    Sala *salaJantar = criarSala("Sala de jantar", "Uma vela apagada com cera vermelha"); // nó com pista
+/* SimTarefa - parâmetros e resultado de uma thread da simulação */
+typedef struct SimTarefa {
+    const Catalogo *cat;              // mapa numerado, pistas e máscaras dos suspeitos
+    int guloso;                       // perfil do jogador (0 = aleatório)
+    unsigned long long limite;        // desiste quando rng_proximo() < limite
+    unsigned long long semente;       // semente da simulação inteira
+    unsigned long long nSessoes;      // total de sessões (de todas as threads)
+    unsigned id, nThreads;            // esta thread pega os lotes id, id + nThreads, ...
+    SimAcumulador acum;               // contagens desta thread
+} SimTarefa;
 
-    Sala *escritorio = criarSala("Escritório", "Um bilhete amassado com iniciais 'R.M.'"); // pista
-    Sala *observatorio = criarSala("Observatório", "Lentes riscada e uma gota de óleo"); // pista
+/* sim_semente - estado inicial do gerador do lote 'lote' (mistura splitmix64; nunca zero) */
+static unsigned long long sim_semente(unsigned long long semente, unsigned long long lote) {
+    unsigned long long z = semente + (lote + 1) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    return z ? z : 1;
+}
 
-    Sala *despensa = criarSala("Despensa", "Caixa vazia de comprimidos"); // folha com pista
-    Sala *jardimInterno = criarSala("Jardim interno", NULL); // sem pista
-    Sala *torre = criarSala("Torre de vigia", "Pegada solitária no corrimão"); // folha com pista
+/* sim_sessao - simula uma sessão e soma o que ela visitou e descobriu em 'a' */
+static void sim_sessao(const SimTarefa *t, SimAcumulador *a, unsigned long long *rng,
+                       ConjuntoPistas *salas, ConjuntoPistas *pistas) {
+    const Catalogo *cat = t->cat;
+    conjLimpar(salas);                 // conjunto de IDs de sala visitados nesta sessão
+    conjLimpar(pistas);
+    const Sala *atual = cat->salas[0];
+    unsigned long long passos = 0;
+    for (;;) {
+        if (conjInserir(salas, (size_t)atual->id) && atual->pistaId >= 0)
+            conjInserir(pistas, (size_t)atual->pistaId); // entrou na sala: coleta a pista
+        if (passos >= SIM_MAX_PASSOS || rng_proximo(rng) < t->limite) break; // desistiu
+        const Sala *portas[3];
+        int n = 0;
+        if (t->guloso) {
+            if (atual->esq && !conjContem(salas, (size_t)atual->esq->id)) portas[n++] = atual->esq;
+            if (atual->dir && !conjContem(salas, (size_t)atual->dir->id)) portas[n++] = atual->dir;
+            if (n == 0 && atual->pai) portas[n++] = atual->pai; // nada novo aqui: volta
+        } else {
+            if (atual->esq) portas[n++] = atual->esq;
+            if (atual->dir) portas[n++] = atual->dir;
+            if (atual->pai) portas[n++] = atual->pai;
+        }
+        if (n == 0) break;             // sem para onde ir (guloso no Hall com tudo visitado)
+        atual = portas[n == 1 ? 0 : (rng_proximo(rng) >> 32) % (unsigned)n];
+        passos++;
+    }
 
-    // conectar árvore e ajustar ponteiros 'pai'
-    conectarFilhos(hall, salaEstar, biblioteca);       // hall -> (salaEstar, biblioteca)
-    conectarFilhos(salaEstar, cozinha, salaJantar);    // salaEstar -> (cozinha, salaJantar)
-    conectarFilhos(biblioteca, escritorio, observatorio); // biblioteca -> (escritorio, observatorio)
-    conectarFilhos(cozinha, despensa, jardimInterno); // cozinha -> (despensa, jardimInterno)
-    conectarFilhos(observatorio, NULL, torre);         // observatorio -> (NULL, torre)
+    for (size_t w = 0; w < salas->nPalavras; ++w)
+        for (uint64_t bits = salas->palavras[w]; bits; bits &= bits - 1)
+            a->visitas[w * 64 + (size_t)__builtin_ctzll(bits)]++;
+    for (size_t w = 0; w < pistas->nPalavras; ++w)
+        for (uint64_t bits = pistas->palavras[w]; bits; bits &= bits - 1)
+            a->descobertas[w * 64 + (size_t)__builtin_ctzll(bits)]++;
+    int algum = 0;
+    for (size_t s = 0; s < cat->nSuspeitos; ++s) // mesma regra de verificarSuspeitoFinal (>= 2 pistas)
+        if (evidenciasContra(cat, pistas, (int)s) >= 2) { a->procedentes[s]++; algum = 1; }
+    a->nenhum += !algum;
+    a->sessoes++;
+    a->passos += passos;
+}
 
-    return hall;                                      // retorna a raiz do mapa montado
+/* sim_thread - simula os lotes desta thread com acumulador e conjuntos próprios */
+static void *sim_thread(void *arg) {
+    SimTarefa *t = arg;
+    SimAcumulador a = t->acum;         // cópia local: os contadores escalares não disputam linha de cache
+    ConjuntoPistas *salas = conjCriar(t->cat->nSalas);
+    ConjuntoPistas *pistas = conjCriar(t->cat->nPistas);
+    unsigned long long nLotes = (t->nSessoes + SIM_LOTE - 1) / SIM_LOTE;
+    for (unsigned long long b = t->id; b < nLotes; b += t->nThreads) {
+        unsigned long long rng = sim_semente(t->semente, b);
+        unsigned long long fim = (b + 1) * SIM_LOTE < t->nSessoes ? (b + 1) * SIM_LOTE : t->nSessoes;
+        for (unsigned long long i = b * SIM_LOTE; i < fim; ++i) sim_sessao(t, &a, &rng, salas, pistas);
+    }
+    conjLiberar(salas);
+    conjLiberar(pistas);
+    t->acum = a;
+    return NULL;
 }
 
-/* ---------- Verificação final: acusação e julgamento (mantida) ---------- */
+/* sim_percentual - fração de 'n' sobre 'total' em % */
+static double sim_percentual(unsigned long long n, unsigned long long total) {
+    return total ? 100.0 * (double)n / (double)total : 0.0;
+}
 
 /*
- * verificarSuspeitoFinal - dado o BST de pistas coletadas e a tabela hash
- * (pista -> suspeito), conta quantas pistas apontam para o suspeito acusado.
- * Retorna 1 se existirem pelo menos 2 pistas que apontam para o acusado, 0 caso contrário.
+ * simularJogadores - roda 'nSessoes' explorações simuladas em 'nThreads'
+ * threads e imprime, para cada sala, pista e suspeito, a fração das sessões
+ * em que a sala foi visitada, a pista encontrada e a acusação seria
+ * procedente. 'desistencia' é a chance (0..1) de desistir a cada passo.
+ * A assinatura impressa ao final resume todas as contagens, para conferir
+ * que outra execução com a mesma semente deu o mesmo resultado.
  */
-int verificarSuspeitoFinal(NoPista *arvorePistas, HashTable *ht, const char *acusado) {
-    if (!acusado) return 0;            // proteção: acusado invalido
-    int contador = 0;                  // contador de pistas que apontam para o acusado
+int simularJogadores(const Catalogo *cat, unsigned long long nSessoes, unsigned long long semente,
+                     unsigned nThreads, int guloso, double desistencia) {
+    if (!cat->nSalas) { printf("Mapa vazio. Nada a simular.\n"); return 0; }
+    if (nThreads < 1) nThreads = 1;
+    if (desistencia < 0.0) desistencia = 0.0;
+    SimTarefa *tarefas = calloc(nThreads, sizeof(SimTarefa));
+    pthread_t *threads = malloc(nThreads * sizeof(pthread_t));
+    int *criada = calloc(nThreads, sizeof(int));
+    if (!tarefas || !threads || !criada) { fprintf(stderr, "Erro: memória insuficiente na simulação.\n"); exit(EXIT_FAILURE); }
+    unsigned long long limite = desistencia >= 1.0 ? ~0ull : (unsigned long long)(desistencia * 18446744073709551616.0);
 
-    // função local recursiva para percorrer BST e contar ocorrências
-    void contar(NoPista *n) {
-        if (!n) return;
-        contar(n->esq);                // visitar esquerda
-        const char *s = encontrarSuspeito(ht, n->texto); // consulta suspeito associado à pista
-        if (s && strcmp(s, acusado) == 0) { // se pista aponta para o acusado
-            contador++;                // incrementa contador
+    unsigned long long t0 = agora_ns();
+    for (unsigned i = 0; i < nThreads; ++i) {
+        SimTarefa *t = &tarefas[i];
+        t->cat = cat;
+        t->guloso = guloso;
+        t->limite = limite;
+        t->semente = semente;
+        t->nSessoes = nSessoes;
+        t->id = i;
+        t->nThreads = nThreads;
+        t->acum.visitas = calloc(cat->nSalas, sizeof(unsigned long long));
+        t->acum.descobertas = calloc(cat->nPistas + 1, sizeof(unsigned long long));
+        t->acum.procedentes = calloc(cat->nSuspeitos + 1, sizeof(unsigned long long));
+        if (!t->acum.visitas || !t->acum.descobertas || !t->acum.procedentes) {
+            fprintf(stderr, "Erro: memória insuficiente na simulação.\n");
+            exit(EXIT_FAILURE);
         }
-        contar(n->dir);                // visitar direita
+        criada[i] = pthread_create(&threads[i], NULL, sim_thread, t) == 0;
+        if (!criada[i]) sim_thread(t); // sem thread disponível: simula os lotes aqui mesmo
+    }
+    for (unsigned i = 0; i < nThreads; ++i)
+        if (criada[i]) pthread_join(threads[i], NULL);
+    unsigned long long t = agora_ns() - t0;
+
+    // junta os acumuladores na tarefa 0
+    SimAcumulador *total = &tarefas[0].acum;
+    for (unsigned i = 1; i < nThreads; ++i) {
+        SimAcumulador *a = &tarefas[i].acum;
+        for (size_t k = 0; k < cat->nSalas; ++k) total->visitas[k] += a->visitas[k];
+        for (size_t k = 0; k < cat->nPistas; ++k) total->descobertas[k] += a->descobertas[k];
+        for (size_t k = 0; k < cat->nSuspeitos; ++k) total->procedentes[k] += a->procedentes[k];
+        total->nenhum += a->nenhum;
+        total->sessoes += a->sessoes;
+        total->passos += a->passos;
+    }
+
+    printf("Simulação: %llu sessões, jogador %s, desistência %.1f%% por passo, semente %llu, %u threads\n",
+           total->sessoes, guloso ? "guloso" : "aleatório", desistencia * 100.0, semente, nThreads);
+    printf("  tempo: %.1f ms (%.0f sessões/s), %.1f movimentos por sessão\n", (double)t / 1e6,
+           t ? (double)total->sessoes * 1e9 / (double)t : 0.0,
+           total->sessoes ? (double)total->passos / (double)total->sessoes : 0.0);
+    unsigned long long assinatura = 1469598103934665603ull; // FNV-1a sobre todas as contagens
+#define SIM_ASSINAR(v) (assinatura = (assinatura ^ (v)) * 1099511628211ull)
+    printf("  Salas visitadas (%% das sessões):\n");
+    for (size_t k = 0; k < cat->nSalas; ++k) {
+        printf("    %-28s %6.2f%%\n", salaNome(cat->salas[k]), sim_percentual(total->visitas[k], total->sessoes));
+        SIM_ASSINAR(total->visitas[k]);
+    }
+    printf("  Pistas encontradas (%% das sessões):\n");
+    for (size_t k = 0; k < cat->nPistas; ++k) {
+        int s = cat->suspeitoDaPista[k];
+        printf("    %6.2f%%  %s (-> %s)\n", sim_percentual(total->descobertas[k], total->sessoes),
+               cat->pistas[k], s >= 0 ? cat->suspeitos[s] : "desconhecido");
+        SIM_ASSINAR(total->descobertas[k]);
     }
+    printf("  Acusação procedente (pelo menos 2 pistas) contra:\n");
+    for (size_t k = 0; k < cat->nSuspeitos; ++k) {
+        printf("    %-28s %6.2f%%\n", cat->suspeitos[k], sim_percentual(total->procedentes[k], total->sessoes));
+        SIM_ASSINAR(total->procedentes[k]);
+    }
+    printf("    %-28s %6.2f%%\n", "ninguém", sim_percentual(total->nenhum, total->sessoes));
+    SIM_ASSINAR(total->nenhum);
+    SIM_ASSINAR(total->passos);
+#undef SIM_ASSINAR
+    printf("  assinatura dos resultados: %016llx\n", assinatura);
 
-    contar(arvorePistas);              // inicia a contagem a partir da raiz da BST
+    for (unsigned i = 0; i < nThreads; ++i) {
+        free(tarefas[i].acum.visitas);
+        free(tarefas[i].acum.descobertas);
+        free(tarefas[i].acum.procedentes);
+    }
+    free(criada);
+    free(threads);
+    free(tarefas);
+    return 0;
+}
 
-    return (contador >= 2) ? 1 : 0;    // retorna verdadeiro se houver ao menos duas pistas
+/* mostrarReproducao - resumo do estado reconstruído, com nomes do mapa atual */
+static void mostrarReproducao(const Reproducao *r, const Catalogo *cat) {
+    printf("Eventos decodificados: %llu (posição %llu no diário)\n",
+           (unsigned long long)r->lidos, (unsigned long long)r->eventos);
+    printf("Sessões concluídas: %u; movimentos %llu, pistas %llu, consultas %llu (%llu sem suspeito)\n",
+           r->sessoes, (unsigned long long)r->movimentos, (unsigned long long)r->pistas,
+           (unsigned long long)r->consultas, (unsigned long long)r->consultasVazias);
+    printf("Acusações: %llu (%llu procedentes)\n", (unsigned long long)r->acusacoes, (unsigned long long)r->procedentes);
+    printf("Pistas vistas em alguma sessão: %zu de %zu\n", conjContar(r->vistas), cat->nPistas);
+    if (r->inteiras) {                 // a interseção só conhece as sessões lidas aqui (os pontos guardam a união)
+        printf("Pistas achadas em todas as %u sessões lidas: %zu\n", r->inteiras, conjContar(r->emTodas));
+        exibirPistasConjunto(cat, r->emTodas);
+    }
+    if (r->salaAtual >= 0 && (size_t)r->salaAtual < cat->nSalas) // diário terminou no meio de uma sessão
+        printf("Sessão %u em andamento, jogador em: %s\n", r->sessaoAtual, salaNome(cat->salas[r->salaAtual]));
 }
 
 /* ---------- Função principal (menu) com hash e julgamento ---------- */
 
-int main(void) {                   // função principal do programa
+#ifndef DQ_SEM_JOGO  // bench_mestre.c inclui este arquivo inteiro e traz o próprio main
+/* colecaoPorNome - coleção do motor pedida na linha de comando; NULL = conjunto em bitset */
+static const ColecaoOps *colecaoPorNome(const char *nome) {
+    if (strcmp(nome, COLECAO_BST.nome) == 0) return &COLECAO_BST;
+    if (strcmp(nome, COLECAO_AVL.nome) == 0) return &COLECAO_AVL;
+    if (strcmp(nome, "bitset") != 0)
+        fprintf(stderr, "Aviso: coleção desconhecida %s (use bitset, bst ou avl); usando bitset.\n", nome);
+    return NULL;
+}
+
+int main(int argc, char **argv) {  // função principal do programa
+    // modos pela linha de comando (o jogo interativo roda sem argumentos; as medições ficam em bench_mestre.c)
+    if (argc > 2 && strcmp(argv[1], "--reproduzir") == 0) { // reconstrói o estado a partir de um diário
+        Sala *m = montarMapaComPistas();
+        HashTable *h = montarAssociacoes();
+        Catalogo *c = criarCatalogo(m, h);
+        Reproducao r;
+        unsigned long long t0 = agora_ns();
+        int erro = reproduzirDiario(argv[2], argc > 3 ? (uint32_t)strtoul(argv[3], NULL, 10) : 0, c, &r);
+        unsigned long long t = agora_ns() - t0;
+        if (erro == DIARIO_OUTRO_CATALOGO) {
+            fprintf(stderr, "Erro: %s foi gravado com outro catálogo de pistas (ou num formato antigo); os IDs não valem para este mapa.\n", argv[2]);
+        } else if (erro) {
+            fprintf(stderr, "Erro: %s não é um diário válido.\n", argv[2]);
+        } else {
+            mostrarReproducao(&r, c);
+            printf("Tempo: %.3f ms\n", (double)t / 1e6);
+            liberarReproducao(&r);
+        }
+        liberarCatalogo(c);
+        liberarHashTable(h);
+        liberarSalas(m);
+        return erro ? 1 : 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "--grafo") == 0) { // mansão no modo grafo, com acusação ao final
+        Sala *m = montarMapaComPistas();
+        HashTable *h = montarAssociacoes();
+        Catalogo *c = criarCatalogo(m, h);
+        MapaGrafo *g = grafoDaArvore(c);
+        ConjuntoPistas *coletadas = conjCriar(c->nPistas);
+        explorarGrafo(g, h, coletadas, c);
+        char acusacao[128];
+        printf("Quem você acusa? Digite o nome do suspeito: ");
+        if (conjContar(coletadas) && lerLinha(acusacao, sizeof(acusacao))) {
+            acusacao[strcspn(acusacao, "\n")] = '\0';
+            int sid = buscarSuspeitoId(c, acusacao);
+            printf("\nVocê acusou: %s\n", sid >= 0 ? c->suspeitos[sid] : acusacao);
+            if (sid < 0) exp_mostrarSugestoes(c, acusacao);
+            printf(evidenciasContra(c, coletadas, sid) >= 2
+                   ? "Desfecho: Acusação procedente — caso encaminhado às autoridades.\n"
+                   : "Desfecho: Acusação improcedente — investigue mais pistas.\n");
+        }
+        conjLiberar(coletadas);
+        liberarGrafo(g);
+        liberarCatalogo(c);
+        liberarHashTable(h);
+        liberarSalas(m);
+        return 0;
+    }
+    if (argc > 2 && strcmp(argv[1], "--servidor") == 0) { // --servidor <socket Unix | porta TCP local> [arquivo de mundo]
+        VersaoMundo *v;
+        if (argc > 3) {
+            char erro[256];
+            v = carregarMundo(argv[3], erro, sizeof(erro));
+            if (!v) { fprintf(stderr, "Erro: %s\n", erro); return 1; }
+        } else {
+            v = versaoCriar(montarMapaComPistas(), montarAssociacoes(), "embutido");
+        }
+        return servidorJogo(argv[2], v, argc > 3 ? argv[3] : NULL);
+    }
+    if (argc > 1 && strcmp(argv[1], "--exportar-mundo") == 0) { // mundo embutido no formato do arquivo de mundo
+        Sala *m = montarMapaComPistas();
+        HashTable *h = montarAssociacoes();
+        exportarMundo(stdout, m, h, "embutido");
+        liberarHashTable(h);
+        liberarSalas(m);
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "--lote") == 0) { // --lote [bitset|bst|avl] [arquivo de mundo]: sessões lidas da entrada padrão
+        VersaoMundo *v;
+        if (argc > 3) {
+            char erro[256];
+            v = carregarMundo(argv[3], erro, sizeof(erro));
+            if (!v) { fprintf(stderr, "Erro: %s\n", erro); return 1; }
+        } else {
+            v = versaoCriar(montarMapaComPistas(), montarAssociacoes(), "embutido");
+        }
+        Mundo mundo = v->mundo;        // cópia: a coleção escolhida vale só para o lote
+        mundo.motor.colecaoOps = argc > 2 ? colecaoPorNome(argv[2]) : NULL;
+        int r = jogarLote(&mundo);
+        liberarVersaoMundo(v);
+        liberarPool();                 // slabs da BST de pistas (só com --lote bst)
+        return r;
+    }
+    if (argc > 1 && strcmp(argv[1], "--ramos") == 0) { // todos os caminhos do mapa real
+        Sala *m = montarMapaComPistas();
+        HashTable *h = montarAssociacoes();
+        Catalogo *c = criarCatalogo(m, h);
+        analisarRamos(m, c);
+        liberarCatalogo(c);
+        liberarHashTable(h);
+        liberarSalas(m);
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "--simular") == 0) { // --simular [sessões] [semente] [threads] [aleatorio|guloso] [desistência %]
+        Sala *m = montarMapaComPistas();
+        HashTable *h = montarAssociacoes();
+        Catalogo *c = criarCatalogo(m, h);
+        long nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+        int r = simularJogadores(c, argc > 2 ? strtoull(argv[2], NULL, 10) : 1000000,
+                                 argc > 3 ? strtoull(argv[3], NULL, 10) : 42,
+                                 argc > 4 ? (unsigned)strtoul(argv[4], NULL, 10) : (nucleos > 0 ? (unsigned)nucleos : 1),
+                                 argc > 5 && strcmp(argv[5], "guloso") == 0,
+                                 (argc > 6 ? strtod(argv[6], NULL) : 5.0) / 100.0);
+        liberarCatalogo(c);
+        liberarHashTable(h);
+        liberarSalas(m);
+        return r;
+    }
+
     Sala *mapa = montarMapaComPistas();    // monta o mapa com pistas já associadas
     char opcao[64];                 // buffer para leitura da opção do menu
 
-    // criar e preencher tabela hash com associações pista -> suspeito
-    HashTable *ht = criarHashTable(97); // cria tabela hash com 97 buckets (primo razoável para demo)
-    // inserir associações conhecidas (chave = texto da pista, valor = suspeito)
-    inserirNaHash(ht, "Uma luva de couro com sangue seco", "Sr. Andrade");
-    inserirNaHash(ht, "Vidro quebrado perto do lareira", "Sra. Monteiro");
-    inserirNaHash(ht, "Pegadas molhadas levando à despensa", "Sr. Andrade");
-    inserirNaHash(ht, "Uma vela apagada com cera vermelha", "Sra. Monteiro");
-    inserirNaHash(ht, "Um bilhete amassado com iniciais 'R.M.'", "R. Martins");
-    inserirNaHash(ht, "Lentes riscada e uma gota de óleo", "Dr. Silva");
-    inserirNaHash(ht, "Caixa vazia de comprimidos", "Dr. Silva");
-    inserirNaHash(ht, "Pegada solitária no corrimão", "R. Martins");
+    HashTable *ht = montarAssociacoes(); // cria e preenche a tabela hash pista -> suspeito
+
+    // catálogo: IDs de pistas e suspeitos, usados pelos conjuntos em bitset
+    Catalogo *cat = criarCatalogo(mapa, ht);
+    ConjuntoPistas *coletadas = conjCriar(cat->nPistas);   // pistas da exploração atual
+
+    // --diario <arquivo>: joga normalmente registrando cada sessão no diário
+    // --colecao bst|avl: pistas numa árvore do motor (a BST usa o pool de nós) em vez do bitset
+    Diario *diario = NULL;
+    const ColecaoOps *colecao = NULL; // NULL = conjunto em bitset
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--diario") == 0) {
+            diario = diarioAbrir(argv[i + 1], cat);
+            if (!diario) fprintf(stderr, "Aviso: não foi possível abrir o diário %s.\n", argv[i + 1]);
+        } else if (strcmp(argv[i], "--colecao") == 0) {
+            colecao = colecaoPorNome(argv[i + 1]);
+        }
+    }
 
     while (1) {                     // loop do menu principal (repete até escolher sair)
         printf("=====================================\n"); // cabeçalho do menu
@@ -476,40 +4104,54 @@ int main(void) {                   // função principal do programa
         printf("1 - Explorar a mansão (coletar pistas)\n"); // opção 1: explorar e coletar pistas
         printf("2 - Mostrar associações pista -> suspeito\n"); // opção 2: ver tabela hash
         printf("3 - Sair do jogo\n");      // opção 3: encerrar o programa
+#ifdef DQ_ESTATISTICAS
+        printf("4 - Estatísticas de desempenho\n"); // opção 4: relatório da instrumentação
+#endif
         printf("Escolha: ");               // prompt para o usuário
-        if (!fgets(opcao, sizeof(opcao), stdin)) break; // leitura da opção; se falhar, sai do loop
+        if (!lerLinha(opcao, sizeof(opcao))) break; // leitura da opção; se falhar, sai do loop
 
         if (opcao[0] == '1') {        // se o usuário escolheu '1'
-            NoPista *arvorePistas = NULL;    // BST vazia para armazenar pistas desta exploração
-            explorarSalasComPistas(mapa, &arvorePistas, ht); // inicia exploração e coleta pistas, mostrando suspeitos
+            conjLimpar(coletadas);            // conjunto em bitset reaproveitado entre explorações
+            diarioSessaoInicio(diario);       // ponto de retomada para a reprodução
+            void *pistas = NULL;              // coleção da exploração (só com --colecao)
+            explorarSalasComPistas(mapa, colecao, colecao ? &pistas : NULL, colecao ? NULL : coletadas,
+                                   ht, diario, cat); // inicia exploração e coleta pistas, mostrando suspeitos
+            size_t nColetadas = colecao ? colecao->tamanho(pistas) : conjContar(coletadas);
 
             // mostrar pistas coletadas em ordem alfabética
             printf("Pistas coletadas (em ordem alfabética):\n");
-            if (!arvorePistas) {     // se nenhuma pista foi coletada
+            if (!nColetadas) {       // se nenhuma pista foi coletada
                 printf(" (nenhuma pista encontrada nesta exploração)\n");
+            } else if (colecao) {
+                colecao->emOrdem(pistas, exp_imprimirPista, NULL); // percurso em ordem da árvore
             } else {
-                exibirPistas(arvorePistas); // imprime a BST em ordem (alfabética)
+                exibirPistasConjunto(cat, coletadas); // varredura dos bits: IDs já estão em ordem alfabética
             }
             printf("\n");
 
             // fase de acusação: pedir ao jogador para indicar um suspeito
-            if (arvorePistas) {    // apenas se houver pistas coletadas
+            if (nColetadas) {      // apenas se houver pistas coletadas
                 char acusacao[128]; // buffer para nome do suspeito acusado
                 printf("Quem você acusa? Digite o nome do suspeito: ");
-                if (fgets(acusacao, sizeof(acusacao), stdin)) { // ler linha com o nome
+                if (lerLinha(acusacao, sizeof(acusacao))) { // ler linha com o nome
                     // remover eventual newline
                     size_t L = strlen(acusacao);
                     if (L > 0 && acusacao[L-1] == '\n') acusacao[L-1] = '\0';
 
-                    // verificar se existem pelo menos duas pistas apontando para esse suspeito
-                    int acertou = verificarSuspeitoFinal(arvorePistas, ht, acusacao);
+                    // resolver o nome para o ID do suspeito (sem exigir a grafia exata) e
+                    // verificar se existem pelo menos duas pistas apontando para ele
+                    int sid = buscarSuspeitoId(cat, acusacao);
+                    const char *acusado = sid >= 0 ? cat->suspeitos[sid] : acusacao;
+                    int acertou = colecao ? sid >= 0 && verificarSuspeitoFinal(colecao, pistas, ht, acusado)
+                                          : evidenciasContra(cat, coletadas, sid) >= 2;
+                    diarioAcusacao(diario, sid, acertou, acusacao);
+                    printf("\nVocê acusou: %s\n", acusado);
+                    if (sid < 0) exp_mostrarSugestoes(cat, acusacao);
                     if (acertou) {
-                        printf("\nVocê acusou: %s\n", acusacao);
-                        printf("Resultado: Há pistas suficientes que apontam para %s.\n", acusacao);
+                        printf("Resultado: Há pistas suficientes que apontam para %s.\n", acusado);
                         printf("Desfecho: Acusação procedente — caso encaminhado às autoridades.\n\n");
                     } else {
-                        printf("\nVocê acusou: %s\n", acusacao);
-                        printf("Resultado: Não há pistas suficientes (pelo menos 2) que apontem para %s.\n", acusacao);
+                        printf("Resultado: Não há pistas suficientes (pelo menos 2) que apontem para %s.\n", acusado);
                         printf("Desfecho: Acusação improcedente — investigue mais pistas.\n\n");
                     }
                 } else {
@@ -519,19 +4161,28 @@ int main(void) {                   // função principal do programa
                 printf("Sem pistas, não há como acusar com fundamento. Volte e explore mais.\n\n");
             }
 
-            // liberar a árvore de pistas desta exploração (libera memória)
-            liberarPistas(arvorePistas);
+            if (colecao) colecao->liberar(pistas); // na BST, nós e textos voltam ao pool
+            diarioSessaoFim(diario);          // grava a sessão inteira no diário de uma vez
         } else if (opcao[0] == '2') { // mostrar associações pista -> suspeito
             mostrarAssociacoes(ht);   // exibe todas as associações conhecidas
         } else if (opcao[0] == '3') { // se o usuário escolheu '3'
             printf("Saindo do jogo... até a próxima!\n"); // mensagem de despedida
             break;                    // sai do loop principal, encerra o programa
+#ifdef DQ_ESTATISTICAS
+        } else if (opcao[0] == '4') { // relatório de estatísticas
+            mostrarEstatisticas("dq_estatisticas.json"); // imprime histogramas e grava o JSON
+#endif
         } else {
             printf("Opção inválida! Tente novamente.\n\n"); // aviso para entrada inválida
         }
     }
 
+    conjLiberar(coletadas);          // libera o conjunto em bitset
+    liberarCatalogo(cat);            // libera o catálogo de pistas e suspeitos
+    diarioFechar(diario);            // grava o que faltar e fecha o diário
     liberarHashTable(ht);            // libera a tabela hash e suas strings
     liberarSalas(mapa);              // libera todo o mapa da mansão e pistas associadas
+    liberarPool();                   // devolve ao sistema os slabs do pool de pistas
     return 0;                        // retorna 0 indicando término normal
 }
+#endif
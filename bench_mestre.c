@@ -0,0 +1,1825 @@
+// TEMA 4 - MEDIÇÕES DO MESTRE
+
+/*
+ * Microbenchmarks do nível Mestre: layout das salas, conjuntos em bitset,
+ * pool de pistas, tabela hash, filtro de Bloom, diário, grafo, catálogo de
+ * suspeitos, sessões e o gerador de carga do servidor. Ficam fora do jogo
+ * para que Mestre.c guarde só o jogo e os seus modos de uso (--diario,
+ * --reproduzir, --grafo, --servidor, --lote, --ramos, --simular).
+ *
+ * Mestre.c entra inteiro nesta unidade (sem o main do jogo, por causa de
+ * DQ_SEM_JOGO), então as medições usam as mesmas funções estáticas do jogo.
+ *
+ * Compilação e uso:
+ *   gcc -std=gnu11 -O2 bench_mestre.c motor.c -o bench_mestre -pthread
+ *   ./bench_mestre --bench-suspeitos 100000
+ *   ./bench_mestre --carga /tmp/dq.sock 10000 100   (com ./mestre --servidor /tmp/dq.sock)
+ */
+
+#define DQ_SEM_JOGO
+#include "Mestre.c"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>  // __rdtsc — ciclos por operação nas medições da tabela hash.
+#endif
+#ifdef __GLIBC__
+#include <malloc.h>     // malloc_usable_size, malloc_trim — tamanho real dos blocos e liberação nas medições.
+#endif
+#include <sys/wait.h>   // waitpid — servidor de teste num processo filho.
+#include <dirent.h>     // opendir — descritores abertos do servidor de teste (/proc/<pid>/fd).
+
+/* ---------- Layout, bitset e pool ---------- */
+
+/* bytesHeap - bytes efetivamente ocupados por um bloco do malloc (estimativa fora da glibc) */
+static size_t bytesHeap(void *p, size_t pedido) {
+    if (!p) return 0;
+#ifdef __GLIBC__
+    (void)pedido;
+    return malloc_usable_size(p) + sizeof(size_t); // área útil + cabeçalho do bloco
+#else
+    return ((pedido + sizeof(size_t) + 15) & ~(size_t)15); // arredonda como um malloc típico
+#endif
+}
+
+/* textos reais do mapa, usados para gerar mapas grandes com a mesma distribuição de tamanhos */
+static const char *const NOMES_REAIS[] = {
+    "Hall de entrada", "Sala de estar", "Biblioteca", "Cozinha", "Sala de jantar",
+    "Escritório", "Observatório", "Despensa", "Jardim interno", "Torre de vigia"
+};
+static const char *const PISTAS_REAIS[] = {
+    "Uma luva de couro com sangue seco", "Vidro quebrado perto do lareira", NULL,
+    "Pegadas molhadas levando à despensa", "Uma vela apagada com cera vermelha",
+    "Um bilhete amassado com iniciais 'R.M.'", "Lentes riscada e uma gota de óleo",
+    "Caixa vazia de comprimidos", NULL, "Pegada solitária no corrimão"
+};
+#define N_TEXTOS_REAIS (sizeof(NOMES_REAIS) / sizeof(NOMES_REAIS[0]))
+
+/* SalaAntiga - layout original (nome e pista como ponteiros para str_dup), só para comparação */
+typedef struct SalaAntiga {
+    char *nome, *pista;
+    struct SalaAntiga *esq, *dir, *pai;
+} SalaAntiga;
+
+/*
+ * benchLayout - compara o layout com StrCurta contra o layout antigo em uma
+ * árvore completa de 'n' salas: memória por nó e velocidade de navegação
+ * (descidas aleatórias da raiz até uma folha lendo o nome de cada sala).
+ */
+int benchLayout(size_t n) {
+    if (n < 1) n = 1;
+    const size_t PASSOS = 20000000;    // movimentos medidos em cada layout
+    Sala **novas = malloc(n * sizeof(Sala *));
+    SalaAntiga **antigas = malloc(n * sizeof(SalaAntiga *));
+    if (!novas || !antigas) {
+        fprintf(stderr, "Erro: memória insuficiente para a medição.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t memNova = 0, memAntiga = 0; // bytes de heap ocupados por cada layout
+    for (size_t i = 0; i < n; ++i) {   // mesma sequência de textos nos dois layouts
+        const char *nome = NOMES_REAIS[i % N_TEXTOS_REAIS];
+        const char *pista = PISTAS_REAIS[(i / N_TEXTOS_REAIS) % N_TEXTOS_REAIS];
+
+        novas[i] = criarSala(nome, pista);
+        memNova += bytesHeap(novas[i], sizeof(Sala));
+        if (novas[i]->pista.interno[STRC_INTERNO] == STRC_HEAP)
+            memNova += bytesHeap(novas[i]->pista.heap, strlen(pista) + 1);
+
+        SalaAntiga *a = malloc(sizeof(SalaAntiga));
+        if (!a) { fprintf(stderr, "Erro: memória insuficiente para a medição.\n"); exit(EXIT_FAILURE); }
+        a->nome = str_dup(nome);
+        a->pista = pista ? str_dup(pista) : NULL;
+        a->esq = a->dir = a->pai = NULL;
+        antigas[i] = a;
+        memAntiga += bytesHeap(a, sizeof(SalaAntiga)) + bytesHeap(a->nome, strlen(nome) + 1);
+        if (a->pista) memAntiga += bytesHeap(a->pista, strlen(pista) + 1);
+    }
+    for (size_t i = 0; i < n; ++i) {   // árvore completa: filhos de i em 2i+1 e 2i+2
+        Sala *e = 2 * i + 1 < n ? novas[2 * i + 1] : NULL;
+        Sala *d = 2 * i + 2 < n ? novas[2 * i + 2] : NULL;
+        conectarFilhos(novas[i], e, d);
+        antigas[i]->esq = e ? antigas[2 * i + 1] : NULL;
+        antigas[i]->dir = d ? antigas[2 * i + 2] : NULL;
+        if (e) antigas[2 * i + 1]->pai = antigas[i];
+        if (d) antigas[2 * i + 2]->pai = antigas[i];
+    }
+
+    unsigned long long rng = 42, soma = 0; // 'soma' impede o compilador de descartar as leituras
+    Sala *s = novas[0];
+    unsigned long long t0 = agora_ns();
+    for (size_t p = 0; p < PASSOS; ++p) {
+        soma += (unsigned char)salaNome(s)[0]; // lê o nome da sala atual
+        Sala *prox = (rng_proximo(&rng) & 1) ? s->dir : s->esq;
+        s = prox ? prox : novas[0];    // chegou numa folha: recomeça da raiz
+    }
+    unsigned long long tNova = agora_ns() - t0;
+
+    rng = 42;
+    SalaAntiga *a = antigas[0];
+    t0 = agora_ns();
+    for (size_t p = 0; p < PASSOS; ++p) {
+        soma += (unsigned char)a->nome[0];
+        SalaAntiga *prox = (rng_proximo(&rng) & 1) ? a->dir : a->esq;
+        a = prox ? prox : antigas[0];
+    }
+    unsigned long long tAntiga = agora_ns() - t0;
+
+    printf("Layout de Sala: %zu salas, %zu movimentos (checksum %llu)\n", n, PASSOS, soma);
+    printf("  %-22s %10s %12s\n", "layout", "bytes/nó", "ns/movimento");
+    printf("  %-22s %10.1f %12.2f\n", "ponteiros + str_dup", (double)memAntiga / (double)n, (double)tAntiga / (double)PASSOS);
+    printf("  %-22s %10.1f %12.2f\n", "StrCurta (inline)", (double)memNova / (double)n, (double)tNova / (double)PASSOS);
+
+    for (size_t i = 0; i < n; ++i) {
+        free(antigas[i]->nome);
+        free(antigas[i]->pista);
+        free(antigas[i]);
+    }
+    liberarSalas(novas[0]);
+    free(antigas);
+    free(novas);
+    return 0;
+}
+
+/*
+ * benchBits - compara a coleta por sessão com BST + verificarSuspeitoFinal
+ * contra o conjunto em bitset + verificarSuspeitoFinalBits, num mapa de
+ * 'n' salas com pistas distintas e 'nSusp' suspeitos; mede também a união
+ * e a interseção de todas as sessões.
+ */
+int benchBits(size_t n, size_t nSusp) {
+    const size_t SESSOES = 200, POR_SESSAO = 2000; // sessões medidas e pistas coletadas por sessão
+    if (n < 2) n = 2;
+    if (nSusp < 1) nSusp = 1;
+    Sala **salas = malloc(n * sizeof(Sala *));
+    size_t *sorteio = malloc(SESSOES * POR_SESSAO * sizeof(size_t));
+    if (!salas || !sorteio) { fprintf(stderr, "Erro: memória insuficiente para a medição.\n"); exit(EXIT_FAILURE); }
+    HashTable *ht = criarHashTable(n | 1);
+    char pista[64], sus[64];
+    for (size_t i = 0; i < n; ++i) {   // mapa completo, uma pista distinta por sala
+        snprintf(pista, sizeof(pista), "Pista número %zu da mansão", i);
+        snprintf(sus, sizeof(sus), "Suspeito %zu", i % nSusp);
+        salas[i] = criarSala("Sala", pista);
+        inserirNaHash(ht, pista, sus);
+    }
+    for (size_t i = 0; i < n; ++i)
+        conectarFilhos(salas[i], 2 * i + 1 < n ? salas[2 * i + 1] : NULL, 2 * i + 2 < n ? salas[2 * i + 2] : NULL);
+    Catalogo *cat = criarCatalogo(salas[0], ht);
+    unsigned long long rng = 7;
+    for (size_t i = 0; i < SESSOES * POR_SESSAO; ++i) sorteio[i] = rng_proximo(&rng) % n;
+
+    size_t acertosBST = 0, acertosBits = 0;
+    unsigned long long t0 = agora_ns();
+    for (size_t k = 0; k < SESSOES; ++k) {  // BST: insere, julga o "Suspeito 0" e libera (como o jogo com --colecao bst)
+        void *arv = COLECAO_BST.criar();
+        for (size_t j = 0; j < POR_SESSAO; ++j) COLECAO_BST.inserir(arv, salaPista(salas[sorteio[k * POR_SESSAO + j]]));
+        acertosBST += (size_t)verificarSuspeitoFinal(&COLECAO_BST, arv, ht, "Suspeito 0");
+        COLECAO_BST.liberar(arv);
+    }
+    unsigned long long tBST = agora_ns() - t0;
+
+    ConjuntoPistas *conj = conjCriar(cat->nPistas), *uniao = conjCriar(cat->nPistas), *inter = conjCriar(cat->nPistas);
+    t0 = agora_ns();
+    for (size_t k = 0; k < SESSOES; ++k) {  // bitset: limpa, liga bits e julga
+        conjLimpar(conj);
+        for (size_t j = 0; j < POR_SESSAO; ++j) conjInserir(conj, (size_t)salas[sorteio[k * POR_SESSAO + j]]->pistaId);
+        acertosBits += (size_t)verificarSuspeitoFinalBits(cat, conj, "Suspeito 0");
+    }
+    unsigned long long tBits = agora_ns() - t0;
+
+    t0 = agora_ns();
+    for (size_t k = 0; k < SESSOES; ++k) { // união/interseção de SESSOES conjuntos do tamanho do catálogo
+        conjUniao(uniao, conj);
+        conjIntersecao(inter, conj);
+    }
+    unsigned long long tConj = agora_ns() - t0;
+
+    printf("Conjunto de pistas: %zu pistas, %zu suspeitos, %zu sessões x %zu pistas\n", cat->nPistas, cat->nSuspeitos, SESSOES, POR_SESSAO);
+    printf("  BST + verificarSuspeitoFinal:       %10.1f us/sessão (veredito %zu)\n", (double)tBST / 1e3 / SESSOES, acertosBST);
+    printf("  bitset + verificarSuspeitoFinalBits: %9.1f us/sessão (veredito %zu)\n", (double)tBits / 1e3 / SESSOES, acertosBits);
+    printf("  união + interseção:                  %9.1f us/sessão (%zu palavras)\n", (double)tConj / 1e3 / SESSOES, conj->nPalavras);
+
+    conjLiberar(conj); conjLiberar(uniao); conjLiberar(inter);
+    liberarCatalogo(cat);
+    liberarHashTable(ht);
+    liberarSalas(salas[0]);
+    liberarPool();
+    free(salas);
+    free(sorteio);
+    return 0;
+}
+
+/*
+ * benchPool - simula 'sessoes' explorações seguidas (cada uma cria uma BST com
+ * pistas sorteadas e a libera) e mostra chamadas ao malloc por rodada: depois
+ * da primeira rodada o pool atende tudo pelas listas livres.
+ */
+int benchPool(size_t sessoes) {
+    const size_t POR_SESSAO = 500;     // pistas inseridas por sessão
+    char texto[96];
+    unsigned long long rng = 11;
+    unsigned long long t0 = agora_ns();
+    for (size_t k = 0; k < sessoes; ++k) {
+        unsigned long long mallocAntes = g_pool.chamadasMalloc;
+        NoPista *arv = NULL;
+        for (size_t j = 0; j < POR_SESSAO; ++j) { // textos curtos e longos, como no jogo
+            unsigned long long r = rng_proximo(&rng);
+            const char *base = PISTAS_REAIS[r % N_TEXTOS_REAIS];
+            snprintf(texto, sizeof(texto), "%s #%llu", base ? base : "Pó", (r >> 8) % 1000);
+            arv = inserirPista(arv, texto);
+        }
+        liberarPistas(arv);
+        if (k < 3 || k + 1 == sessoes)  // primeiras rodadas e a última
+            printf("  sessão %6zu: %llu chamadas ao malloc\n", k + 1, g_pool.chamadasMalloc - mallocAntes);
+    }
+    unsigned long long t = agora_ns() - t0;
+    printf("Pool de pistas: %zu sessões x %zu pistas, %.1f us/sessão\n", sessoes, POR_SESSAO, (double)t / 1e3 / (double)sessoes);
+    mostrarPool();
+    liberarPool();
+    return 0;
+}
+
+/* ---------- Ramificações ---------- */
+
+/*
+ * benchRamos - mapa completo de 'n' salas, todas com pista; guarda vivas ao
+ * mesmo tempo as versões de todos os caminhos e compara os nós alocados com
+ * o que custaria copiar a coleção inteira a cada ramificação.
+ */
+int benchRamos(size_t n) {
+    if (n < 1) n = 1;
+    Sala **salas = malloc(n * sizeof(Sala *));
+    if (!salas) { fprintf(stderr, "Erro: memória insuficiente para a medição.\n"); exit(EXIT_FAILURE); }
+    char pista[48];
+    for (size_t i = 0; i < n; ++i) {
+        snprintf(pista, sizeof(pista), "Pista %zu", i);
+        salas[i] = criarSala("Sala", pista);
+        salas[i]->pistaId = (int)i;    // IDs direto, sem catálogo
+    }
+    for (size_t i = 0; i < n; ++i)
+        conectarFilhos(salas[i], 2 * i + 1 < n ? salas[2 * i + 1] : NULL, 2 * i + 2 < n ? salas[2 * i + 2] : NULL);
+    Ramos r = { NULL, malloc(n * sizeof(char *)), NULL, 0, malloc((n / 2 + 1) * sizeof(NoPers *)), 0, 0 };
+    if (!r.caminho || !r.folhas) { fprintf(stderr, "Erro: memória insuficiente para a medição.\n"); exit(EXIT_FAILURE); }
+
+    unsigned long long t0 = agora_ns();
+    ramos_visitar(&r, salas[0], NULL, 0);
+    unsigned long long t = agora_ns() - t0;
+    printf("Ramificações: %zu salas, %zu versões finais vivas ao mesmo tempo\n", n, r.nFolhas);
+    printf("  tempo para gerar todas: %.1f ms (%.0f ns por sala visitada)\n", (double)t / 1e6, (double)t / (double)n);
+    printf("  nós persistentes vivos: %llu (%.1f bytes por versão)\n", g_persVivos,
+           (double)g_persVivos * sizeof(NoPers) / (double)r.nFolhas);
+    printf("  cópia completa por ramo: %zu nós\n", r.somaTamanhos);
+
+    for (size_t i = 0; i < r.nFolhas; ++i) persLiberar(r.folhas[i]);
+    printf("  nós vivos após liberar as versões: %llu\n", g_persVivos);
+    free(r.folhas);
+    free(r.caminho);
+    liberarSalas(salas[0]);
+    free(salas);
+    return 0;
+}
+
+/* ---------- Diário, catálogo, sessões, servidor e montagem ---------- */
+
+/* bench_gravarPasseios - grava no diário 'sessoes' sessões de 50 comandos aleatórios pelo mapa */
+static void bench_gravarPasseios(Diario *d, Sala *mapa, const Catalogo *cat, size_t sessoes) {
+    ConjuntoPistas *daSessao = conjCriar(cat->nPistas);
+    unsigned long long rng = 3;
+    for (size_t k = 0; k < sessoes; ++k) {
+        diarioSessaoInicio(d);
+        conjLimpar(daSessao);
+        Sala *s = mapa;
+        for (int passo = 0; passo < 50; ++passo) { // passeio aleatório de 50 comandos
+            unsigned long long r = rng_proximo(&rng) % 3;
+            Sala *prox = r == 0 ? s->esq : r == 1 ? s->dir : s->pai;
+            if (!prox) continue;
+            s = prox;
+            diarioMover(d, s->id, "edv"[r]);
+            if (s->pistaId >= 0) {
+                conjInserir(daSessao, (size_t)s->pistaId);
+                diarioPista(d, s->pistaId);
+                diarioConsulta(d, s->pistaId, cat->suspeitoDaPista[s->pistaId] >= 0);
+            }
+        }
+        int sid = (int)(rng_proximo(&rng) % cat->nSuspeitos);
+        diarioAcusacao(d, sid, evidenciasContra(cat, daSessao, sid) >= 2, cat->suspeitos[sid]);
+        diarioSessaoFim(d);
+    }
+    conjLiberar(daSessao);
+}
+
+/*
+ * benchDiario - grava um diário sintético com 'sessoes' sessões de passeios
+ * aleatórios pelo mapa real e mede a reprodução completa e a partir da
+ * sessão do meio (salto pelo índice).
+ */
+int benchDiario(const char *caminho, size_t sessoes) {
+    char caminhoIdx[1024];
+    snprintf(caminhoIdx, sizeof(caminhoIdx), "%s.idx", caminho);
+    unlink(caminho);
+    unlink(caminhoIdx);
+    Sala *mapa = montarMapaComPistas();
+    HashTable *ht = montarAssociacoes();
+    Catalogo *cat = criarCatalogo(mapa, ht);
+    Diario *d = diarioAbrir(caminho, cat);
+    if (!d) { fprintf(stderr, "Erro: não foi possível criar %s.\n", caminho); return 1; }
+
+    unsigned long long t0 = agora_ns();
+    bench_gravarPasseios(d, mapa, cat, sessoes);
+    unsigned long long tGrav = agora_ns() - t0;
+    uint64_t eventos = d->eventos;
+    diarioFechar(d);
+
+    Reproducao r;
+    t0 = agora_ns();
+    reproduzirDiario(caminho, 0, cat, &r);
+    unsigned long long tRep = agora_ns() - t0;
+    printf("Diário: %zu sessões, %llu eventos\n", sessoes, (unsigned long long)eventos);
+    printf("  gravação:             %8.1f M eventos/s\n", (double)eventos / ((double)tGrav / 1e9) / 1e6);
+    printf("  reprodução completa:  %8.1f M eventos/s\n", (double)r.lidos / ((double)tRep / 1e9) / 1e6);
+    liberarReproducao(&r);
+
+    t0 = agora_ns();
+    reproduzirDiario(caminho, (uint32_t)(sessoes / 2), cat, &r);
+    unsigned long long tMeio = agora_ns() - t0;
+    printf("  a partir da sessão %zu: %llu eventos lidos em %.2f ms (sessões concluídas ao final: %u)\n",
+           sessoes / 2, (unsigned long long)r.lidos, (double)tMeio / 1e6, r.sessoes);
+    liberarReproducao(&r);
+
+    unlink(caminho);
+    unlink(caminhoIdx);
+    liberarCatalogo(cat);
+    liberarHashTable(ht);
+    liberarSalas(mapa);
+    return 0;
+}
+
+/* bench_gravarArquivo - substitui o conteúdo de 'caminho' por 'n' bytes; 0 se gravou tudo */
+static int bench_gravarArquivo(const char *caminho, const void *dados, size_t n) {
+    int fd = open(caminho, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return -1;
+    int r = diario_gravarTudo(fd, dados, n);
+    close(fd);
+    return r;
+}
+
+/* bench_lerArquivo - conteúdo inteiro de 'caminho' (malloc) em *n; NULL se falhar */
+static unsigned char *bench_lerArquivo(const char *caminho, size_t *n) {
+    size_t tam;
+    const unsigned char *m = diario_mapear(caminho, &tam);
+    if (!m) return NULL;
+    unsigned char *b = malloc(tam);
+    if (!b) { fprintf(stderr, "Erro: memória insuficiente para o teste.\n"); exit(EXIT_FAILURE); }
+    memcpy(b, m, tam);
+    munmap((void *)m, tam);
+    *n = tam;
+    return b;
+}
+
+/*
+ * bench_diarioCurto - diário de exatamente 4096 bytes (uma página) que termina
+ * num registro do tipo dado com conteúdo de 4 bytes, menor que o mínimo do
+ * tipo: ler o conteúdo inteiro passaria do fim do mapeamento. Antes dele, um
+ * registro de tipo desconhecido (que a reprodução pula) ocupa o resto.
+ */
+static int bench_diarioCurto(const char *caminho, const Catalogo *cat, uint8_t tipo) {
+    unsigned char b[4096] = { 0 };
+    diario_cabecalho(b, cat);
+    uint32_t enchimento = sizeof(b) - DIARIO_INICIO_REG - 2 * DIARIO_CAB - 4, curto = 4;
+    memcpy(b + DIARIO_INICIO_REG, &enchimento, 4);
+    b[DIARIO_INICIO_REG + 4] = 0x7F;   // tipo desconhecido
+    unsigned char *r = b + sizeof(b) - DIARIO_CAB - curto;
+    memcpy(r, &curto, 4);
+    r[4] = tipo;
+    memset(r + DIARIO_CAB, 0xFF, curto);
+    return bench_gravarArquivo(caminho, b, sizeof(b));
+}
+
+/*
+ * bench_mesmoEstado - as duas reproduções chegaram ao mesmo estado? (os totais
+ * por tipo só contam os registros lidos, então ficam de fora)
+ */
+static int bench_mesmoEstado(const Reproducao *a, const Reproducao *b) {
+    return a->eventos == b->eventos && a->sessoes == b->sessoes && a->sessaoAtual == b->sessaoAtual
+        && a->salaAtual == b->salaAtual && a->vistas->nPalavras == b->vistas->nPalavras
+        && memcmp(a->vistas->palavras, b->vistas->palavras, a->vistas->nPalavras * sizeof(uint64_t)) == 0;
+}
+
+/*
+ * testarDiario - verificação de regressão da reprodução, ao lado das medições
+ * do diário: diários corrompidos de propósito têm de ser recusados sem ler
+ * fora do arquivo, uma cauda truncada continua aceita, e um índice com todos
+ * os deslocamentos errados não pode levar a reprodução para o meio de um
+ * registro (o salto é conferido e, se não bater, ela lê desde o início).
+ * Retorna 0 se todos os casos passarem; vale rodar também com -fsanitize=address.
+ */
+int testarDiario(const char *caminho) {
+    char caminhoIdx[1024];
+    snprintf(caminhoIdx, sizeof(caminhoIdx), "%s.idx", caminho);
+    unlink(caminho);
+    unlink(caminhoIdx);
+    Sala *mapa = montarMapaComPistas();
+    HashTable *ht = montarAssociacoes();
+    Catalogo *cat = criarCatalogo(mapa, ht);
+    int falhas = 0, ok;
+    Reproducao r, base, salto;
+#define TESTE(cond, descricao) do { int ok_ = (cond); printf("  %-6s %s\n", ok_ ? "ok" : "FALHOU", descricao); falhas += !ok_; } while (0)
+
+    printf("Reprodução do diário:\n");
+    TESTE(bench_diarioCurto(caminho, cat, DIARIO_PONTO) == 0 && reproduzirDiario(caminho, 0, cat, &r) == -1,
+          "PONTO curto no fim da página é recusado");
+    TESTE(bench_diarioCurto(caminho, cat, DIARIO_CONSULTA) == 0 && reproduzirDiario(caminho, 0, cat, &r) == -1,
+          "CONSULTA curta no fim da página é recusada");
+    unlink(caminho);
+
+    Diario *d = diarioAbrir(caminho, cat);
+    if (!d) { fprintf(stderr, "Erro: não foi possível criar %s.\n", caminho); return 1; }
+    bench_gravarPasseios(d, mapa, cat, 10);
+    diarioFechar(d);
+    size_t nIdx, nDiario;
+    unsigned char *idx = bench_lerArquivo(caminhoIdx, &nIdx);
+    unsigned char *diario = bench_lerArquivo(caminho, &nDiario);
+    if (!idx || !diario || reproduzirDiario(caminho, 0, cat, &base) != 0) {
+        fprintf(stderr, "Erro: não foi possível ler de volta %s.\n", caminho);
+        return 1;
+    }
+    TESTE(base.sessoes == 10, "diário íntegro: 10 sessões reproduzidas");
+
+    ok = reproduzirDiario(caminho, 3, cat, &salto) == 0;
+    TESTE(ok && bench_mesmoEstado(&salto, &base) && salto.lidos < base.lidos,
+          "salto pelo índice chega ao mesmo estado lendo menos");
+    if (ok) liberarReproducao(&salto);
+
+    for (size_t e = 8; e + sizeof(EntradaIndice) <= nIdx; e += sizeof(EntradaIndice)) { // índice velho: tudo 7 bytes adiante
+        uint64_t desl;
+        memcpy(&desl, idx + e, 8);
+        desl += 7;
+        memcpy(idx + e, &desl, 8);
+    }
+    ok = bench_gravarArquivo(caminhoIdx, idx, nIdx) == 0 && reproduzirDiario(caminho, 3, cat, &salto) == 0;
+    TESTE(ok && bench_mesmoEstado(&salto, &base) && salto.lidos == base.lidos,
+          "índice deslocado: lê desde o início e chega ao mesmo estado");
+    if (ok) liberarReproducao(&salto);
+
+    ok = bench_gravarArquivo(caminho, diario, nDiario - 3) == 0 // gravação interrompida no último registro
+         && reproduzirDiario(caminho, 0, cat, &r) == 0;
+    TESTE(ok && r.sessoes == 9, "cauda truncada: aceita até a última sessão inteira");
+    if (ok) liberarReproducao(&r);
+#undef TESTE
+
+    free(idx);
+    free(diario);
+    liberarReproducao(&base);
+    unlink(caminho);
+    unlink(caminhoIdx);
+    liberarCatalogo(cat);
+    liberarHashTable(ht);
+    liberarSalas(mapa);
+    printf(falhas ? "%d caso(s) falharam.\n" : "Todos os casos passaram.\n", falhas);
+    return falhas ? 1 : 0;
+}
+
+/*
+ * benchGrafo - grafo sintético com 'nSalas' salas e 'grau' portas por sala
+ * (metade para salas vizinhas, metade aleatórias, com muitos ciclos): mede a
+ * montagem do CSR, a memória por porta, passos de um passeio aleatório com
+ * coleta de pistas e uma busca em largura coletando tudo o que é alcançável.
+ */
+int benchGrafo(uint32_t nSalas, uint32_t grau) {
+    static const char *rotulos[] = { "norte", "sul", "leste", "oeste", "escada", "passagem secreta" };
+    if (nSalas < 2) nSalas = 2;
+    if (grau < 1) grau = 1;
+    uint64_t nPortas = (uint64_t)nSalas * grau;
+    Porta *portas = malloc(nPortas * sizeof(Porta));
+    const char **nomes = malloc((size_t)nSalas * sizeof(char *));
+    int32_t *pistas = malloc((size_t)nSalas * sizeof(int32_t));
+    if (!portas || !nomes || !pistas) { fprintf(stderr, "Erro: memória insuficiente para a medição.\n"); exit(EXIT_FAILURE); }
+    unsigned long long rng = 5;
+    uint64_t k = 0;
+    for (uint32_t sl = 0; sl < nSalas; ++sl) {
+        nomes[sl] = NOMES_REAIS[sl % N_TEXTOS_REAIS];
+        pistas[sl] = (sl % 4 == 0) ? (int32_t)(sl / 4) : -1; // uma sala em cada quatro tem pista
+        for (uint32_t j = 0; j < grau; ++j) {
+            unsigned long long r = rng_proximo(&rng);
+            uint32_t d = (j % 2 == 0) ? (uint32_t)((sl + 1 + r % 8) % nSalas) // vizinha (localidade)
+                                      : (uint32_t)(r % nSalas);               // qualquer sala (ciclos longos)
+            portas[k++] = (Porta){ sl, d, (uint8_t)(r >> 40) % 6 };
+        }
+    }
+    unsigned long long t0 = agora_ns();
+    MapaGrafo *g = grafoCriar(nSalas, portas, nPortas, nomes, pistas, rotulos, 6);
+    unsigned long long tMontar = agora_ns() - t0;
+    free(portas);
+    free(nomes);
+    free(pistas);
+    size_t bytes = ((size_t)nSalas + 1) * sizeof(uint64_t) + nPortas * (sizeof(uint32_t) + 1)
+                 + (size_t)nSalas * (sizeof(char *) + sizeof(int32_t));
+    size_t nPistas = nSalas / 4 + 1;
+
+    const uint64_t PASSOS = 10000000;  // passeio aleatório: escolhe uma porta qualquer a cada passo
+    ConjuntoPistas *visitadas = conjCriar(nSalas), *coletadas = conjCriar(nPistas);
+    uint32_t atual = 0;
+    t0 = agora_ns();
+    for (uint64_t p = 0; p < PASSOS; ++p) {
+        if (conjInserir(visitadas, atual) && g->pistaId[atual] >= 0) conjInserir(coletadas, (size_t)g->pistaId[atual]);
+        uint64_t ini = g->inicio[atual], n = g->inicio[atual + 1] - ini;
+        if (n) atual = g->destino[ini + rng_proximo(&rng) % n];
+    }
+    unsigned long long tPasseio = agora_ns() - t0;
+    printf("Grafo CSR: %u salas, %llu portas (%.1f MB, %.2f bytes/porta com salas)\n", nSalas,
+           (unsigned long long)nPortas, (double)bytes / 1e6, (double)bytes / (double)nPortas);
+    printf("  montagem do CSR:       %8.1f ms\n", (double)tMontar / 1e6);
+    printf("  passeio aleatório:     %8.1f ns/passo (%zu salas visitadas, %zu pistas)\n",
+           (double)tPasseio / (double)PASSOS, conjContar(visitadas), conjContar(coletadas));
+
+    conjLimpar(visitadas);
+    conjLimpar(coletadas);
+    t0 = agora_ns();
+    uint64_t alcancadas = grafoColetarAlcancaveis(g, 0, visitadas, coletadas);
+    unsigned long long tBusca = agora_ns() - t0;
+    printf("  busca em largura:      %8.1f ms (%llu salas, %zu pistas, %.1f M portas/s)\n", (double)tBusca / 1e6,
+           (unsigned long long)alcancadas, conjContar(coletadas), (double)nPortas / ((double)tBusca / 1e9) / 1e6);
+    conjLiberar(visitadas);
+    conjLiberar(coletadas);
+    liberarGrafo(g);
+    return 0;
+}
+
+/*
+ * bench_explorarGrafo - roda explorarGrafo num processo filho com 'entrada'
+ * no stdin e devolve tudo o que ele imprimiu (string do malloc).
+ */
+static char *bench_explorarGrafo(const MapaGrafo *g, HashTable *ht, const Catalogo *cat, const char *entrada) {
+    int ida[2], volta[2];
+    if (pipe(ida) < 0 || pipe(volta) < 0) { perror("pipe"); exit(EXIT_FAILURE); }
+    fflush(stdout);                    // o filho não repete o que ainda está no buffer
+    pid_t filho = fork();
+    if (filho < 0) { perror("fork"); exit(EXIT_FAILURE); }
+    if (filho == 0) {
+        dup2(ida[0], STDIN_FILENO);
+        dup2(volta[1], STDOUT_FILENO);
+        close(ida[0]); close(ida[1]); close(volta[0]); close(volta[1]);
+        ConjuntoPistas *coletadas = conjCriar(cat->nPistas);
+        explorarGrafo(g, ht, coletadas, cat);
+        fflush(stdout);
+        _exit(0);
+    }
+    close(ida[0]);
+    close(volta[1]);
+    if (diario_gravarTudo(ida[1], entrada, strlen(entrada)) < 0) { /* o filho lê EOF e encerra */ }
+    close(ida[1]);
+    size_t n = 0, cap = 4096;
+    char *saida = malloc(cap);
+    for (ssize_t r; saida && (r = read(volta[0], saida + n, cap - 1 - n)) != 0; ) {
+        if (r < 0) { if (errno == EINTR) continue; break; }
+        n += (size_t)r;
+        if (cap - 1 - n == 0) saida = realloc(saida, cap *= 2);
+    }
+    if (!saida) { fprintf(stderr, "Erro: memória insuficiente no teste.\n"); exit(EXIT_FAILURE); }
+    saida[n] = '\0';
+    close(volta[0]);
+    waitpid(filho, NULL, 0);
+    return saida;
+}
+
+/*
+ * testarGrafo - leitura dos números de porta no modo grafo: um Hall com 15
+ * portas (S1..S15, cada uma com uma porta de volta), escolhas de dois
+ * dígitos, várias na mesma linha e entradas que não podem virar porta.
+ */
+int testarGrafo(void) {
+    enum { N = 16 };                   // Hall + 15 salas: o Hall tem portas de 1 a 15
+    static const char *rotulos[] = { "porta" };
+    char textos[N][8];
+    const char *nomes[N];
+    int32_t pistas[N];
+    Porta portas[2 * (N - 1)];
+    uint64_t np = 0;
+    for (uint32_t i = 0; i < N; ++i) {
+        snprintf(textos[i], sizeof(textos[i]), "S%u", i);
+        nomes[i] = textos[i];
+        pistas[i] = -1;
+    }
+    for (uint32_t i = 1; i < N; ++i) {
+        portas[np++] = (Porta){ 0, i, 0 };
+        portas[np++] = (Porta){ i, 0, 0 };
+    }
+    MapaGrafo *g = grafoCriar(N, portas, np, nomes, pistas, rotulos, 1);
+    printf("Números de porta no modo grafo:\n");
+    Sala *mapa = montarMapaComPistas();
+    HashTable *ht = montarAssociacoes();
+    Catalogo *cat = criarCatalogo(mapa, ht);
+    int falhas = 0;
+#define TESTE(cond, descricao) do { int ok_ = (cond); printf("  %-6s %s\n", ok_ ? "ok" : "FALHOU", descricao); falhas += !ok_; } while (0)
+    static const struct { const char *entrada, *esperado; int salas; const char *descricao; } casos[] = {
+        { "s\n",                      "(15) porta -> S15",      1, "o Hall lista as 15 portas" },
+        { "12\ns\n",                  "Você está na sala: S12", 2, "12: porta de dois dígitos" },
+        { "1 1 15\ns\n",              "Você está na sala: S15", 3, "1 1 15: vários números na mesma linha" },
+        { "0\ns\n",                   "Opção inválida",         1, "0: não há porta zero" },
+        { "16\ns\n",                  "Opção inválida",         1, "16: além da última porta" },
+        { "+1\ns\n",                  "Opção inválida",         1, "+1: sinal não é número de porta" },
+        { "1x\ns\n",                  "Opção inválida",         1, "1x: lixo depois do número" },
+        { "99999999999999999999\ns\n", "Opção inválida",        1, "número que estoura 64 bits" },
+        { "4294967297\ns\n",          "Opção inválida",         1, "2^32 + 1 não vira a porta 1" },
+    };
+    for (size_t i = 0; i < sizeof(casos) / sizeof(casos[0]); ++i) {
+        char *saida = bench_explorarGrafo(g, ht, cat, casos[i].entrada), resumo[64];
+        snprintf(resumo, sizeof(resumo), "Salas visitadas: %d de %d", casos[i].salas, N);
+        TESTE(strstr(saida, casos[i].esperado) && strstr(saida, resumo), casos[i].descricao);
+        free(saida);
+    }
+#undef TESTE
+    liberarCatalogo(cat);
+    liberarHashTable(ht);
+    liberarSalas(mapa);
+    liberarGrafo(g);
+    printf(falhas ? "%d caso(s) falharam.\n" : "Todos os casos passaram.\n", falhas);
+    return falhas ? 1 : 0;
+}
+
+/* bench_somarEmOrdem - percorre a BST em ordem somando o primeiro byte (listagem sem E/S) */
+static unsigned long long bench_somarEmOrdem(const NoPista *n) {
+    unsigned long long soma = 0;
+    for (; n; n = n->dir) {
+        soma += bench_somarEmOrdem(n->esq);
+        soma += (unsigned char)strc_texto(&n->texto)[0];
+    }
+    return soma;
+}
+
+/*
+ * benchEytzinger - 'n' pistas sintéticas com os prefixos das pistas reais:
+ * compara buscas por texto e a listagem alfabética entre o catálogo
+ * Eytzinger e uma BST de NoPista montada em ordem aleatória.
+ */
+int benchEytzinger(size_t n) {
+    const size_t BUSCAS = 2000000;
+    if (n < 1) n = 1;
+    char **textos = malloc(n * sizeof(char *));
+    const char **ordenados = malloc(n * sizeof(char *));
+    size_t *sorteio = malloc(BUSCAS * sizeof(size_t));
+    if (!textos || !ordenados || !sorteio) { fprintf(stderr, "Erro: memória insuficiente para a medição.\n"); exit(EXIT_FAILURE); }
+    unsigned long long rng = 9;
+    char buf[96];
+    for (size_t i = 0; i < n; ++i) {   // textos distintos (o índice entra no texto), ordem aleatória
+        const char *base = PISTAS_REAIS[rng_proximo(&rng) % N_TEXTOS_REAIS];
+        snprintf(buf, sizeof(buf), "%s %llx-%zu", base ? base : "Pó no chão", rng_proximo(&rng) & 0xffff, i);
+        textos[i] = str_dup(buf);
+    }
+    memcpy(ordenados, textos, n * sizeof(char *));
+    qsort(ordenados, n, sizeof(char *), cat_compararTextos);
+    for (size_t i = 0; i < BUSCAS; ++i) sorteio[i] = rng_proximo(&rng) % n;
+
+    unsigned long long t0 = agora_ns();
+    Eytzinger *e = eytCriar(ordenados, n);
+    unsigned long long tEytMontar = agora_ns() - t0;
+    t0 = agora_ns();
+    NoPista *arv = NULL;
+    for (size_t i = 0; i < n; ++i) arv = inserirPista(arv, textos[i]);
+    unsigned long long tBstMontar = agora_ns() - t0;
+
+    size_t achados = 0;
+    t0 = agora_ns();
+    for (size_t i = 0; i < BUSCAS; ++i) achados += eytBuscar(e, textos[sorteio[i]]) >= 0;
+    unsigned long long tEyt = agora_ns() - t0;
+    t0 = agora_ns();
+    for (size_t i = 0; i < BUSCAS; ++i) achados += buscarPista(arv, textos[sorteio[i]]) != NULL;
+    unsigned long long tBst = agora_ns() - t0;
+
+    unsigned long long soma = 0;
+    t0 = agora_ns();
+    for (size_t r = 0; r < n; ++r) soma += (unsigned char)eytSelecionar(e, r)[0];
+    unsigned long long tVarrer = agora_ns() - t0;
+    t0 = agora_ns();
+    soma += bench_somarEmOrdem(arv);
+    unsigned long long tEmOrdem = agora_ns() - t0;
+
+    printf("Catálogo ordenado: %zu pistas, %zu buscas (achadas %zu, checksum %llu)\n", n, BUSCAS, achados, soma);
+    printf("  %-22s %10s %12s %14s %12s\n", "estrutura", "montar ms", "ns/busca", "listar ns/item", "bytes/item");
+    printf("  %-22s %10.1f %12.1f %14.2f %12.1f\n", "BST de NoPista", (double)tBstMontar / 1e6,
+           (double)tBst / BUSCAS, (double)tEmOrdem / (double)n, (double)sizeof(NoPista));
+    printf("  %-22s %10.1f %12.1f %14.2f %12.1f\n", "Eytzinger", (double)tEytMontar / 1e6,
+           (double)tEyt / BUSCAS, (double)tVarrer / (double)n,
+           (double)(sizeof(uint64_t) + 2 * sizeof(uint32_t) + sizeof(char *)));
+
+    liberarPistas(arv);
+    liberarPool();
+    liberarEytzinger(e);
+    for (size_t i = 0; i < n; ++i) free(textos[i]);
+    free(textos);
+    free(ordenados);
+    free(sorteio);
+    return 0;
+}
+
+/* bench_buscarOrdenado - busca binária com strcmp no vetor ordenado (referência para fcBuscar) */
+static long bench_buscarOrdenado(const char *const *v, size_t n, const char *texto) {
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t meio = lo + (hi - lo) / 2;
+        int c = strcmp(v[meio], texto);
+        if (c == 0) return (long)meio;
+        if (c < 0) lo = meio + 1; else hi = meio;
+    }
+    return -1;
+}
+
+/*
+ * benchFrontCoding - 'n' pistas distintas (textos reais com sufixo, como em
+ * benchEytzinger) guardadas de duas formas: um str_dup por texto + vetor de
+ * ponteiros ordenado, e TextosFC. Compara memória, busca por texto, acesso
+ * por ID e percurso em ordem, e confere que as duas formas concordam.
+ */
+int benchFrontCoding(size_t n) {
+    const size_t CONSULTAS = 1000000;
+    if (n < 1) n = 1;
+    char **textos = malloc(n * sizeof(char *));
+    size_t *sorteio = malloc(CONSULTAS * sizeof(size_t));
+    if (!textos || !sorteio) { fprintf(stderr, "Erro: memória insuficiente para a medição.\n"); exit(EXIT_FAILURE); }
+    unsigned long long rng = 9;
+    char buf[96];
+    size_t bytesStrdup = n * sizeof(char *); // vetor de ponteiros + cada bloco do malloc
+    for (size_t i = 0; i < n; ++i) {
+        const char *base = PISTAS_REAIS[rng_proximo(&rng) % N_TEXTOS_REAIS];
+        snprintf(buf, sizeof(buf), "%s %llx-%zu", base ? base : "Pó no chão", rng_proximo(&rng) & 0xffff, i);
+        textos[i] = str_dup(buf);
+        bytesStrdup += bytesHeap(textos[i], strlen(buf) + 1);
+    }
+    qsort(textos, n, sizeof(char *), cat_compararTextos);
+    for (size_t i = 0; i < CONSULTAS; ++i) sorteio[i] = rng_proximo(&rng) % n;
+
+    unsigned long long t0 = agora_ns();
+    TextosFC *fc = fcCriar((const char *const *)textos, n);
+    unsigned long long tMontar = agora_ns() - t0;
+    size_t bytesFC = sizeof(TextosFC) + fc->tamDados + fc->nBlocos * sizeof(IndiceFC);
+    char *dec = malloc(fc->maior + 1);
+    if (!dec) { fprintf(stderr, "Erro: memória insuficiente para a medição.\n"); exit(EXIT_FAILURE); }
+
+    size_t erros = 0;                  // conferência completa: ID -> texto, texto -> ID, e ausentes
+    CursorFC cur;
+    fcCursor(&cur, fc, 0, dec);
+    for (size_t i = 0; i < n; ++i) {
+        const char *s = fcProximo(&cur);
+        if (!s || strcmp(s, textos[i]) != 0 || fcBuscar(fc, textos[i]) != (long)i) erros++;
+        if (i % 97 == 0) {
+            snprintf(buf, sizeof(buf), "%s!", textos[i]);
+            erros += fcBuscar(fc, buf) != -1 || fcBuscar(fc, "") != -1;
+        }
+    }
+    for (size_t i = 0; i < 1000; ++i) {
+        size_t id = sorteio[i];
+        erros += strcmp(fcTexto(fc, id, dec), textos[id]) != 0;
+    }
+
+    long achados = 0;
+    unsigned long long soma = 0;
+    t0 = agora_ns();
+    for (size_t i = 0; i < CONSULTAS; ++i) achados += bench_buscarOrdenado((const char *const *)textos, n, textos[sorteio[i]]) >= 0;
+    unsigned long long tBuscaV = agora_ns() - t0;
+    t0 = agora_ns();
+    for (size_t i = 0; i < CONSULTAS; ++i) achados += fcBuscar(fc, textos[sorteio[i]]) >= 0;
+    unsigned long long tBuscaFC = agora_ns() - t0;
+    t0 = agora_ns();
+    for (size_t i = 0; i < CONSULTAS; ++i) soma += (unsigned char)textos[sorteio[i]][0];
+    unsigned long long tIdV = agora_ns() - t0;
+    t0 = agora_ns();
+    for (size_t i = 0; i < CONSULTAS; ++i) soma += (unsigned char)fcTexto(fc, sorteio[i], dec)[0];
+    unsigned long long tIdFC = agora_ns() - t0;
+    t0 = agora_ns();
+    for (size_t i = 0; i < n; ++i) soma += strlen(textos[i]);
+    unsigned long long tOrdemV = agora_ns() - t0;
+    t0 = agora_ns();
+    fcCursor(&cur, fc, 0, dec);
+    while (fcProximo(&cur)) soma += cur.tam;
+    unsigned long long tOrdemFC = agora_ns() - t0;
+
+    printf("Textos ordenados: %zu pistas, blocos de %d, %zu consultas (achadas %ld, checksum %llu)\n",
+           n, FC_BLOCO, CONSULTAS, achados, soma);
+    printf("  conferência: %s\n", erros ? "DIVERGÊNCIAS" : "ok");
+    printf("  %-26s %12s %10s %12s %12s %14s\n", "armazenamento", "bytes", "B/texto", "ns/busca", "ns/por ID", "em ordem ns/t");
+    printf("  %-26s %12zu %10.1f %12.1f %12.1f %14.2f\n", "str_dup + vetor ordenado", bytesStrdup,
+           (double)bytesStrdup / (double)n, (double)tBuscaV / CONSULTAS, (double)tIdV / CONSULTAS, (double)tOrdemV / (double)n);
+    printf("  %-26s %12zu %10.1f %12.1f %12.1f %14.2f\n", "front coding", bytesFC,
+           (double)bytesFC / (double)n, (double)tBuscaFC / CONSULTAS, (double)tIdFC / CONSULTAS, (double)tOrdemFC / (double)n);
+    printf("  compressão: %.1f%% do str_dup; montagem %.1f ms\n", 100.0 * (double)bytesFC / (double)bytesStrdup, (double)tMontar / 1e6);
+
+    liberarTextosFC(fc);
+    free(dec);
+    for (size_t i = 0; i < n; ++i) free(textos[i]);
+    free(textos);
+    free(sorteio);
+    return erros ? 1 : 0;
+}
+
+/*
+ * Microbenchmarks da tabela hash (./mestre --bench-hash [nMax] [arquivo-base]).
+ * Cada operação é cronometrada em lotes de BENCH_LOTE chamadas (o custo de
+ * ler o contador some na média do lote); os percentis são sobre os lotes.
+ * As chaves de cada lote são geradas antes da medição, fora do tempo. Cada
+ * medição roda BENCH_RODADAS vezes e fica a rodada de menor mediana, que é
+ * a menos afetada por interrupções e por outros processos na máquina.
+ */
+#define BENCH_LOTE       64            // operações por amostra
+#define BENCH_MIN_OPS    200000        // tamanhos pequenos repetem a passada até somar isso
+#define BENCH_RODADAS    3             // rodadas por medição; vale a de menor mediana
+#define BENCH_TOLERANCIA 0.15          // mediana 15% acima da base = regressão
+#define BENCH_MAX_BASE   128           // linhas lidas do arquivo-base
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BENCH_UNIDADE "ciclos"
+#else
+#define BENCH_UNIDADE "ns"
+#endif
+
+/* bench_ciclos - contador de ciclos (rdtsc) ou, fora do x86, nanossegundos */
+static inline unsigned long long bench_ciclos(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return agora_ns();
+#endif
+}
+
+/* operações medidas (os nomes também identificam as linhas do arquivo-base) */
+enum { BH_HASH, BH_NOVA, BH_ATUALIZA, BH_ACERTO, BH_FALHA, BH_OPS };
+static const char *const BENCH_OPS_HASH[BH_OPS] = {
+    "hash_simple", "inserir-nova", "inserir-atualiza", "encontrar-acerto", "encontrar-falha"
+};
+static const char *const BENCH_CHAVES_HASH[2] = { "reais", "colisoes" };
+
+/*
+ * bench_chaveHash - i-ésima chave da distribuição (0 = reais, 1 = colisões) em
+ * 'dst' (pelo menos 64 bytes); 'falha' dá uma chave que nunca é inserida.
+ *   reais    - texto de uma pista do mapa (escolhida por i) com os 7 últimos
+ *              bytes trocados por i em base 36: mesmos comprimentos e prefixos
+ *              das pistas reais, todas as chaves distintas;
+ *              As chaves de falha usam i + 4*10^10 (ainda cabe em 7 dígitos);
+ *   colisões - "Pista " + grupo i/64 em base 36 + 6 blocos "Aa"/"BB" pelos
+ *              bits de i%64 + um bloco final ("Aa", ou "BB" nas falhas).
+ *              "Aa" e "BB" dão o mesmo h*31 + c, então as 64 chaves do grupo
+ *              e as 64 falhas correspondentes têm o mesmo hash antes do
+ *              módulo e caem no mesmo bucket em qualquer tamanho de tabela.
+ */
+static void bench_chaveHash(int colisoes, unsigned long long i, int falha, char *dst) {
+    static const char BASE36[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+    size_t n;
+    if (!colisoes) {
+        if (falha) i += 40000000000ull;
+        size_t k = (size_t)((i * 0x9E3779B97F4A7C15ull) >> 32) % N_TEXTOS_REAIS;
+        while (!PISTAS_REAIS[k]) k = (k + 1) % N_TEXTOS_REAIS;
+        n = strlen(PISTAS_REAIS[k]);
+        memcpy(dst, PISTAS_REAIS[k], n);
+        for (size_t j = 1; j <= 7; ++j, i /= 36) dst[n - j] = BASE36[i % 36];
+    } else {
+        memcpy(dst, "Pista ", 6);
+        unsigned long long g = i >> 6;
+        for (size_t j = 0; j < 6; ++j, g /= 36) dst[11 - j] = BASE36[g % 36];
+        n = 12;
+        for (int b = 0; b < 6; ++b, n += 2) memcpy(dst + n, (i >> b) & 1 ? "BB" : "Aa", 2);
+        memcpy(dst + n, falha ? "BB" : "Aa", 2);
+        n += 2;
+    }
+    dst[n] = '\0';
+}
+
+static int bench_compararAmostras(const void *a, const void *b) {
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+/* BenchMedida - resumo das amostras de uma operação (em unidades por operação) */
+typedef struct BenchMedida {
+    double media, p50, p90, p99;
+} BenchMedida;
+
+/* bench_resumir - ordena as amostras e extrai média e percentis */
+static BenchMedida bench_resumir(float *amostras, size_t m) {
+    BenchMedida r = { 0, 0, 0, 0 };
+    if (!m) return r;
+    qsort(amostras, m, sizeof(float), bench_compararAmostras);
+    for (size_t i = 0; i < m; ++i) r.media += amostras[i];
+    r.media /= (double)m;
+    r.p50 = amostras[(m - 1) / 2];
+    r.p90 = amostras[(size_t)((double)(m - 1) * 0.90)];
+    r.p99 = amostras[(size_t)((double)(m - 1) * 0.99)];
+    return r;
+}
+
+/*
+ * bench_medirHash - mede as cinco operações com 'n' chaves da distribuição
+ * em uma tabela de 'n' buckets (carga 1). As inserções novas seguem a ordem
+ * dos índices; atualizações e buscas seguem uma permutação aleatória, e as
+ * falhas usam as chaves de falha dos mesmos índices (ver bench_chaveHash).
+ */
+static void bench_medirHash(int colisoes, size_t n, BenchMedida *res, unsigned long long *soma) {
+    size_t reps = n >= BENCH_MIN_OPS ? 1 : BENCH_MIN_OPS / n;
+    size_t lotes = (n + BENCH_LOTE - 1) / BENCH_LOTE;
+    float *am[BH_OPS];
+    uint32_t *perm = malloc(n * sizeof(uint32_t));
+    if (!perm) { fprintf(stderr, "Erro: memória insuficiente para a medição.\n"); exit(EXIT_FAILURE); }
+    for (int o = 0; o < BH_OPS; ++o) {
+        am[o] = malloc(reps * lotes * sizeof(float));
+        if (!am[o]) { fprintf(stderr, "Erro: memória insuficiente para a medição.\n"); exit(EXIT_FAILURE); }
+    }
+    unsigned long long rng = 0x5eed + n;
+    for (size_t i = 0; i < n; ++i) perm[i] = (uint32_t)i;
+    for (size_t i = n; i > 1; --i) {   // Fisher–Yates
+        size_t j = (size_t)(rng_proximo(&rng) % i);
+        uint32_t t = perm[i - 1]; perm[i - 1] = perm[j]; perm[j] = t;
+    }
+
+    char chaves[BENCH_LOTE][64];
+    size_t m = 0;                      // amostras por operação até aqui
+    for (size_t r = 0; r < reps; ++r) {
+        HashTable *ht = criarHashTable(n);
+        for (int o = 0; o < BH_OPS; ++o) {
+            for (size_t b = 0; b < lotes; ++b) {
+                size_t ini = b * BENCH_LOTE, k = n - ini < BENCH_LOTE ? n - ini : BENCH_LOTE;
+                for (size_t j = 0; j < k; ++j) {
+                    unsigned long long i = o <= BH_NOVA ? ini + j : perm[ini + j];
+                    bench_chaveHash(colisoes, i, o == BH_FALHA, chaves[j]);
+                }
+                unsigned long long c0 = bench_ciclos();
+                switch (o) {
+                case BH_HASH:     for (size_t j = 0; j < k; ++j) *soma += hash_simple(chaves[j], n); break;
+                case BH_NOVA:     for (size_t j = 0; j < k; ++j) inserirNaHash(ht, chaves[j], "Sr. Andrade"); break;
+                case BH_ATUALIZA: for (size_t j = 0; j < k; ++j) inserirNaHash(ht, chaves[j], "Sra. Monteiro"); break;
+                default:          for (size_t j = 0; j < k; ++j) *soma += encontrarSuspeito(ht, chaves[j]) != NULL; break;
+                }
+                am[o][m + b] = (float)(bench_ciclos() - c0) / (float)k;
+            }
+        }
+        m += lotes;
+        liberarHashTable(ht);
+    }
+    for (int o = 0; o < BH_OPS; ++o) {
+        res[o] = bench_resumir(am[o], m);
+        free(am[o]);
+    }
+    free(perm);
+}
+
+/* BenchBase - mediana registrada de uma medição no arquivo-base */
+typedef struct BenchBase {
+    char chaves[16], op[32];
+    unsigned long long n;
+    double p50;
+} BenchBase;
+
+/*
+ * benchHash - roda os microbenchmarks para n = 10^2 .. nMax (potências de 10)
+ * nas duas distribuições de chaves. Se 'caminhoBase' existir, compara a
+ * mediana de cada medição com a registrada e dá o veredito (retorna 1 se
+ * alguma piorou mais que BENCH_TOLERANCIA); senão grava as medianas nele.
+ */
+int benchHash(size_t nMax, const char *caminhoBase) {
+    BenchBase base[BENCH_MAX_BASE];
+    size_t nBase = 0;
+    FILE *f = caminhoBase ? fopen(caminhoBase, "r") : NULL;
+    int comparar = f != NULL;
+    if (f) {
+        char linha[256];
+        while (nBase < BENCH_MAX_BASE && fgets(linha, sizeof(linha), f)) {
+            BenchBase *b = &base[nBase];
+            if (linha[0] != '#' && sscanf(linha, "%15s %llu %31s %lf", b->chaves, &b->n, b->op, &b->p50) == 4) nBase++;
+        }
+        fclose(f);
+    } else if (caminhoBase) {
+        f = fopen(caminhoBase, "w");
+        if (!f) { fprintf(stderr, "Erro: não foi possível criar %s.\n", caminhoBase); return 1; }
+        fprintf(f, "# dq --bench-hash: chaves n operação mediana (%s/op)\n", BENCH_UNIDADE);
+    }
+
+    printf("Tabela hash: %s/op em lotes de %d operações, buckets = chaves (carga 1)\n", BENCH_UNIDADE, BENCH_LOTE);
+    printf("  %-9s %9s %-17s %8s %8s %8s %8s", "chaves", "n", "operação", "média", "p50", "p90", "p99");
+    if (comparar) printf(" %9s %8s  veredito", "base p50", "variação");
+    printf("\n");
+    unsigned long long soma = 0;
+    size_t piores = 0, comparadas = 0;
+    for (int colisoes = 0; colisoes < 2; ++colisoes) {
+        for (size_t n = 100; n <= nMax; n *= 10) {
+            BenchMedida res[BH_OPS], rodada[BH_OPS];
+            bench_medirHash(colisoes, n, res, &soma);
+            for (int r = 1; r < BENCH_RODADAS; ++r) {
+                bench_medirHash(colisoes, n, rodada, &soma);
+                for (int o = 0; o < BH_OPS; ++o)
+                    if (rodada[o].p50 < res[o].p50) res[o] = rodada[o];
+            }
+            for (int o = 0; o < BH_OPS; ++o) {
+                printf("  %-9s %9zu %-17s %8.1f %8.1f %8.1f %8.1f", BENCH_CHAVES_HASH[colisoes], n,
+                       BENCH_OPS_HASH[o], res[o].media, res[o].p50, res[o].p90, res[o].p99);
+                if (comparar) {
+                    const BenchBase *b = NULL;
+                    for (size_t i = 0; i < nBase && !b; ++i)
+                        if (base[i].n == n && strcmp(base[i].chaves, BENCH_CHAVES_HASH[colisoes]) == 0 &&
+                            strcmp(base[i].op, BENCH_OPS_HASH[o]) == 0) b = &base[i];
+                    if (b && b->p50 > 0) {
+                        double var = res[o].p50 / b->p50 - 1.0;
+                        int pior = var > BENCH_TOLERANCIA;
+                        piores += pior;
+                        comparadas++;
+                        printf(" %9.1f %+7.1f%%  %s", b->p50, var * 100.0,
+                               pior ? "PIOROU" : var < -BENCH_TOLERANCIA ? "melhorou" : "igual");
+                    } else {
+                        printf(" %9s %8s  sem base", "-", "-");
+                    }
+                } else if (f) {
+                    fprintf(f, "%s %zu %s %.2f\n", BENCH_CHAVES_HASH[colisoes], n, BENCH_OPS_HASH[o], res[o].p50);
+                }
+                printf("\n");
+            }
+        }
+    }
+    printf("  (checksum %llu)\n", soma);
+    if (comparar) {
+        printf("Regressão em relação a %s: %s (%zu de %zu medições acima de +%.0f%%)\n", caminhoBase,
+               piores ? "SIM" : "NÃO", piores, comparadas, BENCH_TOLERANCIA * 100.0);
+        return piores ? 1 : 0;
+    }
+    if (f) {
+        fclose(f);
+        printf("Base gravada em %s (as próximas execuções comparam com ela).\n", caminhoBase);
+    }
+    return 0;
+}
+
+/*
+ * benchFiltro - efeito do filtro de Bloom em encontrarSuspeito
+ * (./mestre --bench-filtro [n]): tabela de 'n' buckets com 'n' pistas e
+ * 'n' buscas de pistas ausentes e presentes, com o filtro ligado e desligado
+ * (bench_chaveHash, chaves reais). Confere que as respostas são as mesmas
+ * nos dois casos e mede a taxa de falsos positivos e a memória do filtro.
+ */
+int benchFiltro(size_t n) {
+    if (n < 1) n = 1;
+    char *falhas = malloc(n * 64), *acertos = malloc(n * 64);
+    if (!falhas || !acertos) { fprintf(stderr, "Erro: memória insuficiente para a medição.\n"); exit(EXIT_FAILURE); }
+    HashTable *ht = criarHashTable(n);
+    for (size_t i = 0; i < n; ++i) {
+        bench_chaveHash(0, i, 0, acertos + i * 64);
+        inserirNaHash(ht, acertos + i * 64, i & 1 ? "Sr. Andrade" : "Sra. Monteiro");
+        bench_chaveHash(0, i, 1, falhas + i * 64);
+    }
+    unsigned long long rng = 0xb100;
+    for (size_t i = n; i > 1; --i) {   // consulta as presentes fora da ordem de inserção
+        size_t j = (size_t)(rng_proximo(&rng) % i);
+        char t[64];
+        memcpy(t, acertos + (i - 1) * 64, 64);
+        memcpy(acertos + (i - 1) * 64, acertos + j * 64, 64);
+        memcpy(acertos + j * 64, t, 64);
+    }
+    size_t falsos = 0;
+    for (size_t i = 0; i < n; ++i) falsos += (size_t)filtro_talvez(ht, hash_filtro(falhas + i * 64, strlen(falhas + i * 64)));
+
+    double ns[2][2];                   // [filtro desligado/ligado][falha/acerto]
+    size_t achados[2][2];
+    BlocoFiltro *filtro = ht->filtro;
+    for (int ligado = 0; ligado < 2; ++ligado) {
+        ht->filtro = ligado ? filtro : NULL; // desligado: encontrarSuspeito como antes do filtro
+        for (int acerto = 0; acerto < 2; ++acerto) {
+            const char *chaves = acerto ? acertos : falhas;
+            size_t k = 0;
+            unsigned long long t0 = agora_ns();
+            for (size_t i = 0; i < n; ++i) k += encontrarSuspeito(ht, chaves + i * 64) != NULL;
+            ns[ligado][acerto] = (double)(agora_ns() - t0) / (double)n;
+            achados[ligado][acerto] = k;
+        }
+    }
+    ht->filtro = filtro;
+    int erros = achados[0][0] != 0 || achados[1][0] != 0 || achados[0][1] != n || achados[1][1] != n;
+
+    size_t bytes = ht->nBlocosFiltro * sizeof(BlocoFiltro);
+    printf("Filtro de Bloom da hash: %zu pistas, %zu buckets, %zu buscas de cada tipo\n", n, ht->tamanho, n);
+    printf("  conferência: %s\n", erros ? "ERRO" : "ok");
+    printf("  filtro: %zu bytes (%.1f bits/pista), falsos positivos %.3f%% (%zu de %zu ausentes)\n",
+           bytes, 8.0 * (double)bytes / (double)n, 100.0 * (double)falsos / (double)n, falsos, n);
+    printf("  %-22s %14s %14s\n", "encontrarSuspeito", "ns/ausente", "ns/presente");
+    printf("  %-22s %14.1f %14.1f\n", "sem filtro", ns[0][0], ns[0][1]);
+    printf("  %-22s %14.1f %14.1f\n", "com filtro", ns[1][0], ns[1][1]);
+
+    liberarHashTable(ht);
+    free(falhas);
+    free(acertos);
+    return erros ? 1 : 0;
+}
+
+/*
+ * Gerador de carga para o servidor (./bench_mestre --carga endereço [sessões] [simultâneas]).
+ * Mantém 'simultaneas' conexões abertas; cada uma joga o roteiro abaixo
+ * (mesmo caminho da mansão em toda sessão) e, ao ser fechada pelo servidor
+ * depois do veredito, dá lugar a uma nova sessão. A latência de um
+ * movimento vai do envio do comando até a chegada do prompt seguinte.
+ */
+static const char *const CARGA_ROTEIRO[] = { "e", "e", "v", "d", "v", "v", "d", "d", "d", "s", "R. Martins" };
+#define CARGA_PASSOS (sizeof(CARGA_ROTEIRO) / sizeof(CARGA_ROTEIRO[0]))
+#define CARGA_FIM    48                // bytes finais guardados para reconhecer o prompt
+
+/* ClienteCarga - uma sessão em andamento no gerador de carga */
+typedef struct ClienteCarga {
+    int fd;
+    size_t passo;                     // comandos do roteiro já enviados
+    unsigned long long t0;            // envio do último comando
+    size_t nFim;
+    char fim[CARGA_FIM];              // final do que chegou desde o último comando
+} ClienteCarga;
+
+/* carga_conectar - abre uma sessão nova no cliente 'c'; retorna 0 se conectou */
+static int carga_conectar(ClienteCarga *c, const char *endereco, int ep) {
+    c->fd = abrirEndereco(endereco, 0);
+    if (c->fd < 0) return -1;
+    fcntl(c->fd, F_SETFL, fcntl(c->fd, F_GETFL) | O_NONBLOCK);
+    c->passo = 0;
+    c->nFim = 0;
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = c };
+    epoll_ctl(ep, EPOLL_CTL_ADD, c->fd, &ev);
+    return 0;
+}
+
+/* carga_prompt - a resposta acumulada termina num prompt? */
+static int carga_prompt(const ClienteCarga *c) {
+    static const char *const PROMPTS[] = { SERV_PROMPT_MOVER, SERV_PROMPT_ACUSAR };
+    for (size_t i = 0; i < 2; ++i) {
+        size_t n = strlen(PROMPTS[i]);
+        if (c->nFim >= n && memcmp(c->fim + c->nFim - n, PROMPTS[i], n) == 0) return 1;
+    }
+    return 0;
+}
+
+int benchCarga(const char *endereco, size_t sessoes, size_t simultaneas) {
+    if (sessoes < 1) sessoes = 1;
+    if (simultaneas < 1) simultaneas = 1;
+    if (simultaneas > sessoes) simultaneas = sessoes;
+    elevarLimiteDescritores();
+    size_t movimentosPorSessao = 0;
+    for (size_t i = 0; i < CARGA_PASSOS; ++i) movimentosPorSessao += strlen(CARGA_ROTEIRO[i]) == 1 && strchr("edv", CARGA_ROTEIRO[i][0]);
+    ClienteCarga *clientes = calloc(simultaneas, sizeof(ClienteCarga));
+    float *latencias = malloc(sessoes * movimentosPorSessao * sizeof(float));
+    int ep = epoll_create1(EPOLL_CLOEXEC);
+    if (!clientes || !latencias || ep < 0) { fprintf(stderr, "Erro: memória insuficiente para a medição.\n"); exit(EXIT_FAILURE); }
+    signal(SIGPIPE, SIG_IGN);
+
+    size_t iniciadas = 0, concluidas = 0, falhas = 0, nLat = 0, ativas = 0;
+    unsigned long long t0 = agora_ns();
+    for (size_t i = 0; i < simultaneas; ++i, ++iniciadas) {
+        if (carga_conectar(&clientes[i], endereco, ep) < 0) {
+            fprintf(stderr, "Erro: não foi possível conectar em %s: %s\n", endereco, strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+        ativas++;
+    }
+    struct epoll_event eventos[SERV_EVENTOS];
+    char buf[4096];
+    while (ativas) {
+        int n = epoll_wait(ep, eventos, SERV_EVENTOS, 10000);
+        if (n == 0) { fprintf(stderr, "Erro: servidor parou de responder.\n"); break; }
+        if (n < 0) { if (errno == EINTR) continue; perror("epoll_wait"); break; }
+        for (int k = 0; k < n; ++k) {
+            ClienteCarga *c = eventos[k].data.ptr;
+            int fechou = 0;
+            for (;;) {
+                ssize_t r = read(c->fd, buf, sizeof(buf));
+                if (r < 0 && errno == EINTR) continue;
+                if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+                if (r <= 0) { fechou = 1; break; }
+                size_t m = (size_t)r;  // guarda só o final (o prompt cabe em CARGA_FIM)
+                if (m >= CARGA_FIM) { memcpy(c->fim, buf + m - CARGA_FIM, CARGA_FIM); c->nFim = CARGA_FIM; }
+                else {
+                    if (c->nFim + m > CARGA_FIM) { memmove(c->fim, c->fim + c->nFim + m - CARGA_FIM, CARGA_FIM - m); c->nFim = CARGA_FIM - m; }
+                    memcpy(c->fim + c->nFim, buf, m);
+                    c->nFim += m;
+                }
+            }
+            if (!fechou && carga_prompt(c) && c->passo < CARGA_PASSOS) {
+                unsigned long long agora = agora_ns();
+                if (c->passo > 0 && strchr("edv", CARGA_ROTEIRO[c->passo - 1][0]) && !CARGA_ROTEIRO[c->passo - 1][1])
+                    latencias[nLat++] = (float)(agora - c->t0);
+                char linha[64];
+                int tam = snprintf(linha, sizeof(linha), "%s\n", CARGA_ROTEIRO[c->passo++]);
+                c->nFim = 0;
+                c->t0 = agora;
+                if (write(c->fd, linha, (size_t)tam) != tam) fechou = 1; // comando curto: cabe no socket
+            }
+            if (fechou) {
+                close(c->fd);
+                ativas--;
+                if (c->passo == CARGA_PASSOS) concluidas++; else falhas++;
+                if (iniciadas < sessoes) {
+                    iniciadas++;
+                    if (carga_conectar(c, endereco, ep) == 0) ativas++; else falhas++;
+                }
+            }
+        }
+    }
+    unsigned long long t = agora_ns() - t0;
+
+    BenchMedida lat = bench_resumir(latencias, nLat);
+    printf("Carga em %s: %zu sessões (%zu simultâneas), %zu concluídas, %zu falhas\n",
+           endereco, sessoes, simultaneas, concluidas, falhas);
+    printf("  tempo: %.1f ms, %.0f sessões/s, %.0f comandos/s\n", (double)t / 1e6,
+           (double)concluidas * 1e9 / (double)t, (double)concluidas * CARGA_PASSOS * 1e9 / (double)t);
+    printf("  latência por movimento (%zu medidos): média %.1f us, p50 %.1f us, p90 %.1f us, p99 %.1f us\n",
+           nLat, lat.media / 1e3, lat.p50 / 1e3, lat.p90 / 1e3, lat.p99 / 1e3);
+    close(ep);
+    free(latencias);
+    free(clientes);
+    return falhas ? 1 : 0;
+}
+
+/* bench_primeiraResposta - conecta em 'endereco' e lê a primeira resposta (até 2 s); "" se nada chegou */
+static void bench_primeiraResposta(const char *endereco, char *buf, size_t cap) {
+    buf[0] = '\0';
+    int fd = abrirEndereco(endereco, 0);
+    if (fd < 0) return;
+    struct timeval limite = { 2, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &limite, sizeof(limite));
+    ssize_t n;
+    do n = read(fd, buf, cap - 1); while (n < 0 && errno == EINTR);
+    if (n > 0) buf[n] = '\0';
+    close(fd);
+}
+
+/* bench_maiorDescritor - maior descritor aberto no processo 'pid' (-1 se não deu para ler) */
+static int bench_maiorDescritor(pid_t pid) {
+    char caminho[64];
+    snprintf(caminho, sizeof(caminho), "/proc/%d/fd", (int)pid);
+    DIR *dir = opendir(caminho);
+    if (!dir) return -1;
+    int maior = -1;
+    struct dirent *e;
+    while ((e = readdir(dir)) != NULL)
+        if (e->d_name[0] != '.' && atoi(e->d_name) > maior) maior = atoi(e->d_name);
+    closedir(dir);
+    return maior;
+}
+
+/*
+ * testarServidor - verificação de regressão do servidor sem descritores. O
+ * servidor roda num processo filho; com ele já escutando e sem conexões, o
+ * limite flexível de descritores do filho desce (prlimit) até o que ele tem
+ * aberto, então toda conexão cai no caminho da reserva (accept4 com EMFILE)
+ * e tem de ser recusada com o aviso, inclusive as que chegam depois da
+ * primeira, sem nenhuma conexão aberta que pudesse devolver a escuta ao
+ * epoll. Com o limite de volta, a próxima conexão tem de abrir o jogo.
+ */
+int testarServidor(const char *endereco) {
+    if (strchr(endereco, '/')) unlink(endereco);
+    fflush(stdout);
+    pid_t filho = fork();
+    if (filho < 0) { perror("fork"); return 1; }
+    if (filho == 0) {
+        int nulo = open("/dev/null", O_WRONLY);
+        dup2(nulo, STDOUT_FILENO);
+        close(nulo);
+        _exit(servidorJogo(endereco, versaoCriar(montarMapaComPistas(), montarAssociacoes(), "embutido"), NULL));
+    }
+    int falhas = 0, espera = 0, status;
+    char resposta[4096];
+    struct rlimit original, apertado;
+#define TESTE(cond, descricao) do { int ok_ = (cond); printf("  %-6s %s\n", ok_ ? "ok" : "FALHOU", descricao); falhas += !ok_; } while (0)
+
+    printf("Servidor sem descritores:\n");
+    do {                               // espera o filho começar a escutar (até 2 s)
+        usleep(10000);
+        bench_primeiraResposta(endereco, resposta, sizeof(resposta));
+    } while (!resposta[0] && ++espera < 200);
+    TESTE(strstr(resposta, "Hall") != NULL, "servidor no ar");
+    usleep(100000);                    // o servidor fecha a conexão acima
+    int maior = bench_maiorDescritor(filho);
+    int ok = maior >= 0 && prlimit(filho, RLIMIT_NOFILE, NULL, &original) == 0;
+    apertado = original;
+    apertado.rlim_cur = (rlim_t)maior + 1;
+    TESTE(ok && prlimit(filho, RLIMIT_NOFILE, &apertado, NULL) == 0, "limite do servidor reduzido ao que ele tem aberto");
+    bench_primeiraResposta(endereco, resposta, sizeof(resposta));
+    TESTE(strstr(resposta, "lotado") != NULL, "primeira conexão recusada com aviso");
+    bench_primeiraResposta(endereco, resposta, sizeof(resposta));
+    TESTE(strstr(resposta, "lotado") != NULL, "segunda conexão também recusada (escuta continua no epoll)");
+    bench_primeiraResposta(endereco, resposta, sizeof(resposta));
+    TESTE(strstr(resposta, "lotado") != NULL, "terceira conexão também recusada");
+    TESTE(ok && prlimit(filho, RLIMIT_NOFILE, &original, NULL) == 0, "limite do servidor restaurado");
+    bench_primeiraResposta(endereco, resposta, sizeof(resposta));
+    TESTE(strstr(resposta, "Hall") != NULL, "com descritores de volta, a conexão abre o jogo");
+    kill(filho, SIGINT);
+    TESTE(waitpid(filho, &status, 0) == filho && WIFEXITED(status) && WEXITSTATUS(status) == 0,
+          "servidor encerra normalmente");
+#undef TESTE
+    printf(falhas ? "%d caso(s) falharam.\n" : "Todos os casos passaram.\n", falhas);
+    return falhas ? 1 : 0;
+}
+
+/*
+ * benchSessoes - mantém 'n' sessões em andamento numa única thread e as
+ * alimenta em rodízio com comandos sorteados (e/d/v; de vez em quando 's' e
+ * uma acusação, e a sessão encerrada dá lugar a uma nova). Mede o custo por
+ * comando e a memória de estado por sessão.
+ */
+int benchSessoes(size_t n, size_t comandos) {
+    static const char *const ACUSADOS[] = { "Sr. Andrade", "Sra. Monteiro", "R. Martins", "Dr. Silva", "Mordomo" };
+    if (n < 1) n = 1;
+    Sala *mapa = montarMapaComPistas();
+    HashTable *ht = montarAssociacoes();
+    Catalogo *cat = criarCatalogo(mapa, ht);
+    Mundo m = mundoCriar(mapa, ht, cat);
+    SessaoLote **sessoes = malloc(n * sizeof(SessaoLote *));
+    if (!sessoes) { fprintf(stderr, "Erro: memória insuficiente para a medição.\n"); exit(EXIT_FAILURE); }
+    EventoSessao ev[SESSAO_MAX_EVENTOS];
+    size_t nEv, eventos = 0, encerradas = 0;
+    for (size_t i = 0; i < n; ++i) sessoes[i] = sessaoLoteCriar(&m, ev, &nEv);
+    size_t bytes = sizeof(SessaoLote) + cat->nPalavras * sizeof(uint64_t);
+
+    unsigned long long rng = 38;
+    unsigned long long t0 = agora_ns();
+    for (size_t k = 0; k < comandos; ++k) {
+        size_t i = k % n;
+        SessaoLote *s = sessoes[i];
+        unsigned long long r = rng_proximo(&rng);
+        const char *entrada;
+        if (s->sessao.fase == SES_ACUSANDO) entrada = ACUSADOS[(r >> 8) % 5];
+        else entrada = (r & 15) == 0 ? "s" : (r & 15) < 6 ? "e" : (r & 15) < 11 ? "d" : "v";
+        eventos += sessaoAlimentar(&s->sessao, &m, entrada, ev);
+        if (s->sessao.fase == SES_ENCERRADA) { // o jogador sai, outro entra no lugar
+            free(s);
+            sessoes[i] = sessaoLoteCriar(&m, ev, &nEv);
+            eventos += nEv;
+            encerradas++;
+        }
+    }
+    unsigned long long t = agora_ns() - t0;
+
+    printf("Sessões intercaladas numa thread: %zu em andamento, %zu comandos, %zu eventos, %zu sessões encerradas\n",
+           n, comandos, eventos, encerradas);
+    printf("  estado por sessão: %zu bytes (%zu no heap)\n", bytes, bytesHeap(sessoes[0], bytes));
+    printf("  %.1f ns por comando, %.0f comandos/s\n", (double)t / (double)(comandos ? comandos : 1),
+           t ? (double)comandos * 1e9 / (double)t : 0.0);
+    for (size_t i = 0; i < n; ++i) free(sessoes[i]);
+    free(sessoes);
+    liberarCatalogo(cat);
+    liberarHashTable(ht);
+    liberarSalas(mapa);
+    return 0;
+}
+
+/* bench_buscarSala - primeira sala em pré-ordem chamada 'nome', percorrendo a árvore (como antes do índice) */
+static const Sala *bench_buscarSala(const Sala *s, const char *nome) {
+    if (!s) return NULL;
+    if (strcmp(salaNome(s), nome) == 0) return s;
+    const Sala *r = bench_buscarSala(s->esq, nome);
+    return r ? r : bench_buscarSala(s->dir, nome);
+}
+
+/* bench_nomeSala - nome da sala i do mapa sintético: 1 em 16 é um "Corredor" com 63 homônimos */
+static void bench_nomeSala(size_t i, char *dst, size_t cap) {
+    if (i % 16 == 15) snprintf(dst, cap, "Corredor %zu", i / 1024);
+    else snprintf(dst, cap, "Sala %zu", i);
+}
+
+/*
+ * benchSalas - índice de nomes do catálogo (./mestre --bench-salas [n]):
+ * mapa completo de 'n' salas (ver bench_nomeSala), buscas pelo índice
+ * (presentes e ausentes) contra a busca que percorre a árvore, e
+ * teletransportes pela sessão seguidos de "voltar" até o Hall, conferindo
+ * que a cadeia de 'pai' tem a profundidade da sala no mapa.
+ */
+int benchSalas(size_t n) {
+    const size_t CONSULTAS = 1000000, PERCURSOS = 5, TELES = 100000;
+    if (n < 2) n = 2;
+    Sala **salas = malloc(n * sizeof(Sala *));
+    char (*nomes)[32] = malloc(CONSULTAS * sizeof(*nomes));
+    char (*ausentes)[32] = malloc(CONSULTAS * sizeof(*ausentes));
+    size_t *indice = malloc(CONSULTAS * sizeof(size_t)); // posição da sala sorteada no vetor (largura)
+    long *id = malloc(CONSULTAS * sizeof(long));          // resposta do índice (pré-ordem)
+    if (!salas || !nomes || !ausentes || !indice || !id) {
+        fprintf(stderr, "Erro: memória insuficiente para a medição.\n");
+        exit(EXIT_FAILURE);
+    }
+    char nome[32];
+    for (size_t i = 0; i < n; ++i) {
+        bench_nomeSala(i, nome, sizeof(nome));
+        salas[i] = criarSala(nome, NULL);
+    }
+    for (size_t i = 0; i < n; ++i)
+        conectarFilhos(salas[i], 2 * i + 1 < n ? salas[2 * i + 1] : NULL, 2 * i + 2 < n ? salas[2 * i + 2] : NULL);
+    HashTable *ht = criarHashTable(1);
+    unsigned long long t0 = agora_ns();
+    Catalogo *cat = criarCatalogo(salas[0], ht);
+    unsigned long long tCatalogo = agora_ns() - t0;
+    unsigned long long rng = 41;
+    for (size_t q = 0; q < CONSULTAS; ++q) {
+        indice[q] = (size_t)(rng_proximo(&rng) % n);
+        bench_nomeSala(indice[q], nomes[q], sizeof(nomes[q]));
+        snprintf(ausentes[q], sizeof(ausentes[q]), "Sala %zu", n + q); // nenhuma sala tem esse número
+    }
+
+    size_t achadas = 0, erros = 0;
+    t0 = agora_ns();
+    for (size_t q = 0; q < CONSULTAS; ++q) id[q] = buscarSalaId(cat, nomes[q]);
+    unsigned long long tAcerto = agora_ns() - t0;
+    t0 = agora_ns();
+    for (size_t q = 0; q < CONSULTAS; ++q) achadas += buscarSalaId(cat, ausentes[q]) >= 0;
+    unsigned long long tFalha = agora_ns() - t0;
+    erros += achadas;
+    for (size_t q = 0; q < CONSULTAS; ++q) { // nome certo; homônimos em pré-ordem, todos com o mesmo nome
+        if (id[q] < 0 || strcmp(salaNome(cat->salas[id[q]]), nomes[q]) != 0) { erros++; continue; }
+        if (q < 1000)
+            for (uint32_t k = (uint32_t)id[q]; cat->mesmoNome[k] != UINT32_MAX; k = cat->mesmoNome[k])
+                erros += cat->mesmoNome[k] <= k || strcmp(salaNome(cat->salas[cat->mesmoNome[k]]), nomes[q]) != 0;
+    }
+    t0 = agora_ns();
+    for (size_t q = 0; q < PERCURSOS; ++q) erros += bench_buscarSala(salas[0], nomes[q]) != cat->salas[id[q]];
+    unsigned long long tPercurso = agora_ns() - t0;
+
+    Mundo m = mundoCriar(salas[0], ht, cat);
+    Sessao sessao;
+    EventoSessao ev[SESSAO_MAX_EVENTOS];
+    char entrada[48];
+    size_t passos = 0;
+    sessaoIniciar(&sessao, &m, NULL, ev);
+    t0 = agora_ns();
+    for (size_t q = 0; q < TELES; ++q) {
+        snprintf(entrada, sizeof(entrada), nomes[q][0] == 'C' ? "t %s #1" : "t %s", nomes[q]); // homônimos pedem o número
+        sessaoAlimentar(&sessao, &m, entrada, ev);
+        erros += sessaoSala(&sessao) != cat->salas[id[q]];
+        size_t profundidade = 0;       // na árvore completa, a sala i está no nível floor(log2(i + 1))
+        while (sessaoSala(&sessao)->pai) {
+            sessaoAlimentar(&sessao, &m, "v", ev);
+            ++profundidade;
+        }
+        erros += profundidade != (size_t)(63 - __builtin_clzll((unsigned long long)indice[q] + 1)) && nomes[q][0] == 'S';
+        passos += profundidade + 1;
+    }
+    unsigned long long tTele = agora_ns() - t0;
+
+    size_t bytes = cat->capNomes * sizeof(uint64_t) + cat->nSalas * sizeof(uint32_t);
+    printf("Índice de salas por nome: %zu salas (1 em 16 com 63 homônimos), %zu consultas\n", n, CONSULTAS);
+    printf("  conferência: %s\n", erros ? "ERRO" : "ok");
+    printf("  índice: %zu bytes (%.1f B/sala), %zu posições; catálogo montado em %.1f ms\n",
+           bytes, (double)bytes / (double)n, cat->capNomes, (double)tCatalogo / 1e6);
+    printf("  buscarSalaId:        %8.1f ns/presente %8.1f ns/ausente\n",
+           (double)tAcerto / (double)CONSULTAS, (double)tFalha / (double)CONSULTAS);
+    printf("  percorrendo o mapa:  %8.1f ms/busca\n", (double)tPercurso / 1e6 / (double)PERCURSOS);
+    printf("  teletransporte + voltar até o Hall: %.1f ns/comando (%zu comandos)\n",
+           (double)tTele / (double)passos, passos);
+
+    liberarCatalogo(cat);
+    liberarHashTable(ht);
+    liberarSalas(salas[0]);
+    free(salas);
+    free(nomes);
+    free(ausentes);
+    free(indice);
+    free(id);
+    return erros ? 1 : 0;
+}
+
+/* prenomes e sobrenomes dos suspeitos sintéticos; cada sobrenome com e sem acento */
+static const char *const BENCH_TITULOS[] = { "", "Dr. ", "Dra. ", "Sr. ", "Sra. ", "Prof. " };
+static const char *const BENCH_PRENOMES[] = {
+    "Ana", "Bruno", "Carla", "Diego", "Elisa", "Fábio", "Gabriela", "Heitor", "Isabel", "João",
+    "Karina", "Lúcio", "Marta", "Nélson", "Otávio", "Paula", "Quitéria", "Rafael", "Sônia", "Túlio",
+    "Úrsula", "Vânia", "Wagner", "Ximena", "Yara", "Zélia", "Antônio", "Beatriz", "Caio", "Débora",
+    "Emílio", "Flávia", "Gustavo", "Helena", "Inácio", "Júlia", "Leandro", "Mônica", "Natália", "Renato"
+};
+static const char *const BENCH_SOBRENOMES[][2] = {
+    { "Silva", "SILVA" }, { "Conceição", "CONCEICAO" }, { "Araújo", "ARAUJO" }, { "Gonçalves", "GONCALVES" },
+    { "Simões", "SIMOES" }, { "Magalhães", "MAGALHAES" }, { "Brandão", "BRANDAO" }, { "Romão", "ROMAO" },
+    { "Antunes", "ANTUNES" }, { "Bastos", "BASTOS" }, { "Cardoso", "CARDOSO" }, { "Damasceno", "DAMASCENO" },
+    { "Estêvão", "ESTEVAO" }, { "Falcão", "FALCAO" }, { "Guimarães", "GUIMARAES" }, { "Hipólito", "HIPOLITO" },
+    { "Ildefonso", "ILDEFONSO" }, { "Jordão", "JORDAO" }, { "Leitão", "LEITAO" }, { "Monteiro", "MONTEIRO" },
+    { "Nóbrega", "NOBREGA" }, { "Orléans", "ORLEANS" }, { "Peixoto", "PEIXOTO" }, { "Quaresma", "QUARESMA" },
+    { "Rebouças", "REBOUCAS" }, { "Sampaio", "SAMPAIO" }, { "Teixeira", "TEIXEIRA" }, { "Ulhôa", "ULHOA" },
+    { "Valadão", "VALADAO" }, { "Xavier", "XAVIER" }, { "Zanetti", "ZANETTI" }, { "Abreu", "ABREU" },
+    { "Barroso", "BARROSO" }, { "Coutinho", "COUTINHO" }, { "D'Ávila", "DAVILA" }, { "Figueiredo", "FIGUEIREDO" },
+    { "Garcia", "GARCIA" }, { "Henriques", "HENRIQUES" }, { "Lacerda", "LACERDA" }, { "Macedo", "MACEDO" },
+    { "Nogueira", "NOGUEIRA" }, { "Oliveira", "OLIVEIRA" }, { "Pacheco", "PACHECO" }, { "Queiroz", "QUEIROZ" },
+    { "Ribeiro", "RIBEIRO" }, { "Sá", "SA" }, { "Tavares", "TAVARES" }, { "Vasconcelos", "VASCONCELOS" },
+    { "Werneck", "WERNECK" }, { "Moura", "MOURA" }
+};
+#define BENCH_N_TITULOS    (sizeof(BENCH_TITULOS) / sizeof(BENCH_TITULOS[0]))
+#define BENCH_N_PRENOMES   (sizeof(BENCH_PRENOMES) / sizeof(BENCH_PRENOMES[0]))
+#define BENCH_N_SOBRENOMES (sizeof(BENCH_SOBRENOMES) / sizeof(BENCH_SOBRENOMES[0]))
+
+/*
+ * bench_nomeSuspeito - nome do suspeito i: título, prenome e dois
+ * sobrenomes, espalhados pelas combinações (número no fim depois que elas
+ * acabam). Com 'variante', a mesma pessoa como alguém digitaria às pressas:
+ * caixa alta, sem pontos e sem acentos nos sobrenomes.
+ */
+static void bench_nomeSuspeito(size_t i, int variante, char *dst, size_t cap) {
+    const size_t combinacoes = BENCH_N_TITULOS * BENCH_N_PRENOMES * BENCH_N_SOBRENOMES * BENCH_N_SOBRENOMES;
+    size_t c = (size_t)(((unsigned long long)(i % combinacoes) * 7919u) % combinacoes); // 7919 é primo com 'combinacoes'
+    size_t s2 = c % BENCH_N_SOBRENOMES, s1 = c / BENCH_N_SOBRENOMES % BENCH_N_SOBRENOMES;
+    size_t p = c / BENCH_N_SOBRENOMES / BENCH_N_SOBRENOMES % BENCH_N_PRENOMES;
+    size_t t = c / BENCH_N_SOBRENOMES / BENCH_N_SOBRENOMES / BENCH_N_PRENOMES;
+    int k = snprintf(dst, cap, "%s%s %s %s", BENCH_TITULOS[t], BENCH_PRENOMES[p],
+                     BENCH_SOBRENOMES[s1][variante], BENCH_SOBRENOMES[s2][variante]);
+    if (i >= combinacoes && k > 0 && (size_t)k < cap) snprintf(dst + k, cap - (size_t)k, " %zu", i / combinacoes + 1);
+    if (variante)
+        for (char *q = dst; *q; ++q) {
+            if (*q == '.') *q = ' ';
+            else if (*q >= 'a' && *q <= 'z') *q = (char)(*q - ('a' - 'A'));
+        }
+}
+
+/* bench_errarNome - chave normalizada de 'nome' com um erro de digitação (troca, falta, sobra ou inversão) */
+static void bench_errarNome(const char *nome, unsigned long long *rng, char *dst, size_t cap) {
+    size_t n = normalizarNome(nome, dst, cap);
+    size_t i = (size_t)(rng_proximo(rng) % n);
+    char letra = (char)('a' + rng_proximo(rng) % 26);
+    switch (rng_proximo(rng) % 4) {
+    case 0: dst[i] = letra; break;
+    case 1: memmove(dst + i, dst + i + 1, n - i); break;
+    case 2: if (n + 1 < cap) { memmove(dst + i + 1, dst + i, n - i + 1); dst[i] = letra; } break;
+    default: if (i + 1 < n) { char t = dst[i]; dst[i] = dst[i + 1]; dst[i + 1] = t; } break;
+    }
+}
+
+/*
+ * benchSuspeitos - registro de suspeitos (./mestre --bench-suspeitos [n]):
+ * 'n' nomes sintéticos (ver bench_nomeSuspeito), buscas pela grafia exata e
+ * pela variante sem caixa, pontos e acentos, contra a varredura com strcmp
+ * que havia antes; e sugestões para nomes com um erro de digitação
+ * (latência, e com que frequência o nome certo é o primeiro ou está entre
+ * as SUGESTOES_MAX sugestões) e para nomes sem nada parecido.
+ */
+int benchSuspeitos(size_t n) {
+    const size_t CONSULTAS = 200000, VARREDURAS = 200, SUGESTOES = 2000;
+    if (n < 1) n = 1;
+    char **nomes = malloc(n * sizeof(char *));
+    char (*exatos)[96] = malloc(CONSULTAS * sizeof(*exatos));
+    char (*variantes)[96] = malloc(CONSULTAS * sizeof(*variantes));
+    char (*errados)[REG_CHAVE_MAX] = malloc(SUGESTOES * sizeof(*errados));
+    size_t *alvo = malloc(CONSULTAS * sizeof(size_t));
+    float *amostras = malloc(SUGESTOES * sizeof(float));
+    if (!nomes || !exatos || !variantes || !errados || !alvo || !amostras) {
+        fprintf(stderr, "Erro: memória insuficiente para a medição.\n");
+        exit(EXIT_FAILURE);
+    }
+    char nome[96];
+    for (size_t i = 0; i < n; ++i) {
+        bench_nomeSuspeito(i, 0, nome, sizeof(nome));
+        nomes[i] = str_dup(nome);
+    }
+    unsigned long long t0 = agora_ns();
+    RegistroSuspeitos *r = regCriar((const char *const *)nomes, n);
+    unsigned long long tCriar = agora_ns() - t0;
+    unsigned long long rng = 43;
+    for (size_t q = 0; q < CONSULTAS; ++q) {
+        alvo[q] = (size_t)(rng_proximo(&rng) % n);
+        bench_nomeSuspeito(alvo[q], 0, exatos[q], sizeof(exatos[q]));
+        bench_nomeSuspeito(alvo[q], 1, variantes[q], sizeof(variantes[q]));
+    }
+    for (size_t q = 0; q < SUGESTOES; ++q) bench_errarNome(exatos[q], &rng, errados[q], sizeof(errados[q]));
+
+    size_t erros = 0;
+    t0 = agora_ns();
+    for (size_t q = 0; q < CONSULTAS; ++q) erros += regBuscar(r, exatos[q]) != (long)alvo[q];
+    unsigned long long tExato = agora_ns() - t0;
+    t0 = agora_ns();
+    for (size_t q = 0; q < CONSULTAS; ++q) erros += regBuscar(r, variantes[q]) != (long)alvo[q];
+    unsigned long long tVariante = agora_ns() - t0;
+    t0 = agora_ns();
+    for (size_t q = 0; q < VARREDURAS; ++q) { // como buscarSuspeitoId fazia antes do registro
+        size_t i = 0;
+        while (i < n && strcmp(nomes[i], exatos[q]) != 0) ++i;
+        erros += i != alvo[q];
+    }
+    unsigned long long tVarredura = agora_ns() - t0;
+
+    uint32_t ids[SUGESTOES_MAX];
+    size_t primeiro = 0, entre = 0, vazias = 0, total = 0;
+    for (size_t q = 0; q < SUGESTOES; ++q) {
+        t0 = agora_ns();
+        size_t k = regSugerir(r, errados[q], ids, SUGESTOES_MAX);
+        amostras[q] = (float)(agora_ns() - t0) / 1e3f;
+        total += k;
+        vazias += k == 0;
+        primeiro += k && ids[0] == alvo[q];
+        for (size_t j = 0; j < k; ++j) entre += ids[j] == alvo[q];
+    }
+    BenchMedida sug = bench_resumir(amostras, SUGESTOES);
+    size_t incompletos = 0;            // só os dois sobrenomes: não há vizinho de deleção, vale o nível dos trigramas
+    for (size_t q = 0; q < SUGESTOES; ++q) {
+        const char *fim = strrchr(exatos[q], ' '), *sobrenomes = exatos[q];
+        for (const char *p = exatos[q]; p < fim; ++p)
+            if (*p == ' ') sobrenomes = p + 1;
+        t0 = agora_ns();
+        size_t k = regSugerir(r, sobrenomes, ids, SUGESTOES_MAX);
+        amostras[q] = (float)(agora_ns() - t0) / 1e3f;
+        for (size_t j = 0; j < k; ++j) incompletos += strstr(nomes[ids[j]], sobrenomes) != NULL;
+    }
+    BenchMedida inc = bench_resumir(amostras, SUGESTOES);
+    size_t ausentesComSugestao = 0;
+    for (size_t q = 0; q < SUGESTOES; ++q) {
+        char lixo[16];
+        for (size_t j = 0; j < 10; ++j) lixo[j] = (char)('a' + rng_proximo(&rng) % 26);
+        lixo[10] = '\0';
+        t0 = agora_ns();
+        ausentesComSugestao += regSugerir(r, lixo, ids, SUGESTOES_MAX) > 0;
+        amostras[q] = (float)(agora_ns() - t0) / 1e3f;
+    }
+    BenchMedida aus = bench_resumir(amostras, SUGESTOES);
+
+    size_t bytes = regBytes(r);
+    printf("Registro de suspeitos: %zu nomes, %zu trigramas distintos\n", n, r->nListas);
+    printf("  conferência: %s\n", erros ? "ERRO" : "ok");
+    printf("  registro: %zu bytes (%.1f B/suspeito); montado em %.1f ms\n",
+           bytes, (double)bytes / (double)n, (double)tCriar / 1e6);
+    printf("  regBuscar, grafia exata:                %8.1f ns/consulta\n", (double)tExato / (double)CONSULTAS);
+    printf("  regBuscar, sem caixa/pontos/acentos:    %8.1f ns/consulta\n", (double)tVariante / (double)CONSULTAS);
+    printf("  varredura com strcmp (antes):           %8.1f ns/consulta\n", (double)tVarredura / (double)VARREDURAS);
+    printf("  regSugerir, um erro de digitação:  média %.1f us, p50 %.1f, p90 %.1f, p99 %.1f\n",
+           sug.media, sug.p50, sug.p90, sug.p99);
+    printf("    nome certo em 1o: %.1f%%, entre as %d sugestões: %.1f%%, sem sugestão: %.1f%% (%.2f sugestões/consulta)\n",
+           100.0 * (double)primeiro / (double)SUGESTOES, SUGESTOES_MAX, 100.0 * (double)entre / (double)SUGESTOES,
+           100.0 * (double)vazias / (double)SUGESTOES, (double)total / (double)SUGESTOES);
+    printf("  regSugerir, só os dois sobrenomes:    média %.1f us, p50 %.1f, p90 %.1f, p99 %.1f (%.2f sugestões com eles/consulta)\n",
+           inc.media, inc.p50, inc.p90, inc.p99, (double)incompletos / (double)SUGESTOES);
+    printf("  regSugerir, texto sem nada parecido:  média %.1f us, p50 %.1f, p90 %.1f, p99 %.1f (%zu com sugestão)\n",
+           aus.media, aus.p50, aus.p90, aus.p99, ausentesComSugestao);
+
+    liberarRegistro(r);
+    for (size_t i = 0; i < n; ++i) free(nomes[i]);
+    free(nomes);
+    free(exatos);
+    free(variantes);
+    free(errados);
+    free(alvo);
+    free(amostras);
+    return erros ? 1 : 0;
+}
+
+/* bench_resumoMapa - resumo (hash) de nomes, pistas e formato do mapa em pré-ordem */
+static uint64_t bench_resumoMapa(const Sala *s) {
+    if (!s) return 0x51ull;
+    const char *nome = salaNome(s), *pista = salaPista(s);
+    uint64_t h = hash_filtro(nome, strlen(nome)) ^ (pista ? hash_filtro(pista, strlen(pista)) * 3 : 0);
+    h = h * 0x9E3779B97F4A7C15ull + bench_resumoMapa(s->esq);
+    return (h ^ (h >> 29)) * 0xBF58476D1CE4E5B9ull + bench_resumoMapa(s->dir);
+}
+
+/* bench_montarSerial - a carga sala a sala de antes (criarSala e descida a partir do Hall), sem validação */
+static Sala *bench_montarSerial(const ListaSalas *l) {
+    Sala *mapa = NULL;
+    for (size_t i = 0; i < l->n; ++i) {
+        const SalaListada *s = &l->v[i];
+        const char *rota = l->textos + s->rota;
+        Sala *sala = criarSala(l->textos + s->nome, s->pista == LISTA_SEM_PISTA ? NULL : l->textos + s->pista);
+        if (!s->tamRota) { mapa = sala; continue; }
+        Sala *pai = mapa;
+        for (size_t k = 0; k + 1 < s->tamRota; ++k) pai = rota[k] == 'e' ? pai->esq : pai->dir;
+        if (rota[s->tamRota - 1] == 'e') pai->esq = sala;
+        else pai->dir = sala;
+        sala->pai = pai;
+    }
+    return mapa;
+}
+
+/*
+ * benchMontagem - montagem de mapas grandes (./mestre --bench-montagem [n]
+ * [threads]): lista de 'n' salas de uma árvore aleatória, em pré-ordem como
+ * exportarMundo escreve, montada sala a sala (criarSala, liberarSalas) e
+ * por montarMapaParalelo com 1, 2, 4, ... até 'maxThreads' threads, com o
+ * tempo de cada fase e da liberação das arenas. Confere que todos os mapas
+ * são iguais.
+ */
+int benchMontagem(size_t n, unsigned maxThreads) {
+    if (n < 2) n = 2;
+    if (maxThreads < 1) maxThreads = 1;
+    if (maxThreads > MONT_THREADS_MAX) maxThreads = MONT_THREADS_MAX;
+    // árvore aleatória (inserção por descida sorteada) só com índices: filhos[2i] e filhos[2i+1]
+    uint32_t *filhos = calloc(2 * n, sizeof(uint32_t)); // 0 = sem filho (a raiz nunca é filha)
+    if (!filhos) { fprintf(stderr, "Erro: memória insuficiente para a medição.\n"); exit(EXIT_FAILURE); }
+    unsigned long long rng = 45;
+    size_t altura = 1;
+    for (size_t i = 1; i < n; ++i) {
+        size_t p = 0, prof = 1;
+        for (;;) {
+            uint32_t *vaga = &filhos[2 * p + (rng_proximo(&rng) & 1)];
+            ++prof;
+            if (!*vaga) { *vaga = (uint32_t)i; break; }
+            p = *vaga;
+        }
+        if (prof > altura) altura = prof;
+    }
+    // lista em pré-ordem: pilha de (sala, profundidade, lado)
+    ListaSalas lista = { 0 };
+    size_t *pilha = malloc(3 * (altura + 1) * sizeof(size_t));
+    char *rota = malloc(altura + 1), nome[32], pista[48];
+    if (!pilha || !rota) { fprintf(stderr, "Erro: memória insuficiente para a medição.\n"); exit(EXIT_FAILURE); }
+    size_t topo = 0;
+    pilha[0] = 0; pilha[1] = 0; pilha[2] = 0;
+    topo = 1;
+    while (topo) {
+        --topo;
+        size_t s = pilha[3 * topo], prof = pilha[3 * topo + 1];
+        if (prof) rota[prof - 1] = (char)pilha[3 * topo + 2];
+        rota[prof] = '\0';
+        snprintf(nome, sizeof(nome), "Sala %zu", s);
+        snprintf(pista, sizeof(pista), "Pista %zu: marca de bota no assoalho", s);
+        listaAcrescentar(&lista, prof ? rota : "-", nome, s % 3 ? NULL : pista, lista.n + 1);
+        for (int lado = 1; lado >= 0; --lado) // direita entra primeiro: a esquerda sai antes
+            if (filhos[2 * s + lado]) {
+                size_t *e = &pilha[3 * topo++];
+                e[0] = filhos[2 * s + lado];
+                e[1] = prof + 1;
+                e[2] = lado ? 'd' : 'e';
+            }
+    }
+    free(filhos);
+    free(pilha);
+    free(rota);
+
+    printf("Montagem do mapa: %zu salas (árvore aleatória, altura %zu), lista de %.0f MB\n",
+           n, altura, (double)(lista.cap * sizeof(SalaListada) + lista.capTextos) / 1e6);
+    unsigned long long t0 = agora_ns();
+    Sala *serial = bench_montarSerial(&lista);
+    unsigned long long tSerial = agora_ns() - t0;
+    uint64_t resumo = bench_resumoMapa(serial);
+    t0 = agora_ns();
+    liberarSalas(serial);
+    malloc_trim(0);                    // os milhões de blocos pequenos só se juntam aqui (senão no próximo malloc grande)
+    unsigned long long tLiberaSerial = agora_ns() - t0;
+    printf("  sala a sala (criarSala):  montagem %9.1f ms   liberação (liberarSalas + malloc_trim) %9.1f ms\n",
+           (double)tSerial / 1e6, (double)tLiberaSerial / 1e6);
+    printf("  threads   partição  subárvores    ligação      total  acel.(1 thread)  acel.(sala a sala)  liberação (arenas)\n");
+
+    int erros = 0;
+    unsigned long long tUma = 0;
+    for (unsigned t = 1; ; t = t * 2 > maxThreads && t < maxThreads ? maxThreads : t * 2) {
+        ArenasMapa arenas;
+        MedidasMontagem med;
+        size_t falha;
+        const char *motivo;
+        t0 = agora_ns();
+        Sala *mapa = montarMapaParalelo(&lista, t, &arenas, &falha, &motivo, &med);
+        unsigned long long tTotal = agora_ns() - t0;
+        erros += !mapa || bench_resumoMapa(mapa) != resumo;
+        size_t reservado = 0;
+        for (unsigned i = 0; i < arenas.n; ++i) reservado += arenas.v[i].reservado;
+        t0 = agora_ns();
+        liberarArenasMapa(&arenas);
+        unsigned long long tLibera = agora_ns() - t0;
+        if (t == 1) tUma = tTotal;
+        printf("  %7u %8.1f ms %8.1f ms %8.1f ms %8.1f ms %14.2fx %18.2fx %12.2f ms (%.0f MB)\n",
+               t, (double)med.particao / 1e6, (double)med.grupos / 1e6, (double)med.ligacao / 1e6,
+               (double)tTotal / 1e6, (double)tUma / (double)tTotal, (double)tSerial / (double)tTotal,
+               (double)tLibera / 1e6, (double)reservado / 1e6);
+        if (t >= maxThreads) break;
+    }
+    long nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+    printf("  conferência: %s (%ld núcleos disponíveis)\n", erros ? "ERRO" : "ok", nucleos);
+    liberarListaSalas(&lista);
+    return erros ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+    (void)mostrarReproducao;           // usadas só pelo main do jogo
+    (void)exp_mostrarSugestoes;
+    (void)exp_imprimirPista;
+    if (argc > 1 && strcmp(argv[1], "--bench-layout") == 0)
+        return benchLayout(argc > 2 ? strtoul(argv[2], NULL, 10) : 1000000);
+    if (argc > 1 && strcmp(argv[1], "--bench-grafo") == 0)
+        return benchGrafo(argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 1000000,
+                          argc > 3 ? (uint32_t)strtoul(argv[3], NULL, 10) : 10);
+    if (argc > 1 && strcmp(argv[1], "--bench-eytzinger") == 0)
+        return benchEytzinger(argc > 2 ? strtoul(argv[2], NULL, 10) : 1000000);
+    if (argc > 1 && strcmp(argv[1], "--bench-suspeitos") == 0) // --bench-suspeitos [n]
+        return benchSuspeitos(argc > 2 ? strtoul(argv[2], NULL, 10) : 100000);
+    if (argc > 1 && strcmp(argv[1], "--bench-salas") == 0) // --bench-salas [n]
+        return benchSalas(argc > 2 ? strtoul(argv[2], NULL, 10) : 10000000);
+    if (argc > 1 && strcmp(argv[1], "--bench-sessoes") == 0)
+        return benchSessoes(argc > 2 ? strtoul(argv[2], NULL, 10) : 100000, argc > 3 ? strtoul(argv[3], NULL, 10) : 10000000);
+    if (argc > 2 && strcmp(argv[1], "--carga") == 0) // --carga <endereço> [sessões] [simultâneas]
+        return benchCarga(argv[2], argc > 3 ? strtoul(argv[3], NULL, 10) : 10000, argc > 4 ? strtoul(argv[4], NULL, 10) : 100);
+    if (argc > 1 && strcmp(argv[1], "--testar-servidor") == 0) // --testar-servidor [endereço]: servidor sem descritores
+        return testarServidor(argc > 2 ? argv[2] : "./dq_teste.sock");
+    if (argc > 1 && strcmp(argv[1], "--bench-fc") == 0)
+        return benchFrontCoding(argc > 2 ? strtoul(argv[2], NULL, 10) : 1000000);
+    if (argc > 1 && strcmp(argv[1], "--bench-hash") == 0) // --bench-hash [nMax] [arquivo-base]
+        return benchHash(argc > 2 ? strtoul(argv[2], NULL, 10) : 1000000, argc > 3 ? argv[3] : NULL);
+    if (argc > 1 && strcmp(argv[1], "--bench-filtro") == 0) // --bench-filtro [n]
+        return benchFiltro(argc > 2 ? strtoul(argv[2], NULL, 10) : 1000000);
+    if (argc > 1 && strcmp(argv[1], "--bench-diario") == 0)
+        return benchDiario("dq_bench.dqj", argc > 2 ? strtoul(argv[2], NULL, 10) : 100000);
+    if (argc > 1 && strcmp(argv[1], "--testar-diario") == 0) // diários corrompidos e índice deslocado
+        return testarDiario("dq_teste.dqj");
+    if (argc > 1 && strcmp(argv[1], "--testar-grafo") == 0) // números de porta no modo grafo (Hall com 15 portas)
+        return testarGrafo();
+    if (argc > 1 && strcmp(argv[1], "--bench-ramos") == 0)
+        return benchRamos(argc > 2 ? strtoul(argv[2], NULL, 10) : (1u << 18) - 1);
+    if (argc > 1 && strcmp(argv[1], "--bench-pool") == 0)
+        return benchPool(argc > 2 ? strtoul(argv[2], NULL, 10) : 10000);
+    if (argc > 1 && strcmp(argv[1], "--bench-bits") == 0)
+        return benchBits(argc > 2 ? strtoul(argv[2], NULL, 10) : 100000, argc > 3 ? strtoul(argv[3], NULL, 10) : 1000);
+    if (argc > 1 && strcmp(argv[1], "--bench-montagem") == 0) { // --bench-montagem [salas] [threads]
+        long nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+        return benchMontagem(argc > 2 ? strtoul(argv[2], NULL, 10) : 10000000,
+                             argc > 3 ? (unsigned)strtoul(argv[3], NULL, 10) : (nucleos > 8 ? (unsigned)nucleos : 8));
+    }
+
+    fprintf(stderr,
+            "Uso: %s --bench-layout|--bench-grafo|--bench-eytzinger|--bench-suspeitos|--bench-salas|\n"
+            "          --bench-sessoes|--bench-fc|--bench-hash|--bench-filtro|--bench-diario|\n"
+            "          --bench-ramos|--bench-pool|--bench-bits|--bench-montagem [parâmetros]\n"
+            "       %s --testar-diario | --testar-grafo | --testar-servidor [endereço]\n"
+            "       %s --carga <endereço> [sessões] [simultâneas]\n", argv[0], argv[0], argv[0]);
+    return 2;
+}
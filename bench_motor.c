@@ -0,0 +1,287 @@
+// TEMA 4 - MEDIÇÕES DO MOTOR
+
+/*
+ * Compara, lado a lado, as implementações de cada peça do motor (motor.h)
+ * sobre os mesmos dados:
+ *   mapa        construção, memória e passos de uma exploração aleatória;
+ *   pistas      inserção em ordem aleatória e em ordem alfabética (o pior
+ *               caso da BST), consulta e percurso em ordem;
+ *   associações inserção, busca de pista associada e de pista sem suspeito;
+ *   sessão      as 8 combinações de back-ends explorando o mesmo mapa.
+ *
+ * Compilação e uso:
+ *   gcc -std=gnu11 -O2 bench_motor.c motor.c -o bench_motor
+ *   ./bench_motor [salas] [pistas]     (padrão: 1000000 salas, 5000 pistas)
+ */
+
+#include <stdio.h>      // printf, fprintf, snprintf — relatório.
+#include <stdlib.h>     // malloc, free, strtoul, exit — alocação e argumentos.
+#include <string.h>     // strcmp — conferência da ordem das pistas.
+#include "motor.h"
+
+#define BENCH_PASSOS   2000000         // comandos por medição de exploração
+#define BENCH_CONSULTAS 1000000        // buscas por medição de associações
+
+static const MapaOps *const MAPAS[] = { &MAPA_ARVORE, &MAPA_PLANO };
+static const ColecaoOps *const COLECOES[] = { &COLECAO_BST, &COLECAO_AVL };
+static const AssociacoesOps *const ASSOCIACOES[] = { &ASSOC_ENCADEADA, &ASSOC_ABERTA };
+
+/* rng_proximo - gerador xorshift64* (rápido e reprodutível para medições) */
+static unsigned long long rng_proximo(unsigned long long *estado) {
+    unsigned long long x = *estado;
+    x ^= x >> 12; x ^= x << 25; x ^= x >> 27;
+    *estado = x;
+    return x * 2685821657736338717ull;
+}
+
+/* bench_sem_memoria - aborta a medição por falta de memória */
+static void bench_sem_memoria(void) {
+    fprintf(stderr, "Erro: memória insuficiente para a medição.\n");
+    exit(EXIT_FAILURE);
+}
+
+/* bench_pista - texto da pista i (todos maiores que a StrCurta, como as pistas do jogo) */
+static void bench_pista(size_t i, char *dst, size_t cap) {
+    snprintf(dst, cap, "Pista %07zu: marca de sapato", i);
+}
+
+/*
+ * bench_mapa - árvore aleatória de 'n' salas: cada sala nova desce da raiz
+ * por lados sorteados até achar um lugar livre. Uma sala em cada três tem
+ * pista; em 'pistas' fica a quantidade.
+ */
+static Sala *bench_mapa(size_t n, size_t *pistas) {
+    char nome[32], pista[48];
+    unsigned long long rng = 7;
+    Sala *raiz = criarSala("Hall de entrada", NULL);
+    *pistas = 0;
+    for (size_t i = 1; i < n; ++i) {
+        snprintf(nome, sizeof(nome), "Sala %zu", i);
+        int comPista = i % 3 == 0;
+        if (comPista) bench_pista((*pistas)++, pista, sizeof(pista));
+        Sala *s = criarSala(nome, comPista ? pista : NULL), *p = raiz;
+        while (1) {
+            Sala **lado = (rng_proximo(&rng) & 1) ? &p->dir : &p->esq;
+            if (!*lado) {
+                *lado = s;
+                s->pai = p;
+                break;
+            }
+            p = *lado;
+        }
+    }
+    return raiz;
+}
+
+/* bench_comando - comando sorteado para a exploração: desce mais do que volta */
+static char bench_comando(unsigned long long *rng) {
+    unsigned r = (unsigned)(rng_proximo(rng) >> 61); // 0..7
+    return r < 3 ? 'e' : r < 6 ? 'd' : 'v';
+}
+
+/* bench_explorar - 'passos' comandos sorteados (da raiz de novo quando chega numa folha) */
+static size_t bench_explorar(const Motor *m, size_t passos, unsigned long long semente, size_t *coletadas) {
+    SessaoMotor s;
+    EventoMotor ev[MOTOR_MAX_EVENTOS];
+    size_t eventos = motorIniciar(&s, m, ev), suspeitos = 0;
+    unsigned long long rng = semente;
+    for (size_t i = 0; i < passos; ++i) {
+        size_t nEv = motorPasso(&s, bench_comando(&rng), ev);
+        eventos += nEv;
+        for (size_t k = 0; k < nEv; ++k) suspeitos += ev[k].tipo == MOTOR_PISTA && ev[k].suspeito;
+        if (nEv && ev[0].tipo == MOTOR_SEM_PASSAGEM) { // parede: recomeça do Hall
+            motorEncerrar(&s);
+            eventos += motorIniciar(&s, m, ev);
+        }
+    }
+    *coletadas = s.pistas ? m->colecaoOps->tamanho(s.pistas) : 0;
+    motorEncerrar(&s);
+    return eventos * 31 + suspeitos;
+}
+
+/* ---------- Mapa ---------- */
+
+static int bench_mapas(const Sala *modelo, size_t n) {
+    int erros = 0;
+    size_t referencia = 0;
+    printf("Mapa: %zu salas (árvore aleatória), %d passos de exploração\n", n, BENCH_PASSOS);
+    printf("  %-10s %12s %10s %14s\n", "back-end", "construção", "B/sala", "ns/passo");
+    for (size_t b = 0; b < sizeof(MAPAS) / sizeof(MAPAS[0]); ++b) {
+        const MapaOps *o = MAPAS[b];
+        unsigned long long t0 = agora_ns();
+        void *mapa = o->criar(modelo);
+        unsigned long long tCriar = agora_ns() - t0;
+        Motor m = { o, mapa, NULL, NULL, NULL, NULL, NULL };
+        size_t nada;
+        t0 = agora_ns();
+        size_t soma = bench_explorar(&m, BENCH_PASSOS, 99, &nada);
+        unsigned long long tPassos = agora_ns() - t0;
+        if (b == 0) referencia = soma;
+        erros += soma != referencia;
+        printf("  %-10s %9.1f ms %10.1f %14.1f\n", o->nome, (double)tCriar / 1e6,
+               (double)o->bytes(mapa) / (double)n, (double)tPassos / BENCH_PASSOS);
+        o->liberar(mapa);
+    }
+    return erros;
+}
+
+/* ---------- Coleção de pistas ---------- */
+
+typedef struct Conferencia {
+    const char *anterior;             // último texto visitado
+    size_t n;
+    int fora;                         // 1 se a ordem alfabética foi violada
+} Conferencia;
+
+/* bench_conferir - visitante: conta e confere a ordem do percurso */
+static void bench_conferir(const char *texto, void *ctx) {
+    Conferencia *c = ctx;
+    if (c->anterior && strcmp(c->anterior, texto) >= 0) c->fora = 1;
+    c->anterior = texto;
+    c->n++;
+}
+
+static int bench_colecoes(size_t n) {
+    int erros = 0;
+    char (*textos)[48] = malloc(n * sizeof(*textos));
+    size_t *ordem = malloc(n * sizeof(size_t));
+    if (!textos || !ordem) bench_sem_memoria();
+    for (size_t i = 0; i < n; ++i) {
+        bench_pista(i, textos[i], sizeof(textos[i]));
+        ordem[i] = i;
+    }
+    unsigned long long rng = 3;
+    for (size_t i = n; i > 1; --i) {   // Fisher-Yates: ordem de coleta aleatória
+        size_t j = (size_t)(rng_proximo(&rng) % i), t = ordem[i - 1];
+        ordem[i - 1] = ordem[j];
+        ordem[j] = t;
+    }
+    printf("\nPistas coletadas: %zu textos (ns por operação)\n", n);
+    printf("  %-10s %-11s %10s %10s %10s %10s\n", "back-end", "ordem", "inserir", "repetida", "contem", "em ordem");
+    for (size_t b = 0; b < sizeof(COLECOES) / sizeof(COLECOES[0]); ++b) {
+        const ColecaoOps *o = COLECOES[b];
+        for (int alfabetica = 0; alfabetica < 2; ++alfabetica) {
+            void *c = o->criar();
+            size_t novas = 0, repetidas = 0, achadas = 0;
+            unsigned long long t0 = agora_ns();
+            for (size_t i = 0; i < n; ++i) novas += (size_t)o->inserir(c, textos[alfabetica ? i : ordem[i]]);
+            unsigned long long tInserir = agora_ns() - t0;
+            t0 = agora_ns();
+            for (size_t i = 0; i < n; ++i) repetidas += (size_t)!o->inserir(c, textos[ordem[i]]);
+            unsigned long long tRepetir = agora_ns() - t0;
+            t0 = agora_ns();
+            for (size_t i = 0; i < n; ++i) achadas += (size_t)o->contem(c, textos[ordem[i]]);
+            unsigned long long tContem = agora_ns() - t0;
+            Conferencia conf = { NULL, 0, 0 };
+            t0 = agora_ns();
+            o->emOrdem(c, bench_conferir, &conf);
+            unsigned long long tOrdem = agora_ns() - t0;
+            erros += novas != n || repetidas != n || achadas != n || conf.n != n || conf.fora || o->tamanho(c) != n;
+            printf("  %-10s %-11s %10.1f %10.1f %10.1f %10.1f\n", o->nome, alfabetica ? "alfabética" : "aleatória",
+                   (double)tInserir / (double)n, (double)tRepetir / (double)n,
+                   (double)tContem / (double)n, (double)tOrdem / (double)n);
+            o->liberar(c);
+        }
+    }
+    free(textos);
+    free(ordem);
+    return erros;
+}
+
+/* ---------- Associações ---------- */
+
+static int bench_associacoes(size_t pistas) {
+    int erros = 0;
+    size_t nAssoc = pistas / 4 ? pistas / 4 : 1; // uma pista em quatro aponta para alguém
+    char pista[48], suspeito[32];
+    unsigned long long rng = 5;
+    unsigned *sorteio = malloc(BENCH_CONSULTAS * sizeof(unsigned));
+    if (!sorteio) bench_sem_memoria();
+    for (size_t q = 0; q < BENCH_CONSULTAS; ++q) sorteio[q] = (unsigned)(rng_proximo(&rng) % nAssoc);
+    printf("\nAssociações: %zu pistas com suspeito, %d buscas (ns por operação)\n", nAssoc, BENCH_CONSULTAS);
+    printf("  %-10s %10s %10s %10s %10s\n", "back-end", "inserir", "acerto", "falha", "B/pista");
+    for (size_t b = 0; b < sizeof(ASSOCIACOES) / sizeof(ASSOCIACOES[0]); ++b) {
+        const AssociacoesOps *o = ASSOCIACOES[b];
+        void *a = o->criar(nAssoc);
+        unsigned long long t0 = agora_ns();
+        for (size_t i = 0; i < nAssoc; ++i) {
+            bench_pista(4 * i, pista, sizeof(pista));
+            snprintf(suspeito, sizeof(suspeito), "Suspeito %zu", i % 97);
+            o->inserir(a, pista, suspeito);
+        }
+        unsigned long long tInserir = agora_ns() - t0;
+        size_t acertos = 0, falsos = 0;
+        t0 = agora_ns();
+        for (size_t q = 0; q < BENCH_CONSULTAS; ++q) {
+            bench_pista(4 * (size_t)sorteio[q], pista, sizeof(pista));
+            acertos += o->buscar(a, pista) != NULL;
+        }
+        unsigned long long tAcerto = agora_ns() - t0;
+        t0 = agora_ns();
+        for (size_t q = 0; q < BENCH_CONSULTAS; ++q) {
+            bench_pista(4 * (size_t)sorteio[q] + 1, pista, sizeof(pista)); // pista sem suspeito
+            falsos += o->buscar(a, pista) != NULL;
+        }
+        unsigned long long tFalha = agora_ns() - t0;
+        erros += acertos != BENCH_CONSULTAS || falsos != 0;
+        printf("  %-10s %10.1f %10.1f %10.1f %10.1f\n", o->nome, (double)tInserir / (double)nAssoc,
+               (double)tAcerto / BENCH_CONSULTAS, (double)tFalha / BENCH_CONSULTAS,
+               (double)o->bytes(a) / (double)nAssoc);
+        o->liberar(a);
+    }
+    free(sorteio);
+    return erros;
+}
+
+/* ---------- Sessão completa ---------- */
+
+static int bench_sessoes(const Sala *modelo, size_t pistas) {
+    int erros = 0;
+    size_t referencia = 0, refColetadas = 0;
+    char pista[48], suspeito[32];
+    printf("\nSessão completa: %d passos com coleta e consulta de suspeitos (ns por passo)\n", BENCH_PASSOS);
+    printf("  %-10s %-10s %-10s %10s %10s\n", "mapa", "pistas", "assoc", "ns/passo", "coletadas");
+    for (size_t a = 0; a < sizeof(ASSOCIACOES) / sizeof(ASSOCIACOES[0]); ++a) {
+        const AssociacoesOps *ao = ASSOCIACOES[a];
+        void *assoc = ao->criar(pistas / 4 + 1);
+        for (size_t i = 0; i < pistas; i += 4) {
+            bench_pista(i, pista, sizeof(pista));
+            snprintf(suspeito, sizeof(suspeito), "Suspeito %zu", i % 97);
+            ao->inserir(assoc, pista, suspeito);
+        }
+        for (size_t b = 0; b < sizeof(MAPAS) / sizeof(MAPAS[0]); ++b) {
+            void *mapa = MAPAS[b]->criar(modelo);
+            for (size_t c = 0; c < sizeof(COLECOES) / sizeof(COLECOES[0]); ++c) {
+                Motor m = { MAPAS[b], mapa, COLECOES[c], ao, assoc, NULL, NULL };
+                size_t coletadas;
+                unsigned long long t0 = agora_ns();
+                size_t soma = bench_explorar(&m, BENCH_PASSOS, 11, &coletadas);
+                unsigned long long t = agora_ns() - t0;
+                if (a == 0 && b == 0 && c == 0) { referencia = soma; refColetadas = coletadas; }
+                erros += soma != referencia || coletadas != refColetadas;
+                printf("  %-10s %-10s %-10s %10.1f %10zu\n", MAPAS[b]->nome, COLECOES[c]->nome, ao->nome,
+                       (double)t / BENCH_PASSOS, coletadas);
+            }
+            MAPAS[b]->liberar(mapa);
+        }
+        ao->liberar(assoc);
+    }
+    return erros;
+}
+
+int main(int argc, char *argv[]) {
+    size_t nSalas = argc > 1 ? (size_t)strtoul(argv[1], NULL, 10) : 1000000;
+    size_t nPistas = argc > 2 ? (size_t)strtoul(argv[2], NULL, 10) : 5000;
+    if (nSalas < 1) nSalas = 1;
+    if (nPistas < 1) nPistas = 1;
+    size_t pistasMapa;
+    Sala *modelo = bench_mapa(nSalas, &pistasMapa);
+    int erros = bench_mapas(modelo, nSalas);
+    erros += bench_colecoes(nPistas);
+    erros += bench_associacoes(pistasMapa);
+    erros += bench_sessoes(modelo, pistasMapa);
+    printf("\nConferência entre back-ends: %s\n", erros ? "ERRO" : "ok");
+    MAPA_ARVORE.liberar(modelo);      // sem recursão: a árvore aleatória pode ser funda
+    liberarPool();
+    return erros ? 1 : 0;
+}
@@ -0,0 +1,1484 @@
+// TEMA 4 - MOTOR (implementação; interface e instruções de compilação em motor.h)
+
+#include <stdio.h>      // printf, fprintf — mensagens e erros.
+#include <stdlib.h>     // malloc, calloc, realloc, free, exit — alocação e encerramento.
+#include <string.h>     // strlen, memcpy, memmove, strcmp — manipulação de strings.
+#include <ctype.h>      // isspace, tolower — comandos da exploração.
+#include <unistd.h>     // read — entrada em blocos.
+#include <errno.h>      // errno, EINTR — leitura de stdin interrompida por sinal.
+#include "motor.h"
+
+/* ---------- Instrumentação opcional (compilar com -DDQ_ESTATISTICAS) ---------- */
+
+#ifdef DQ_ESTATISTICAS
+Estatisticas g_est;             // contadores zerados na inicialização do programa
+
+/* est_registrar - soma uma amostra 'v' ao histograma 'h' */
+void est_registrar(Histograma *h, unsigned long long v) {
+    int f = v ? 64 - __builtin_clzll(v) : 0; // índice da faixa = número de bits significativos
+    if (f >= EST_FAIXAS) f = EST_FAIXAS - 1; // valores enormes caem na última faixa
+    est_somar(&h->faixas[f], 1);
+    est_somar(&h->amostras, 1);
+    est_somar(&h->soma, v);
+    unsigned long long max = __atomic_load_n(&h->maximo, __ATOMIC_RELAXED);
+    while (v > max && !__atomic_compare_exchange_n(&h->maximo, &max, v, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }                                  // outra thread subiu o máximo: 'max' foi recarregado, tenta de novo
+}
+#endif
+
+/* ---------- Funções utilitárias ---------- */
+
+/* duplicar string (substitui strdup para portabilidade) */
+char *str_dup(const char *s) {          // duplica uma string
+    if (!s) return NULL;               // se o argumento for NULL, retorna NULL (proteção)
+    size_t n = strlen(s) + 1;          // tamanho necessário incluindo caractere nulo '\0'
+    char *r = malloc(n);               // aloca memória para a cópia
+    EST_ALOC(Str, n);                  // instrumentação: conta alocação de string
+    if (!r) {                          // se malloc falhar...
+        fprintf(stderr, "Erro: memória insuficiente ao duplicar string.\n"); // informa erro
+        exit(EXIT_FAILURE);            // encerra o programa com código de erro
+    }
+    memcpy(r, s, n);                   // copia os bytes (incluindo '\0') para a nova área
+    return r;                          // retorna o ponteiro para a string duplicada
+}
+
+/* ---------- Entrada em blocos (stdin lido em blocos, comandos enfileirados) ---------- */
+
+/*
+ * Toda a leitura de stdin passa por aqui: os bytes chegam com read() em
+ * blocos de até ENTRADA_BLOCO, e lerLinha/get_choice consomem do buffer.
+ * Uma linha de comandos como "eedv" ou "e d d s" vira uma fila de
+ * movimentos, que a exploração drena sem voltar a ler a entrada. A linha
+ * crua fica guardada junto, com a posição de cada comando nela, para um
+ * comando com argumento ("t Torre de vigia") recuperar o texto que o segue.
+ */
+#define ENTRADA_BLOCO 65536            // bytes pedidos a cada read()
+#define ENTRADA_FILA  4096             // comandos pendentes de uma mesma linha
+
+typedef struct Entrada {
+    char buf[ENTRADA_BLOCO];           // bytes lidos e ainda não consumidos: buf[ini..fim)
+    size_t ini, fim;
+    int eof;                           // 1 depois que read() indicou fim ou erro
+    char fila[ENTRADA_FILA];           // comandos da última linha lida por get_choice
+    size_t filaIni, filaFim;
+    char linha[ENTRADA_FILA];          // a mesma linha como foi digitada (sem o '\n')
+    uint16_t posFila[ENTRADA_FILA];    // posição em 'linha' de cada comando da fila
+    size_t nLinha;
+} Entrada;
+
+static Entrada g_entrada;              // estado único da entrada padrão
+
+/* entrada_encher - lê mais um bloco de stdin; retorna 0 se não houver mais nada */
+static int entrada_encher(void) {
+    Entrada *e = &g_entrada;
+    if (e->eof) return 0;
+    fflush(stdout);                    // o prompt precisa aparecer antes de bloquear
+    if (e->ini > 0) {                  // compacta o que sobrou para o início do buffer
+        memmove(e->buf, e->buf + e->ini, e->fim - e->ini);
+        e->fim -= e->ini;
+        e->ini = 0;
+    }
+    if (e->fim == sizeof(e->buf)) return 1; // buffer cheio: o chamador consome antes
+    ssize_t n;
+    do {
+        n = read(STDIN_FILENO, e->buf + e->fim, sizeof(e->buf) - e->fim);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) {
+        e->eof = 1;
+        return 0;
+    }
+    e->fim += (size_t)n;
+    return 1;
+}
+
+/* lerLinha - equivalente a fgets(dst, cap, stdin) sobre o buffer da entrada; NULL no fim */
+char *lerLinha(char *dst, size_t cap) {
+    Entrada *e = &g_entrada;
+    size_t n = 0;
+    if (cap == 0) return NULL;
+    while (n + 1 < cap) {
+        if (e->ini == e->fim && !entrada_encher()) break;
+        char c = e->buf[e->ini++];
+        dst[n++] = c;
+        if (c == '\n') break;          // linha completa (com o '\n', como o fgets)
+    }
+    dst[n] = '\0';
+    return n ? dst : NULL;
+}
+
+/* entradaTemComandos - há comandos de uma linha anterior ainda na fila? */
+int entradaTemComandos(void) {
+    return g_entrada.filaIni < g_entrada.filaFim;
+}
+
+/* entradaDescartarComandos - descarta os comandos restantes (ex.: após 's') */
+void entradaDescartarComandos(void) {
+    g_entrada.filaIni = g_entrada.filaFim = 0;
+}
+
+/*
+ * entradaRestoDaLinha - texto da linha depois do último comando entregue por
+ * get_choice, como foi digitado (espaços inclusive); os comandos que sobravam
+ * na fila passam a ser esse texto e são descartados. "" se nada o segue.
+ */
+const char *entradaRestoDaLinha(void) {
+    Entrada *e = &g_entrada;
+    size_t ini = e->filaIni > 0 && e->filaIni <= e->filaFim ? e->posFila[e->filaIni - 1] + 1u : e->nLinha;
+    e->filaIni = e->filaFim = 0;
+    e->linha[e->nLinha] = '\0';
+    return e->linha + ini;
+}
+
+/*
+ * get_choice - próximo comando da exploração. Com a fila vazia, lê uma linha
+ * e enfileira cada caractere não branco dela; retorna '\0' se a entrada
+ * acabou ou se a linha só tinha espaços.
+ */
+char get_choice(void) {
+    Entrada *e = &g_entrada;
+    if (e->filaIni == e->filaFim) {   // fila vazia: tokeniza a próxima linha
+        e->filaIni = e->filaFim = e->nLinha = 0;
+        int lido = 0;                  // algum byte desta linha foi lido?
+        while (1) {
+            if (e->ini == e->fim && !entrada_encher()) break;
+            char c = e->buf[e->ini++];
+            lido = 1;
+            if (c == '\n') break;
+            if (e->nLinha + 1 >= ENTRADA_FILA) continue; // linha longa demais: o resto é ignorado
+            if (!isspace((unsigned char)c)) {
+                e->posFila[e->filaFim] = (uint16_t)e->nLinha;
+                e->fila[e->filaFim++] = c;
+            }
+            e->linha[e->nLinha++] = c;
+        }
+        if (!lido || e->filaFim == 0) return '\0'; // fim da entrada ou linha em branco
+    }
+    return e->fila[e->filaIni++];
+}
+
+/* strc_definir - guarda 't' em 's': inline se couber, senão copia para o heap; NULL vira STRC_NULO */
+static void strc_definir(StrCurta *s, const char *t) {
+    if (!t) {                          // sem texto: marca como nulo
+        s->interno[0] = '\0';
+        s->interno[STRC_INTERNO] = STRC_NULO;
+        return;
+    }
+    size_t n = strlen(t);              // comprimento sem o '\0'
+    if (n <= STRC_INTERNO) {           // cabe no nó: copia com terminador
+        memcpy(s->interno, t, n + 1);
+        s->interno[STRC_INTERNO] = '\0'; // marcador "interno" (ou o próprio terminador)
+    } else {                           // texto longo: vai para o heap
+        s->heap = str_dup(t);
+        s->interno[STRC_INTERNO] = STRC_HEAP;
+    }
+}
+
+/* strc_liberar - libera o texto se ele estiver no heap */
+static void strc_liberar(StrCurta *s) {
+    if (s->interno[STRC_INTERNO] == STRC_HEAP) free(s->heap);
+    s->interno[0] = '\0';
+    s->interno[STRC_INTERNO] = STRC_NULO;
+}
+
+/* ---------- Funções para salas (mapa) ---------- */
+
+/*
+ * criarSala - cria, de forma dinâmica, uma sala com o nome informado e pista opcional.
+ * Parâmetros:
+ *   nome  - nome da sala (string)
+ *   pista - pista associada à sala (string) ou NULL para sem pista
+ * Retorno: ponteiro para Sala criada (filhos e pai inicializados em NULL)
+ */
+Sala *criarSala(const char *nome, const char *pista) { // cria uma Sala e inicializa campos
+    Sala *s = malloc(sizeof(Sala));    // aloca memória para a estrutura Sala
+    EST_ALOC(Sala, sizeof(Sala));      // instrumentação: conta alocação de sala
+    if (!s) {                          // verifica se alocação ocorreu com sucesso
+        fprintf(stderr, "Erro: memória insuficiente ao criar sala.\n"); // mensagem de erro
+        exit(EXIT_FAILURE);            // encerra o programa se falhar alocação
+    }
+    strc_definir(&s->nome, nome);      // guarda o nome da sala (inline se curto)
+    strc_definir(&s->pista, pista);    // guarda a pista, ou STRC_NULO se não houver
+    s->pistaId = -1;                   // ID definido depois, ao criar o catálogo
+    s->id = -1;                        // idem
+    s->esq = NULL;                     // inicializa filho esquerdo como NULL
+    s->dir = NULL;                     // inicializa filho direito como NULL
+    s->pai = NULL;                     // inicializa ponteiro para pai como NULL
+    return s;                          // retorna o ponteiro para a sala criada
+}
+
+/*
+ * conectarFilhos - conecta filhos a um nó pai e ajusta ponteiros 'pai' dos filhos.
+ */
+void conectarFilhos(Sala *pai, Sala *esq, Sala *dir) { // conecta esq/dir a pai e ajusta 'pai' dos filhos
+    if (!pai) return;                // proteção: se pai for NULL, não faz nada
+    pai->esq = esq;                  // atribui filho esquerdo
+    pai->dir = dir;                  // atribui filho direito
+    if (esq) esq->pai = pai;         // se filho esquerdo existe, define seu ponteiro para o pai
+    if (dir) dir->pai = pai;         // se filho direito existe, define seu ponteiro para o pai
+}
+
+/*
+ * formatarCaminho - escreve em 'dst' o caminho do Hall até 's' pelos
+ * ponteiros 'pai' ("Hall de entrada > Biblioteca > ..."). Em mapas fundos só
+ * os últimos CAMINHO_MAX trechos aparecem, depois de "... > ".
+ */
+#define CAMINHO_MAX 16
+char *formatarCaminho(const Sala *s, char *dst, size_t cap) {
+    const Sala *trecho[CAMINHO_MAX];
+    size_t n = 0, pos = 0;
+    for (; s && n < CAMINHO_MAX; s = s->pai) trecho[n++] = s;
+    if (cap == 0) return dst;
+    dst[0] = '\0';
+    if (s) pos += (size_t)snprintf(dst, cap, "... > "); // ainda há ancestrais: caminho cortado
+    while (n-- > 0 && pos < cap)
+        pos += (size_t)snprintf(dst + pos, cap - pos, "%s%s", salaNome(trecho[n]), n ? " > " : "");
+    return dst;
+}
+
+/*
+ * liberarSalas - libera recursivamente a memória da árvore de salas,
+ * incluindo strings de nome e pista.
+ */
+void liberarSalas(Sala *raiz) {      // libera recursivamente todas as salas da árvore
+    if (!raiz) return;               // caso base: nó NULL -> nada a fazer
+    liberarSalas(raiz->esq);         // libera subárvore esquerda
+    liberarSalas(raiz->dir);         // libera subárvore direita
+    strc_liberar(&raiz->nome);       // libera nome, se estiver no heap
+    strc_liberar(&raiz->pista);      // libera pista, se estiver no heap
+    free(raiz);                      // libera a estrutura Sala em si
+}
+
+/* ---------- Arena de salas (montagem em massa, liberação em bloco) ---------- */
+
+#define ARENA_BLOCO_MIN ((size_t)64 << 10) // primeiro bloco; os seguintes dobram...
+#define ARENA_BLOCO_MAX ((size_t)4 << 20)  // ...até este tamanho
+
+/* arena_reservar - 'n' bytes alinhados a 8 no bloco atual (ou num bloco novo) */
+static void *arena_reservar(ArenaSalas *a, size_t n) {
+    n = (n + 7) & ~(size_t)7;
+    BlocoArena *b = a->blocos;
+    if (!b || b->cap - b->usado < n) {
+        size_t cap = b ? 2 * b->cap : ARENA_BLOCO_MIN;
+        if (cap > ARENA_BLOCO_MAX) cap = ARENA_BLOCO_MAX;
+        if (cap < n) cap = n;
+        BlocoArena *novo = malloc(sizeof(BlocoArena) + cap);
+        if (!novo) {
+            fprintf(stderr, "Erro: memória insuficiente ao ampliar a arena de salas.\n");
+            exit(EXIT_FAILURE);
+        }
+        novo->prox = b;
+        novo->usado = 0;
+        novo->cap = cap;
+        a->blocos = b = novo;
+        a->reservado += sizeof(BlocoArena) + cap;
+    }
+    void *p = (char *)(b + 1) + b->usado;
+    b->usado += n;
+    return p;
+}
+
+/* arena_texto - como strc_definir, mas o texto longo fica na arena */
+static void arena_texto(ArenaSalas *a, StrCurta *s, const char *t) {
+    size_t n = t ? strlen(t) : 0;
+    if (!t || n <= STRC_INTERNO) {
+        strc_definir(s, t);
+        return;
+    }
+    s->heap = arena_reservar(a, n + 1);
+    memcpy(s->heap, t, n + 1);
+    s->interno[STRC_INTERNO] = STRC_HEAP;
+}
+
+/* arenaCriarSala - criarSala com a sala e os textos longos na arena 'a' */
+Sala *arenaCriarSala(ArenaSalas *a, const char *nome, const char *pista) {
+    Sala *s = arena_reservar(a, sizeof(Sala));
+    arena_texto(a, &s->nome, nome);
+    arena_texto(a, &s->pista, pista);
+    s->pistaId = -1;
+    s->id = -1;
+    s->esq = s->dir = s->pai = NULL;
+    return s;
+}
+
+/* liberarArena - devolve todos os blocos (e com eles todas as salas da arena) */
+void liberarArena(ArenaSalas *a) {
+    for (BlocoArena *b = a->blocos; b; ) {
+        BlocoArena *prox = b->prox;
+        free(b);
+        b = prox;
+    }
+    a->blocos = NULL;
+    a->reservado = 0;
+}
+
+/* ---------- Pool de nós de pista (reaproveitados entre explorações) ---------- */
+
+/*
+ * As BSTs de pistas são criadas e destruídas a cada exploração. Em vez de
+ * devolver tudo ao malloc, liberarPistas devolve nós e textos ao pool, e a
+ * exploração seguinte os reaproveita: depois da primeira rodada o jogo não
+ * chama mais o alocador. Os nós vêm de slabs de POOL_NOS_POR_SLAB unidades;
+ * textos longos (os que não cabem na StrCurta) vêm de listas livres por
+ * classe de tamanho (32, 64, 128 e 256 bytes). Textos maiores usam malloc.
+ */
+#define POOL_NOS_POR_SLAB 128          // nós criados de uma vez quando a lista livre esvazia
+#define POOL_SLAB_TEXTO   4096         // bytes por slab de textos
+
+PoolPistas g_pool;                     // pool global usado por criarNoPista/liberarPistas
+
+/* pool_novoSlab - obtém do malloc um slab com 'bytes' úteis e o registra */
+static void *pool_novoSlab(size_t bytes) {
+    Slab *sl = malloc(sizeof(Slab) + bytes);
+    if (!sl) {
+        fprintf(stderr, "Erro: memória insuficiente ao ampliar o pool de pistas.\n");
+        exit(EXIT_FAILURE);
+    }
+    EST_ALOC(NoPista, sizeof(Slab) + bytes); // instrumentação: o pool é quem aloca agora
+    sl->prox = g_pool.slabs;
+    g_pool.slabs = sl;
+    g_pool.chamadasMalloc++;
+    g_pool.bytesReservados += sizeof(Slab) + bytes;
+    return sl + 1;                     // área útil logo após o cabeçalho
+}
+
+/* pool_obterNo - retira um NoPista da lista livre (cria um slab novo se ela estiver vazia) */
+static NoPista *pool_obterNo(void) {
+    g_pool.pedidosNo++;
+    if (g_pool.nosLivres) {
+        g_pool.acertosNo++;
+    } else {                           // lista vazia: fatia um slab novo em nós livres
+        NoPista *v = pool_novoSlab(POOL_NOS_POR_SLAB * sizeof(NoPista));
+        for (size_t i = 0; i < POOL_NOS_POR_SLAB; ++i) {
+            v[i].esq = g_pool.nosLivres;
+            g_pool.nosLivres = &v[i];
+        }
+    }
+    NoPista *n = g_pool.nosLivres;
+    g_pool.nosLivres = n->esq;
+    return n;
+}
+
+/* pool_classe - classe de tamanho para 'n' bytes, ou -1 se for grande demais para o pool */
+static int pool_classe(size_t n) {
+    for (int c = 0; c < POOL_CLASSES; ++c)
+        if (n <= ((size_t)32 << c)) return c;
+    return -1;
+}
+
+/* pool_obterTexto - bloco de pelo menos 'n' bytes para um texto longo */
+static char *pool_obterTexto(size_t n) {
+    g_pool.pedidosTexto++;
+    int c = pool_classe(n);
+    if (c < 0) {                       // acima de 256 bytes: malloc direto
+        g_pool.chamadasMalloc++;
+        char *r = malloc(n);
+        if (!r) { fprintf(stderr, "Erro: memória insuficiente ao duplicar string.\n"); exit(EXIT_FAILURE); }
+        return r;
+    }
+    size_t tam = (size_t)32 << c;
+    if (g_pool.textosLivres[c]) {
+        g_pool.acertosTexto++;
+    } else {                           // fatia um slab de textos da classe
+        char *v = pool_novoSlab(POOL_SLAB_TEXTO);
+        for (size_t off = 0; off + tam <= POOL_SLAB_TEXTO; off += tam) {
+            *(void **)(v + off) = g_pool.textosLivres[c];
+            g_pool.textosLivres[c] = v + off;
+        }
+    }
+    char *r = g_pool.textosLivres[c];
+    g_pool.textosLivres[c] = *(void **)r;
+    return r;
+}
+
+/* pool_devolverTexto - devolve ao pool o texto longo de uma StrCurta (se houver) */
+static void pool_devolverTexto(StrCurta *s) {
+    if (s->interno[STRC_INTERNO] != STRC_HEAP) return; // inline ou nulo: nada a devolver
+    char *t = s->heap;
+    int c = pool_classe(strlen(t) + 1);
+    if (c < 0) {
+        free(t);
+    } else {
+        *(void **)t = g_pool.textosLivres[c];
+        g_pool.textosLivres[c] = t;
+    }
+    s->interno[0] = '\0';
+    s->interno[STRC_INTERNO] = STRC_NULO;
+}
+
+/* liberarPool - devolve ao sistema todos os slabs (ao encerrar o programa) */
+void liberarPool(void) {
+    for (Slab *sl = g_pool.slabs; sl; ) {
+        Slab *prox = sl->prox;
+        free(sl);
+        sl = prox;
+    }
+    memset(&g_pool, 0, sizeof(g_pool));
+}
+
+/* mostrarPool - imprime taxa de acerto e memória reservada pelo pool */
+void mostrarPool(void) {
+    printf("Pool de pistas: nós %llu/%llu reaproveitados (%.1f%%), textos %llu/%llu (%.1f%%), "
+           "%llu chamadas ao malloc, %zu bytes reservados\n",
+           g_pool.acertosNo, g_pool.pedidosNo,
+           g_pool.pedidosNo ? 100.0 * (double)g_pool.acertosNo / (double)g_pool.pedidosNo : 0.0,
+           g_pool.acertosTexto, g_pool.pedidosTexto,
+           g_pool.pedidosTexto ? 100.0 * (double)g_pool.acertosTexto / (double)g_pool.pedidosTexto : 0.0,
+           g_pool.chamadasMalloc, g_pool.bytesReservados);
+}
+
+/* ---------- Funções para a árvore de pistas (BST) ---------- */
+
+/*
+ * criarNoPista - cria um nó de BST para armazenar uma pista (texto).
+ * Nó e texto longo vêm do pool de pistas (ver PoolPistas).
+ */
+NoPista *criarNoPista(const char *texto) { // cria e inicializa um NoPista com a string fornecida
+    if (!texto) return NULL;          // proteção: não cria se texto for NULL
+    NoPista *n = pool_obterNo();      // nó reaproveitado do pool (ou de um slab novo)
+    size_t len = strlen(texto) + 1;   // tamanho do texto incluindo '\0'
+    if (len <= STRC_INTERNO + 1) {    // cabe no nó: StrCurta inline
+        strc_definir(&n->texto, texto);
+    } else {                          // texto longo: bloco do pool
+        n->texto.heap = pool_obterTexto(len);
+        memcpy(n->texto.heap, texto, len);
+        n->texto.interno[STRC_INTERNO] = STRC_HEAP;
+    }
+    n->esq = NULL;                    // inicializa filho esquerdo
+    n->dir = NULL;                    // inicializa filho direito
+    return n;                         // retorna o nó criado
+}
+
+/* inserirPistaRec - inserção recursiva que acompanha a profundidade atual (para estatísticas) */
+static NoPista *inserirPistaRec(NoPista *raiz, const char *texto, int prof) {
+    if (!raiz) {                      // posição vazia encontrada: cria o nó aqui
+        EST_HIST(profundidadeBST, prof); // instrumentação: profundidade do novo nó
+        return criarNoPista(texto);
+    }
+    int cmp = strcmp(texto, strc_texto(&raiz->texto)); // compara alfabeticamente com nó atual
+    if (cmp == 0) {                    // se igual -> já existe, não insere duplicata
+        EST_HIST(profundidadeBST, prof); // instrumentação: profundidade da duplicata
+        return raiz;
+    } else if (cmp < 0) {              // se texto < raiz->texto -> vai para subárvore esquerda
+        raiz->esq = inserirPistaRec(raiz->esq, texto, prof + 1);
+    } else {                           // se texto > raiz->texto -> vai para subárvore direita
+        raiz->dir = inserirPistaRec(raiz->dir, texto, prof + 1);
+    }
+    (void)prof;                        // sem instrumentação o parâmetro não é lido
+    return raiz;                       // retorna a raiz (inalterada na maioria dos casos)
+}
+
+/*
+ * inserirPista - insere uma pista na BST em ordem alfabética.
+ * Se a pista já existir (strcmp == 0), não insere duplicata.
+ * Retorna a raiz (possivelmente alterada) da BST.
+ */
+NoPista *inserirPista(NoPista *raiz, const char *texto) { // insere texto na BST mantendo ordem
+    if (!texto) return raiz;          // se texto inválido, retorna raiz sem alteração
+    return inserirPistaRec(raiz, texto, 0); // desce a partir da raiz (profundidade 0)
+}
+
+/* buscarPista - nó com o texto exato na BST, ou NULL */
+NoPista *buscarPista(NoPista *raiz, const char *texto) {
+    while (raiz) {
+        int cmp = strcmp(texto, strc_texto(&raiz->texto));
+        if (cmp == 0) return raiz;
+        raiz = cmp < 0 ? raiz->esq : raiz->dir;
+    }
+    return NULL;
+}
+
+/*
+ * exibirPistas - imprime as pistas em ordem alfabética (percorrendo BST em-order).
+ */
+void exibirPistas(NoPista *raiz) {    // percorre a BST em ordem e imprime cada pista
+    if (!raiz) return;                // caso base: nó NULL -> retorna
+    exibirPistas(raiz->esq);          // visita recursivamente a subárvore esquerda (menores)
+    printf(" - %s\n", strc_texto(&raiz->texto)); // imprime o texto da pista do nó atual
+    exibirPistas(raiz->dir);          // visita recursivamente a subárvore direita (maiores)
+}
+
+/*
+ * liberarPistas - libera recursivamente a BST de pistas e suas strings,
+ * devolvendo nós e textos ao pool para a próxima exploração.
+ */
+void liberarPistas(NoPista *raiz) {   // libera toda a BST de pistas
+    if (!raiz) return;                // caso base: nó NULL -> nada a fazer
+    liberarPistas(raiz->esq);         // libera subárvore esquerda
+    liberarPistas(raiz->dir);         // libera subárvore direita
+    pool_devolverTexto(&raiz->texto); // devolve o texto longo ao pool, se houver
+    raiz->esq = g_pool.nosLivres;     // devolve o nó à lista livre do pool
+    g_pool.nosLivres = raiz;
+}
+
+/* ---------- Tabela hash (pista -> suspeito) ---------- */
+
+/*
+ * Filtro de Bloom em blocos na frente da tabela. Em mapas grandes a maioria
+ * das pistas não aponta para suspeito nenhum, e sem o filtro cada uma dessas
+ * buscas percorre uma cadeia inteira (com strcmp em cada nó) só para
+ * devolver NULL. O filtro dá HASH_FILTRO_BITS bits por bucket (a tabela é
+ * criada com tantos buckets quantas chaves se esperam) em blocos de 256 bits:
+ * a chave escolhe um bloco e liga um bit em cada uma das 8 palavras dele,
+ * então a consulta lê uma única meia linha de cache. Com 12 bits por chave a
+ * taxa de falsos positivos fica perto de 0,5%. O filtro usa um hash próprio,
+ * independente de hash_simple, para que chaves que colidem num bucket não
+ * colidam também no filtro. Chaves não saem da tabela, então o filtro nunca
+ * precisa desligar bits.
+ */
+#define HASH_FILTRO_BITS 12           // bits do filtro por bucket da tabela
+
+/* filtro_marcar - registra no filtro a chave de hash 'h' */
+static void filtro_marcar(HashTable *ht, uint64_t h) {
+    BlocoFiltro *b = filtro_bloco(ht, h);
+    for (int i = 0; i < 8; ++i) b->palavras[i] |= 1u << (((uint32_t)h * FILTRO_SAL[i]) >> 27);
+}
+
+/* criarHashTable - cria uma tabela hash com 'tamanho' buckets */
+HashTable *criarHashTable(size_t tamanho) { // cria e inicializa a estrutura HashTable
+    HashTable *ht = malloc(sizeof(HashTable)); // aloca estrutura da tabela
+    if (!ht) {                          // checa alocação
+        fprintf(stderr, "Erro: memória insuficiente ao criar hash table.\n");
+        exit(EXIT_FAILURE);
+    }
+    ht->tamanho = tamanho;              // armazena o número de buckets
+    ht->buckets = calloc(tamanho, sizeof(HashNode*)); // cria vetor de ponteiros (inicializados NULL)
+    if (!ht->buckets) {                 // checa alocação do vetor
+        fprintf(stderr, "Erro: memória insuficiente ao criar buckets.\n");
+        exit(EXIT_FAILURE);
+    }
+    ht->nBlocosFiltro = (tamanho * HASH_FILTRO_BITS + 255) / 256; // blocos de 256 bits
+    if (!ht->nBlocosFiltro) ht->nBlocosFiltro = 1;
+    ht->filtro = aligned_alloc(sizeof(BlocoFiltro), ht->nBlocosFiltro * sizeof(BlocoFiltro)); // bloco nunca cruza linha de cache
+    if (!ht->filtro) {
+        fprintf(stderr, "Erro: memória insuficiente ao criar filtro da hash.\n");
+        exit(EXIT_FAILURE);
+    }
+    memset(ht->filtro, 0, ht->nBlocosFiltro * sizeof(BlocoFiltro));
+    EST_ALOC(Filtro, ht->nBlocosFiltro * sizeof(BlocoFiltro));
+    return ht;                          // retorna a tabela inicializada
+}
+
+/* hash_simple - função hash simples que usa soma de bytes e módulo (suficiente para demo) */
+size_t hash_simple(const char *s, size_t mod) { // calcula índice do bucket para a chave s
+    size_t h = 0;                       // inicializa acumulador
+    for (size_t i = 0; s[i] != '\0'; ++i) h = h * 31 + (unsigned char)s[i]; // multiplicativa simples
+    return h % mod;                     // reduz ao intervalo de buckets
+}
+
+/*
+ * inserirNaHash - insere associação (pista -> suspeito) na tabela hash.
+ * Se a chave já existir, atualiza o suspeito.
+ */
+void inserirNaHash(HashTable *ht, const char *pista, const char *suspeito) {
+    if (!ht || !pista || !suspeito) return; // proteção contra parâmetros inválidos
+    size_t idx = hash_simple(pista, ht->tamanho); // calcula bucket
+    HashNode *node = ht->buckets[idx];    // ponteiro para início da lista do bucket
+
+    // procurar chave existente: se achar, atualizar valor e retornar
+    for (HashNode *cur = node; cur != NULL; cur = cur->prox) {
+        if (strcmp(cur->chave, pista) == 0) { // chave já presente
+            free(cur->suspeito);           // liberar suspeito antigo
+            cur->suspeito = str_dup(suspeito); // atualizar suspeito associado
+            return;                         // fim
+        }
+    }
+
+    // se não existe, criar novo HashNode e inserir no início da lista
+    HashNode *novo = malloc(sizeof(HashNode)); // alocar novo nó
+    if (!novo) {                            // checar alocação
+        fprintf(stderr, "Erro: memória insuficiente ao criar HashNode.\n");
+        exit(EXIT_FAILURE);
+    }
+    novo->chave = str_dup(pista);           // duplicar chave
+    novo->suspeito = str_dup(suspeito);     // duplicar valor
+    novo->prox = ht->buckets[idx];          // inserir no início da lista
+    ht->buckets[idx] = novo;                // atualizar cabeça do bucket
+    if (ht->filtro) filtro_marcar(ht, hash_filtro(pista, strlen(pista))); // mantém o filtro em dia
+}
+
+/*
+ * hash_procurar - busca sem instrumentação. '*sondagens' recebe os nós da
+ * cadeia visitados, ou -1 se o filtro de Bloom respondeu sozinho.
+ * Pistas ausentes quase sempre param no filtro, sem tocar nos buckets.
+ */
+static const char *hash_procurar(HashTable *ht, const char *pista, int *sondagens) {
+    uint64_t hf = ht->filtro ? hash_filtro(pista, strlen(pista)) : 0;
+    if (ht->filtro) __builtin_prefetch(filtro_bloco(ht, hf)); // a leitura do bloco corre junto com hash_simple
+    size_t idx = hash_simple(pista, ht->tamanho); // índice do bucket
+    *sondagens = 0;
+    if (ht->filtro) {
+        __builtin_prefetch(&ht->buckets[idx]); // ...e a do bucket junto com o teste do filtro
+        if (!filtro_talvez(ht, hf)) {
+            *sondagens = -1;
+            return NULL;                    // com certeza não está na tabela
+        }
+    }
+    for (HashNode *cur = ht->buckets[idx]; cur != NULL; cur = cur->prox) {
+        ++*sondagens;
+        if (strcmp(cur->chave, pista) == 0) return cur->suspeito; // chave encontrada
+    }
+    return NULL;                            // não encontrada
+}
+
+/*
+ * encontrarSuspeito - busca na hash o suspeito associado a uma pista.
+ * Retorna ponteiro para string (interno da hash) ou NULL se não encontrar.
+ * É a busca do jogo: cada chamada entra no histograma de sondagens.
+ */
+const char *encontrarSuspeito(HashTable *ht, const char *pista) {
+    if (!ht || !pista) return NULL;        // proteção
+    int sondagens;                          // nós da cadeia visitados (instrumentação)
+    const char *s = hash_procurar(ht, pista, &sondagens);
+    EST_HIST(sondagensHash, sondagens < 0 ? 0 : sondagens);
+    if (sondagens < 0) EST_CONTAR(filtroRejeicoes);
+    else if (!s && ht->filtro) EST_CONTAR(filtroFalsos); // o filtro deixou passar uma pista ausente
+    return s;
+}
+
+/* encontrarSuspeitoSemMedir - mesma busca, fora das estatísticas (montagem de índices na carga) */
+const char *encontrarSuspeitoSemMedir(HashTable *ht, const char *pista) {
+    int sondagens;
+    return ht && pista ? hash_procurar(ht, pista, &sondagens) : NULL;
+}
+
+/* liberarHashTable - libera toda a estrutura da tabela hash e strings */
+void liberarHashTable(HashTable *ht) {
+    if (!ht) return;                       // proteção
+    for (size_t i = 0; i < ht->tamanho; ++i) { // para cada bucket...
+        HashNode *cur = ht->buckets[i];
+        while (cur) {                      // liberar lista encadeada
+            HashNode *next = cur->prox;
+            free(cur->chave);              // libera chave
+            free(cur->suspeito);           // libera valor
+            free(cur);                     // libera nó
+            cur = next;
+        }
+    }
+    free(ht->buckets);                     // libera vetor de buckets
+    free(ht->filtro);                      // libera o filtro de Bloom
+    free(ht);                              // libera estrutura da tabela
+}
+
+/* mostrarAssociacoes - imprime todas as associações pista -> suspeito */
+void mostrarAssociacoes(HashTable *ht) {  // exibe todas as associações presentes na hash
+    if (!ht) {                            // se tabela inexistente, informa
+        printf("(Tabela de associações vazia)\n");
+        return;
+    }
+    printf("\n--- Associações conhecidas (pista -> suspeito) ---\n");
+    for (size_t i = 0; i < ht->tamanho; ++i) { // percorre todos os buckets
+        for (HashNode *cur = ht->buckets[i]; cur != NULL; cur = cur->prox) {
+            printf(" - \"%s\"  =>  %s\n", cur->chave, cur->suspeito); // imprime cada par
+        }
+    }
+    printf("---------------------------------------------------\n\n");
+}
+
+/* ---------- Mapa em árvore (MAPA_ARVORE) ---------- */
+
+/*
+ * arv_proxima - sucessor de 's' em pré-ordem dentro da subárvore de 'raiz',
+ * seguindo os ponteiros 'pai' (sem pilha: mapas degenerados não estouram
+ * a pilha de chamadas); NULL no fim.
+ */
+static const Sala *arv_proxima(const Sala *s, const Sala *raiz) {
+    if (s->esq) return s->esq;
+    if (s->dir) return s->dir;
+    while (s != raiz) {                // sobe até um ancestral com subárvore direita não visitada
+        const Sala *p = s->pai;
+        if (s == p->esq && p->dir) return p->dir;
+        s = p;
+    }
+    return NULL;
+}
+
+/* arv_filho - cópia de 'f' pendurada em 'c' (à direita se 'direita') */
+static Sala *arv_filho(Sala *c, const Sala *f, int direita) {
+    Sala *n = criarSala(salaNome(f), salaPista(f));
+    n->pistaId = f->pistaId;
+    n->id = f->id;
+    if (direita) c->dir = n;
+    else c->esq = n;
+    n->pai = c;
+    return n;
+}
+
+/* arv_criar - cópia profunda do modelo, percorrida em pré-ordem junto com a cópia */
+static void *arv_criar(const Sala *modelo) {
+    if (!modelo) return NULL;
+    Sala *raiz = criarSala(salaNome(modelo), salaPista(modelo)), *c = raiz;
+    raiz->pistaId = modelo->pistaId;
+    raiz->id = modelo->id;
+    const Sala *s = modelo;
+    while (1) {
+        if (s->esq) { c = arv_filho(c, s->esq, 0); s = s->esq; continue; }
+        if (s->dir) { c = arv_filho(c, s->dir, 1); s = s->dir; continue; }
+        while (s != modelo && !(s == s->pai->esq && s->pai->dir)) { s = s->pai; c = c->pai; }
+        if (s == modelo) return raiz;
+        s = s->pai;
+        c = arv_filho(c->pai, s->dir, 1);
+        s = s->dir;
+    }
+}
+
+/* arv_liberar - como liberarSalas, mas sem recursão: desfaz a árvore com rotações */
+static void arv_liberar(void *mapa) {
+    Sala *s = mapa;
+    while (s) {
+        if (s->esq) {                  // gira à direita até o nó não ter filho esquerdo
+            Sala *l = s->esq;
+            s->esq = l->dir;
+            l->dir = s;
+            s = l;
+        } else {
+            Sala *d = s->dir;
+            strc_liberar(&s->nome);
+            strc_liberar(&s->pista);
+            free(s);
+            s = d;
+        }
+    }
+}
+
+/* arv_bytes - nós mais os textos que não couberam na StrCurta */
+static size_t arv_bytes(const void *mapa) {
+    size_t total = 0;
+    for (const Sala *s = mapa; s; s = arv_proxima(s, mapa)) {
+        total += sizeof(Sala);
+        if (s->nome.interno[STRC_INTERNO] == STRC_HEAP) total += strlen(s->nome.heap) + 1;
+        if (s->pista.interno[STRC_INTERNO] == STRC_HEAP) total += strlen(s->pista.heap) + 1;
+    }
+    return total;
+}
+
+static const void *arv_raiz(const void *mapa) { return mapa; }
+static const void *arv_esq(const void *mapa, const void *s) { (void)mapa; return ((const Sala *)s)->esq; }
+static const void *arv_dir(const void *mapa, const void *s) { (void)mapa; return ((const Sala *)s)->dir; }
+static const void *arv_pai(const void *mapa, const void *s) { (void)mapa; return ((const Sala *)s)->pai; }
+static const char *arv_nome(const void *mapa, const void *s) { (void)mapa; return salaNome(s); }
+static const char *arv_pista(const void *mapa, const void *s) { (void)mapa; return salaPista(s); }
+
+const MapaOps MAPA_ARVORE = {
+    "arvore", arv_criar, arv_liberar, arv_bytes, arv_raiz, arv_esq, arv_dir, arv_pai, arv_nome, arv_pista
+};
+
+/* ---------- Mapa plano (MAPA_PLANO) ---------- */
+
+/*
+ * As salas ficam num único vetor em pré-ordem, com os vizinhos como índices
+ * de 32 bits, e todos os textos num único bloco ('nome' e 'pista' são
+ * deslocamentos nele). Descer para a esquerda é ir para a posição seguinte
+ * do vetor, e o mapa inteiro são três alocações.
+ */
+#define PLANO_NENHUMA UINT32_MAX       // índice/deslocamento ausente
+
+typedef struct SalaPlana {
+    uint32_t esq, dir, pai;            // índices no vetor (PLANO_NENHUMA se não houver)
+    uint32_t nome, pista;              // deslocamentos em 'textos' (pista: PLANO_NENHUMA se não houver)
+} SalaPlana;
+
+typedef struct MapaPlano {
+    SalaPlana *salas;                  // salas em pré-ordem (a raiz é salas[0])
+    size_t n;
+    char *textos;                      // nomes e pistas terminados em '\0'
+    size_t tamTextos;
+} MapaPlano;
+
+/* plano_texto - copia 't' para o bloco de textos e devolve seu deslocamento */
+static uint32_t plano_texto(MapaPlano *m, const char *t) {
+    size_t n = strlen(t) + 1;
+    uint32_t pos = (uint32_t)m->tamTextos;
+    memcpy(m->textos + pos, t, n);
+    m->tamTextos += n;
+    return pos;
+}
+
+/* plano_adicionar - acrescenta a sala 's' como filho de 'pai' (à direita se 'direita') */
+static uint32_t plano_adicionar(MapaPlano *m, const Sala *s, uint32_t pai, int direita) {
+    uint32_t i = (uint32_t)m->n++;
+    SalaPlana *p = &m->salas[i];
+    p->esq = p->dir = PLANO_NENHUMA;
+    p->pai = pai;
+    p->nome = plano_texto(m, salaNome(s));
+    p->pista = salaPista(s) ? plano_texto(m, salaPista(s)) : PLANO_NENHUMA;
+    if (pai != PLANO_NENHUMA) {
+        if (direita) m->salas[pai].dir = i;
+        else m->salas[pai].esq = i;
+    }
+    return i;
+}
+
+/* plano_criar - conta salas e textos, aloca tudo de uma vez e copia em pré-ordem */
+static void *plano_criar(const Sala *modelo) {
+    size_t n = 0, bytes = 0;
+    for (const Sala *s = modelo; s; s = arv_proxima(s, modelo)) {
+        n++;
+        bytes += strlen(salaNome(s)) + 1 + (salaPista(s) ? strlen(salaPista(s)) + 1 : 0);
+    }
+    if (n >= PLANO_NENHUMA || bytes >= PLANO_NENHUMA) {
+        fprintf(stderr, "Erro: mapa grande demais para o mapa plano.\n");
+        exit(EXIT_FAILURE);
+    }
+    MapaPlano *m = malloc(sizeof(MapaPlano));
+    if (m) {
+        m->salas = malloc((n ? n : 1) * sizeof(SalaPlana));
+        m->textos = malloc(bytes ? bytes : 1);
+    }
+    if (!m || !m->salas || !m->textos) {
+        fprintf(stderr, "Erro: memória insuficiente ao criar mapa plano.\n");
+        exit(EXIT_FAILURE);
+    }
+    m->n = 0;
+    m->tamTextos = 0;
+    if (!modelo) return m;
+    const Sala *s = modelo;
+    uint32_t c = plano_adicionar(m, modelo, PLANO_NENHUMA, 0);
+    while (1) {                        // mesmo percurso de arv_criar, com 'c' no lugar da cópia
+        if (s->esq) { c = plano_adicionar(m, s->esq, c, 0); s = s->esq; continue; }
+        if (s->dir) { c = plano_adicionar(m, s->dir, c, 1); s = s->dir; continue; }
+        while (s != modelo && !(s == s->pai->esq && s->pai->dir)) { s = s->pai; c = m->salas[c].pai; }
+        if (s == modelo) return m;
+        s = s->pai;
+        c = plano_adicionar(m, s->dir, m->salas[c].pai, 1);
+        s = s->dir;
+    }
+}
+
+static void plano_liberar(void *mapa) {
+    MapaPlano *m = mapa;
+    if (!m) return;
+    free(m->salas);
+    free(m->textos);
+    free(m);
+}
+
+static size_t plano_bytes(const void *mapa) {
+    const MapaPlano *m = mapa;
+    return sizeof(MapaPlano) + m->n * sizeof(SalaPlana) + m->tamTextos;
+}
+
+/* plano_sala - sala de índice 'i', ou NULL se PLANO_NENHUMA */
+static inline const void *plano_sala(const MapaPlano *m, uint32_t i) {
+    return i == PLANO_NENHUMA ? NULL : &m->salas[i];
+}
+
+static const void *plano_raiz(const void *mapa) { const MapaPlano *m = mapa; return m->n ? m->salas : NULL; }
+static const void *plano_esq(const void *mapa, const void *s) { return plano_sala(mapa, ((const SalaPlana *)s)->esq); }
+static const void *plano_dir(const void *mapa, const void *s) { return plano_sala(mapa, ((const SalaPlana *)s)->dir); }
+static const void *plano_pai(const void *mapa, const void *s) { return plano_sala(mapa, ((const SalaPlana *)s)->pai); }
+static const char *plano_nome(const void *mapa, const void *s) {
+    return ((const MapaPlano *)mapa)->textos + ((const SalaPlana *)s)->nome;
+}
+static const char *plano_pista(const void *mapa, const void *s) {
+    uint32_t p = ((const SalaPlana *)s)->pista;
+    return p == PLANO_NENHUMA ? NULL : ((const MapaPlano *)mapa)->textos + p;
+}
+
+const MapaOps MAPA_PLANO = {
+    "plano", plano_criar, plano_liberar, plano_bytes, plano_raiz, plano_esq, plano_dir, plano_pai, plano_nome, plano_pista
+};
+
+/* ---------- Coleção em BST sem balanceamento (COLECAO_BST) ---------- */
+
+/*
+ * A BST de sempre (nós NoPista do pool), com inserção iterativa. Pistas
+ * coletadas em ordem alfabética viram uma lista: é o pior caso que a AVL
+ * abaixo evita.
+ */
+typedef struct ColecaoBST {
+    NoPista *raiz;
+    size_t n;
+} ColecaoBST;
+
+static void *bst_criar(void) {
+    ColecaoBST *c = calloc(1, sizeof(ColecaoBST));
+    if (!c) {
+        fprintf(stderr, "Erro: memória insuficiente ao criar coleção de pistas.\n");
+        exit(EXIT_FAILURE);
+    }
+    return c;
+}
+
+static int bst_inserir(void *col, const char *texto) {
+    ColecaoBST *c = col;
+    NoPista **p = &c->raiz;
+    int prof = 0;                      // profundidade alcançada (instrumentação)
+    while (*p) {
+        int cmp = strcmp(texto, strc_texto(&(*p)->texto));
+        if (cmp == 0) {                // já existe: não insere duplicata
+            EST_HIST(profundidadeBST, prof);
+            return 0;
+        }
+        p = cmp < 0 ? &(*p)->esq : &(*p)->dir;
+        prof++;
+    }
+    EST_HIST(profundidadeBST, prof);
+    (void)prof;                        // sem instrumentação a variável não é lida
+    *p = criarNoPista(texto);
+    c->n++;
+    return 1;
+}
+
+static int bst_contem(const void *col, const char *texto) {
+    return buscarPista(((const ColecaoBST *)col)->raiz, texto) != NULL;
+}
+
+/* bst_emOrdem - percurso em ordem com pilha própria (a altura pode chegar a n) */
+static void bst_emOrdem(const void *col, void (*visitar)(const char *texto, void *ctx), void *ctx) {
+    size_t cap = 64, n = 0;
+    const NoPista **pilha = malloc(cap * sizeof(*pilha));
+    if (!pilha) {
+        fprintf(stderr, "Erro: memória insuficiente ao percorrer pistas.\n");
+        exit(EXIT_FAILURE);
+    }
+    const NoPista *no = ((const ColecaoBST *)col)->raiz;
+    while (no || n) {
+        for (; no; no = no->esq) {     // desce pela esquerda empilhando
+            if (n == cap) {
+                cap *= 2;
+                const NoPista **maior = realloc(pilha, cap * sizeof(*pilha));
+                if (!maior) {
+                    fprintf(stderr, "Erro: memória insuficiente ao percorrer pistas.\n");
+                    exit(EXIT_FAILURE);
+                }
+                pilha = maior;
+            }
+            pilha[n++] = no;
+        }
+        no = pilha[--n];
+        visitar(strc_texto(&no->texto), ctx);
+        no = no->dir;
+    }
+    free(pilha);
+}
+
+static size_t bst_tamanho(const void *col) { return ((const ColecaoBST *)col)->n; }
+
+/* bst_liberar - devolve nós e textos ao pool, desfazendo a árvore com rotações (sem recursão) */
+static void bst_liberar(void *col) {
+    ColecaoBST *c = col;
+    NoPista *no = c->raiz;
+    while (no) {
+        if (no->esq) {
+            NoPista *l = no->esq;
+            no->esq = l->dir;
+            l->dir = no;
+            no = l;
+        } else {
+            NoPista *d = no->dir;
+            pool_devolverTexto(&no->texto);
+            no->esq = g_pool.nosLivres;
+            g_pool.nosLivres = no;
+            no = d;
+        }
+    }
+    free(c);
+}
+
+const ColecaoOps COLECAO_BST = {
+    "bst", bst_criar, bst_inserir, bst_contem, bst_emOrdem, bst_tamanho, bst_liberar
+};
+
+/* ---------- Coleção em árvore AVL (COLECAO_AVL) ---------- */
+
+/*
+ * Árvore AVL: depois de cada inserção, as alturas das subárvores de um nó
+ * diferem no máximo em 1, então a profundidade fica abaixo de 1,44·log2(n)
+ * em qualquer ordem de coleta. Os nós vêm de blocos da própria coleção e
+ * saem todos juntos em avl_liberar.
+ */
+#define AVL_NOS_POR_BLOCO 256          // nós obtidos de uma vez do malloc
+#define AVL_ALTURA_MAX    64           // acima de 2^44 nós; basta para a pilha do percurso
+
+typedef struct NoAVL {
+    StrCurta texto;
+    struct NoAVL *esq, *dir;
+    int altura;                        // folha = 1
+} NoAVL;
+
+typedef struct BlocoAVL {
+    struct BlocoAVL *prox;
+    size_t usados;
+    NoAVL nos[AVL_NOS_POR_BLOCO];
+} BlocoAVL;
+
+typedef struct ColecaoAVL {
+    NoAVL *raiz;
+    size_t n;
+    BlocoAVL *blocos;                  // o primeiro é o que está sendo preenchido
+} ColecaoAVL;
+
+static void *avl_criar(void) {
+    ColecaoAVL *c = calloc(1, sizeof(ColecaoAVL));
+    if (!c) {
+        fprintf(stderr, "Erro: memória insuficiente ao criar coleção de pistas.\n");
+        exit(EXIT_FAILURE);
+    }
+    return c;
+}
+
+static NoAVL *avl_novo(ColecaoAVL *c, const char *texto) {
+    if (!c->blocos || c->blocos->usados == AVL_NOS_POR_BLOCO) {
+        BlocoAVL *b = malloc(sizeof(BlocoAVL));
+        if (!b) {
+            fprintf(stderr, "Erro: memória insuficiente ao criar nó de pista.\n");
+            exit(EXIT_FAILURE);
+        }
+        b->prox = c->blocos;
+        b->usados = 0;
+        c->blocos = b;
+    }
+    NoAVL *n = &c->blocos->nos[c->blocos->usados++];
+    strc_definir(&n->texto, texto);
+    n->esq = n->dir = NULL;
+    n->altura = 1;
+    return n;
+}
+
+static inline int avl_altura(const NoAVL *n) { return n ? n->altura : 0; }
+
+static inline void avl_atualizar(NoAVL *n) {
+    int a = avl_altura(n->esq), b = avl_altura(n->dir);
+    n->altura = (a > b ? a : b) + 1;
+}
+
+static NoAVL *avl_girarDir(NoAVL *n) {
+    NoAVL *l = n->esq;
+    n->esq = l->dir;
+    l->dir = n;
+    avl_atualizar(n);
+    avl_atualizar(l);
+    return l;
+}
+
+static NoAVL *avl_girarEsq(NoAVL *n) {
+    NoAVL *r = n->dir;
+    n->dir = r->esq;
+    r->esq = n;
+    avl_atualizar(n);
+    avl_atualizar(r);
+    return r;
+}
+
+/* avl_balancear - restaura a regra da AVL em 'n' (rotação simples ou dupla) */
+static NoAVL *avl_balancear(NoAVL *n) {
+    avl_atualizar(n);
+    int fator = avl_altura(n->esq) - avl_altura(n->dir);
+    if (fator > 1) {
+        if (avl_altura(n->esq->esq) < avl_altura(n->esq->dir)) n->esq = avl_girarEsq(n->esq);
+        return avl_girarDir(n);
+    }
+    if (fator < -1) {
+        if (avl_altura(n->dir->dir) < avl_altura(n->dir->esq)) n->dir = avl_girarDir(n->dir);
+        return avl_girarEsq(n);
+    }
+    return n;
+}
+
+/* avl_ins - insere 'texto' na subárvore 'n'; '*novo' vira 1 se o texto não estava lá */
+static NoAVL *avl_ins(ColecaoAVL *c, NoAVL *n, const char *texto, int *novo, int prof) {
+    if (!n) {
+        EST_HIST(profundidadeBST, prof);
+        *novo = 1;
+        return avl_novo(c, texto);
+    }
+    int cmp = strcmp(texto, strc_texto(&n->texto));
+    if (cmp == 0) {
+        EST_HIST(profundidadeBST, prof);
+        return n;
+    }
+    if (cmp < 0) n->esq = avl_ins(c, n->esq, texto, novo, prof + 1);
+    else n->dir = avl_ins(c, n->dir, texto, novo, prof + 1);
+    return *novo ? avl_balancear(n) : n; // duplicata: nada mudou no caminho
+}
+
+static int avl_inserir(void *col, const char *texto) {
+    ColecaoAVL *c = col;
+    int novo = 0;
+    c->raiz = avl_ins(c, c->raiz, texto, &novo, 0);
+    c->n += (size_t)novo;
+    return novo;
+}
+
+static int avl_contem(const void *col, const char *texto) {
+    for (const NoAVL *n = ((const ColecaoAVL *)col)->raiz; n; ) {
+        int cmp = strcmp(texto, strc_texto(&n->texto));
+        if (cmp == 0) return 1;
+        n = cmp < 0 ? n->esq : n->dir;
+    }
+    return 0;
+}
+
+static void avl_emOrdem(const void *col, void (*visitar)(const char *texto, void *ctx), void *ctx) {
+    const NoAVL *pilha[AVL_ALTURA_MAX];
+    size_t n = 0;
+    const NoAVL *no = ((const ColecaoAVL *)col)->raiz;
+    while (no || n) {
+        for (; no; no = no->esq) pilha[n++] = no;
+        no = pilha[--n];
+        visitar(strc_texto(&no->texto), ctx);
+        no = no->dir;
+    }
+}
+
+static size_t avl_tamanho(const void *col) { return ((const ColecaoAVL *)col)->n; }
+
+static void avl_liberar(void *col) {
+    ColecaoAVL *c = col;
+    for (BlocoAVL *b = c->blocos; b; ) {
+        BlocoAVL *prox = b->prox;
+        for (size_t i = 0; i < b->usados; ++i) strc_liberar(&b->nos[i].texto);
+        free(b);
+        b = prox;
+    }
+    free(c);
+}
+
+const ColecaoOps COLECAO_AVL = {
+    "avl", avl_criar, avl_inserir, avl_contem, avl_emOrdem, avl_tamanho, avl_liberar
+};
+
+/* ---------- Associações encadeadas (ASSOC_ENCADEADA) ---------- */
+
+static void *enc_criar(size_t capacidade) { return criarHashTable(capacidade ? capacidade : 1); }
+static void enc_inserir(void *a, const char *pista, const char *suspeito) { inserirNaHash(a, pista, suspeito); }
+static const char *enc_buscar(void *a, const char *pista) { return encontrarSuspeito(a, pista); }
+static void enc_liberar(void *a) { liberarHashTable(a); }
+
+static size_t enc_bytes(const void *a) {
+    const HashTable *ht = a;
+    size_t total = sizeof(HashTable) + ht->tamanho * sizeof(HashNode *) + ht->nBlocosFiltro * sizeof(BlocoFiltro);
+    for (size_t i = 0; i < ht->tamanho; ++i)
+        for (const HashNode *cur = ht->buckets[i]; cur; cur = cur->prox)
+            total += sizeof(HashNode) + strlen(cur->chave) + 1 + strlen(cur->suspeito) + 1;
+    return total;
+}
+
+const AssociacoesOps ASSOC_ENCADEADA = {
+    "encadeada", enc_criar, enc_inserir, enc_buscar, enc_bytes, enc_liberar
+};
+
+/* ---------- Associações com endereçamento aberto (ASSOC_ABERTA) ---------- */
+
+/*
+ * Um único vetor de entradas com sondagem linear. Cada entrada guarda o
+ * hash de 64 bits da chave (hash_filtro), então a sondagem só chama strcmp
+ * quando os hashes batem. O vetor dobra quando passaria de metade cheio;
+ * com carga até 1/2 uma busca sem sucesso examina em média 2,5 entradas,
+ * todas vizinhas na memória.
+ */
+typedef struct EntradaAberta {
+    uint64_t hash;                     // hash_filtro da chave
+    char *chave;                       // NULL = posição livre
+    char *suspeito;
+} EntradaAberta;
+
+typedef struct AssocAberta {
+    EntradaAberta *v;
+    size_t cap;                        // potência de 2
+    size_t n;
+} AssocAberta;
+
+/* aberta_vetor - vetor de 'cap' entradas livres */
+static EntradaAberta *aberta_vetor(size_t cap) {
+    EntradaAberta *v = calloc(cap, sizeof(EntradaAberta));
+    if (!v) {
+        fprintf(stderr, "Erro: memória insuficiente ao criar tabela de associações.\n");
+        exit(EXIT_FAILURE);
+    }
+    return v;
+}
+
+static void *aberta_criar(size_t capacidade) {
+    AssocAberta *a = malloc(sizeof(AssocAberta));
+    if (!a) {
+        fprintf(stderr, "Erro: memória insuficiente ao criar tabela de associações.\n");
+        exit(EXIT_FAILURE);
+    }
+    a->cap = 8;
+    while (a->cap < 2 * capacidade) a->cap *= 2;
+    a->v = aberta_vetor(a->cap);
+    a->n = 0;
+    return a;
+}
+
+/* aberta_posicao - posição da chave (ou a posição livre onde ela entraria) */
+static size_t aberta_posicao(const AssocAberta *a, uint64_t h, const char *pista) {
+    size_t mascara = a->cap - 1, i = (size_t)h & mascara;
+    while (a->v[i].chave && (a->v[i].hash != h || strcmp(a->v[i].chave, pista) != 0)) i = (i + 1) & mascara;
+    return i;
+}
+
+/* aberta_crescer - dobra o vetor e reposiciona as entradas (chaves e valores não são copiados) */
+static void aberta_crescer(AssocAberta *a) {
+    EntradaAberta *velho = a->v;
+    size_t capVelha = a->cap;
+    a->cap *= 2;
+    a->v = aberta_vetor(a->cap);
+    for (size_t j = 0; j < capVelha; ++j) {
+        if (!velho[j].chave) continue;
+        size_t i = (size_t)velho[j].hash & (a->cap - 1);
+        while (a->v[i].chave) i = (i + 1) & (a->cap - 1);
+        a->v[i] = velho[j];
+    }
+    free(velho);
+}
+
+static void aberta_inserir(void *assoc, const char *pista, const char *suspeito) {
+    AssocAberta *a = assoc;
+    if (!pista || !suspeito) return;
+    if (2 * (a->n + 1) > a->cap) aberta_crescer(a);
+    uint64_t h = hash_filtro(pista, strlen(pista));
+    EntradaAberta *e = &a->v[aberta_posicao(a, h, pista)];
+    if (e->chave) {                    // chave já presente: troca o suspeito
+        free(e->suspeito);
+        e->suspeito = str_dup(suspeito);
+        return;
+    }
+    e->hash = h;
+    e->chave = str_dup(pista);
+    e->suspeito = str_dup(suspeito);
+    a->n++;
+}
+
+static const char *aberta_buscar(void *assoc, const char *pista) {
+    const AssocAberta *a = assoc;
+    if (!pista) return NULL;
+    return a->v[aberta_posicao(a, hash_filtro(pista, strlen(pista)), pista)].suspeito; // posição livre: NULL
+}
+
+static size_t aberta_bytes(const void *assoc) {
+    const AssocAberta *a = assoc;
+    size_t total = sizeof(AssocAberta) + a->cap * sizeof(EntradaAberta);
+    for (size_t i = 0; i < a->cap; ++i)
+        if (a->v[i].chave) total += strlen(a->v[i].chave) + 1 + strlen(a->v[i].suspeito) + 1;
+    return total;
+}
+
+static void aberta_liberar(void *assoc) {
+    AssocAberta *a = assoc;
+    if (!a) return;
+    for (size_t i = 0; i < a->cap; ++i) {
+        free(a->v[i].chave);
+        free(a->v[i].suspeito);
+    }
+    free(a->v);
+    free(a);
+}
+
+const AssociacoesOps ASSOC_ABERTA = {
+    "aberta", aberta_criar, aberta_inserir, aberta_buscar, aberta_bytes, aberta_liberar
+};
+
+/* ---------- Sessão de exploração do motor ---------- */
+
+/*
+ * motorPasso/motorComando aplicam um comando e devolvem os eventos, e quem
+ * os mostra é o front-end. O mapa, a coleção e as associações são usados só
+ * pelas tabelas de operações, então a mesma sessão roda sobre qualquer
+ * combinação de back-ends; o Mestre acrescenta o 't', o catálogo e a
+ * acusação pelos ganchos do Motor, sem um laço próprio.
+ */
+
+/* mot_entrar - põe o jogador em 'sala' e coleta a pista dela; devolve os eventos gerados */
+static size_t mot_entrar(SessaoMotor *s, const void *sala, uint8_t tipo, char cmd, EventoMotor *ev) {
+    const Motor *m = s->motor;
+    size_t n = 0;
+    s->atual = sala;
+    ev[n++] = (EventoMotor){ .tipo = tipo, .cmd = cmd, .sala = sala };
+    const char *pista = m->colecaoOps || m->aoColetar ? m->mapaOps->pistaSala(m->mapa, sala) : NULL;
+    if (pista) {
+        if (m->colecaoOps) m->colecaoOps->inserir(s->pistas, pista);
+        ev[n] = (EventoMotor){ .tipo = MOTOR_PISTA, .cmd = cmd, .sala = sala,
+                               .suspeito = m->assocOps ? m->assocOps->buscar(m->assoc, pista) : NULL };
+        if (m->aoColetar) m->aoColetar(s, &ev[n]);
+        n++;
+    }
+    return n;
+}
+
+/* motorEntrar - leva o jogador direto para 'sala' (comandos de extensão) e coleta a pista dela */
+size_t motorEntrar(SessaoMotor *s, const void *sala, char cmd, EventoMotor ev[MOTOR_MAX_EVENTOS]) {
+    return mot_entrar(s, sala, MOTOR_MOVEU, cmd, ev);
+}
+
+/*
+ * motorIniciar - prepara 's' na raiz do mapa de 'm' (com uma coleção de
+ * pistas vazia, se o motor coleta pistas) e devolve os eventos da chegada.
+ * Com o mapa vazio não há eventos e a sessão já nasce encerrada.
+ */
+size_t motorIniciar(SessaoMotor *s, const Motor *m, EventoMotor ev[MOTOR_MAX_EVENTOS]) {
+    s->motor = m;
+    s->pistas = m->colecaoOps ? m->colecaoOps->criar() : NULL;
+    s->atual = m->mapaOps->raiz(m->mapa);
+    s->encerrada = s->atual == NULL;
+    return s->atual ? mot_entrar(s, s->atual, MOTOR_INICIO, 0, ev) : 0;
+}
+
+/*
+ * motorComando - aplica uma entrada: o primeiro caractere é o comando
+ * (e/d/v/s, maiúsculo ou minúsculo); os demais vão para 'comandoExtra', se o
+ * motor tiver um. Devolve quantos eventos gerou.
+ */
+size_t motorComando(SessaoMotor *s, const char *entrada, EventoMotor ev[MOTOR_MAX_EVENTOS]) {
+    if (s->encerrada) return 0;
+    const Motor *m = s->motor;
+    const void *destino = NULL;
+    char cmd = (char)tolower((unsigned char)entrada[0]);
+    size_t n;
+    switch (cmd) {
+    case 'e': destino = m->mapaOps->esq(m->mapa, s->atual); break;
+    case 'd': destino = m->mapaOps->dir(m->mapa, s->atual); break;
+    case 'v':                          // voltar não coleta: a pista já foi vista ao descer
+        destino = m->mapaOps->pai(m->mapa, s->atual);
+        if (!destino) break;
+        s->atual = destino;
+        ev[0] = (EventoMotor){ .tipo = MOTOR_MOVEU, .cmd = cmd, .sala = destino };
+        return 1;
+    case 's':
+        s->encerrada = 1;
+        ev[0] = (EventoMotor){ .tipo = MOTOR_FIM, .cmd = cmd };
+        return 1;
+    default:
+        if (m->comandoExtra && (n = m->comandoExtra(s, entrada, ev)) > 0) return n;
+        ev[0] = (EventoMotor){ .tipo = MOTOR_INVALIDO, .cmd = cmd };
+        return 1;
+    }
+    if (!destino) {
+        ev[0] = (EventoMotor){ .tipo = MOTOR_SEM_PASSAGEM, .cmd = cmd };
+        return 1;
+    }
+    return mot_entrar(s, destino, MOTOR_MOVEU, cmd, ev);
+}
+
+/* motorPasso - aplica o comando de um caractere 'cmd' (ver motorComando) */
+size_t motorPasso(SessaoMotor *s, char cmd, EventoMotor ev[MOTOR_MAX_EVENTOS]) {
+    const char entrada[2] = { cmd, '\0' };
+    return motorComando(s, entrada, ev);
+}
+
+/* motorEncerrar - libera a coleção de pistas da sessão */
+void motorEncerrar(SessaoMotor *s) {
+    if (s->pistas) s->motor->colecaoOps->liberar(s->pistas);
+    s->pistas = NULL;
+}
+
+/* mot_imprimirPista - visitante de motorExibirPistas */
+static void mot_imprimirPista(const char *texto, void *ctx) {
+    (void)ctx;
+    printf(" - %s\n", texto);
+}
+
+/* motorExibirPistas - imprime as pistas coletadas em ordem alfabética */
+void motorExibirPistas(const SessaoMotor *s) {
+    const ColecaoOps *c = s->motor->colecaoOps;
+    if (!s->pistas || c->tamanho(s->pistas) == 0) {
+        printf(" (nenhuma pista encontrada nesta exploração)\n");
+        return;
+    }
+    c->emOrdem(s->pistas, mot_imprimirPista, NULL);
+}
+
+/* mot_mostrarEvento - front-end interativo de um evento da sessão do motor */
+static void mot_mostrarEvento(const SessaoMotor *s, const TextosExploracao *t, const EventoMotor *e) {
+    const Motor *m = s->motor;
+    if (t->mostrarEvento && t->mostrarEvento(s, e)) return; // o front-end já mostrou
+    switch (e->tipo) {
+    case MOTOR_INICIO:
+        printf("Você começa no Hall de entrada: \"%s\"\n\n", m->mapaOps->nomeSala(m->mapa, e->sala));
+        break;
+    case MOTOR_MOVEU:
+        printf(e->cmd == 'e' ? "\n-- Indo para a esquerda... --\n\n"
+               : e->cmd == 'd' ? "\n-- Indo para a direita... --\n\n"
+               : "\n-- Voltando para a sala anterior... --\n\n");
+        break;
+    case MOTOR_PISTA:
+        if (!m->assocOps) {            // sem associações: só a pista
+            printf("[Pista encontrada] %s\n\n", m->mapaOps->pistaSala(m->mapa, e->sala));
+            break;
+        }
+        printf("[Pista encontrada] %s\n", m->mapaOps->pistaSala(m->mapa, e->sala));
+        if (e->suspeito) printf("  -> Esta pista aponta para: %s\n\n", e->suspeito);
+        else printf("  -> Nenhum suspeito associado a esta pista (desconhecido)\n\n");
+        break;
+    case MOTOR_SEM_PASSAGEM:
+        printf(e->cmd == 'e' ? "Não há sala à esquerda. Tente outra opção.\n\n"
+               : e->cmd == 'd' ? "Não há sala à direita. Tente outra opção.\n\n"
+               : "Você está na raiz (Hall de entrada). Não é possível voltar.\n\n");
+        break;
+    case MOTOR_INVALIDO:
+        printf("Opção inválida. Use 'e', 'd', 'v' ou 's'.\n\n");
+        break;
+    case MOTOR_FIM:
+        printf("%s\n\n", t->encerrando);
+        break;
+    }
+}
+
+/*
+ * explorarMotor - exploração interativa sobre o motor 'm': lê comandos de
+ * stdin (get_choice), mostra os eventos e, no fim, as salas visitadas.
+ * 's' fica pronta para o front-end consultar as pistas (motorExibirPistas)
+ * e deve ser liberada com motorEncerrar. Uma linha com vários comandos
+ * ("eedv") é executada inteira antes de redesenhar a sala. Os três níveis
+ * usam este laço; o que muda entre eles vem em 't' (textos e ganchos de tela)
+ * e nos ganchos de 'm'.
+ */
+void explorarMotor(SessaoMotor *s, const Motor *m, const TextosExploracao *t) {
+    EventoMotor ev[MOTOR_MAX_EVENTOS];
+    size_t nEv = motorIniciar(s, m, ev);
+    if (s->encerrada) {                // se o mapa for vazio, informa e retorna
+        printf("Mapa vazio. Nada a explorar.\n");
+        return;
+    }
+
+    const int MAX_VISITAS = 1024;     // limite para histórico de visitas (prevenção de overflow)
+    const char *visitadas[MAX_VISITAS]; // array de ponteiros para nomes das salas visitadas
+    int cont = 0;                     // contador de visitas registradas
+    const MapaOps *o = m->mapaOps;
+
+    printf("\n--- %s ---\n", t->titulo); // cabeçalho
+    for (size_t i = 0; i < nEv; ++i) mot_mostrarEvento(s, t, &ev[i]);
+
+    while (1) {                       // loop principal da exploração (até 's' ser escolhido)
+        const void *atual = s->atual;
+        if (cont < MAX_VISITAS) visitadas[cont++] = o->nomeSala(m->mapa, atual); // registra visita atual
+
+        if (!entradaTemComandos()) {  // sala e opções só com a fila de comandos vazia
+            const void *esq = o->esq(m->mapa, atual), *dir = o->dir(m->mapa, atual), *pai = o->pai(m->mapa, atual);
+            printf("Você está na sala: %s\n", o->nomeSala(m->mapa, atual)); // informa a sala atual
+            printf("Opções:\n");
+            if (esq) printf("  (e) Ir para a esquerda -> %s\n", o->nomeSala(m->mapa, esq));
+            if (dir) printf("  (d) Ir para a direita -> %s\n", o->nomeSala(m->mapa, dir));
+            if (pai) printf("  (v) Voltar para a sala anterior -> %s\n", o->nomeSala(m->mapa, pai));
+            else printf("  (v) Voltar (não disponível - você está no Hall de entrada)\n");
+            if (t->opcoesExtras) printf("%s", t->opcoesExtras);
+            printf("  (s) %s\n", t->opcaoSair);
+            printf("%s", t->escolha ? t->escolha : "Escolha (e/d/v/s): ");
+        }
+
+        char c = get_choice();        // próximo comando (da fila ou de uma nova linha)
+        if (c == '\0') {              // se leitura falhar ou só espaços
+            printf("\nEntrada finalizada. Retornando ao menu principal.\n");
+            break;
+        }
+        char entrada[MOTOR_MAX_ENTRADA] = { c, '\0' };
+        if (t->completarComando && !strchr("eEdDvVsS", c)) // argumentos de um comando do front-end
+            t->completarComando(s, entrada, sizeof(entrada));
+        EST_INICIO(t0);               // instrumentação: início do processamento do movimento
+        nEv = motorComando(s, entrada, ev);
+        for (size_t i = 0; i < nEv; ++i) mot_mostrarEvento(s, t, &ev[i]);
+        if (s->encerrada) {           // 's': encerrar exploração
+            entradaDescartarComandos(); // comandos após o 's' não valem para o menu
+            break;
+        }
+        EST_FIM(latenciaMovNs, t0);   // instrumentação: fim do processamento do movimento
+    }
+
+    // exibir percurso
+    printf("\n--- Salas visitadas nesta exploração ---\n");
+    for (int i = 0; i < cont; ++i) {     // percorre histórico de visitas
+        printf("%d) %s\n", i + 1, visitadas[i]); // imprime cada sala visitada
+    }
+    printf("----------------------------------------\n\n");
+}
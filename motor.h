@@ -0,0 +1,403 @@
+// TEMA 4 - MOTOR (base comum de Novato, Aventureiro e Mestre)
+
+/*
+ * O motor reúne o que os três níveis do jogo repetiam cada um à sua maneira:
+ * o mapa de salas, o conjunto de pistas coletadas, a tabela pista -> suspeito
+ * e a sessão de exploração. Cada uma dessas peças tem uma interface (tabela
+ * de operações) e mais de uma implementação, e o front-end escolhe qual usar:
+ *
+ *   mapa        MAPA_ARVORE (nós Sala ligados por ponteiros) ou
+ *               MAPA_PLANO  (vetor em pré-ordem com índices de 32 bits)
+ *   pistas      COLECAO_BST (BST sem balanceamento, nós do pool) ou
+ *               COLECAO_AVL (árvore AVL)
+ *   associações ASSOC_ENCADEADA (HashTable com filtro de Bloom) ou
+ *               ASSOC_ABERTA    (endereçamento aberto com sondagem linear)
+ *
+ * Compilação (o motor entra como mais uma unidade de tradução):
+ *   gcc -std=gnu11 -O2 Novato.c motor.c -o novato
+ *   gcc -std=gnu11 -O2 Aventureiro.c motor.c -o aventureiro
+ *   gcc -std=gnu11 -O2 Mestre.c motor.c -o mestre -pthread
+ *   gcc -std=gnu11 -O2 bench_motor.c motor.c -o bench_motor
+ *   gcc -std=gnu11 -O2 bench_mestre.c motor.c -o bench_mestre -pthread
+ * Com -DDQ_ESTATISTICAS, a opção vale para as duas unidades.
+ * Testes de regressão (roteiros com saída esperada e os --testar-* do
+ * bench_mestre): sh testes/rodar.sh
+ */
+
+#ifndef MOTOR_H
+#define MOTOR_H
+
+#include <stdio.h>      // printf — mensagens da exploração.
+#include <stdlib.h>     // size_t, malloc, free.
+#include <string.h>     // memcpy — hash_filtro.
+#include <stdint.h>     // uint32_t, uint64_t — índices do mapa plano e hashes.
+#include <time.h>       // clock_gettime — relógio monotônico para medições de tempo.
+
+/* agora_ns - instante atual do relógio monotônico em nanossegundos */
+static inline unsigned long long agora_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ull + (unsigned long long)ts.tv_nsec;
+}
+
+/* ---------- Instrumentação opcional (compilar com -DDQ_ESTATISTICAS) ---------- */
+
+#ifdef DQ_ESTATISTICAS
+
+#define EST_FAIXAS 24           // número de faixas (potências de 2) de cada histograma
+
+/* Histograma logarítmico: faixa 0 guarda o valor 0, faixa i guarda [2^(i-1), 2^i) */
+typedef struct Histograma {
+    unsigned long long faixas[EST_FAIXAS]; // contagem por faixa
+    unsigned long long amostras;           // total de amostras registradas
+    unsigned long long soma;               // soma dos valores (para a média)
+    unsigned long long maximo;             // maior valor observado
+} Histograma;
+
+/*
+ * Contadores globais do jogo (uma única instância: g_est). Mais de uma
+ * thread conta ao mesmo tempo (o Recarregador monta catálogos enquanto o
+ * laço do servidor joga; a simulação e a montagem do mapa também), então
+ * toda atualização é atômica relaxada: nenhuma ordem entre contadores, só
+ * nenhuma contagem perdida. O relatório lê depois que as threads acabaram.
+ */
+typedef struct Estatisticas {
+    unsigned long long alocStr, bytesStr;         // chamadas e bytes de str_dup
+    unsigned long long alocSala, bytesSala;       // chamadas e bytes de criarSala
+    unsigned long long alocNoPista, bytesNoPista; // chamadas e bytes de criarNoPista
+    unsigned long long alocFiltro, bytesFiltro;   // filtros de Bloom criados e bytes (criarHashTable)
+    unsigned long long filtroRejeicoes;           // buscas que o filtro respondeu sozinho (ausente)
+    unsigned long long filtroFalsos;              // buscas que passaram no filtro mas não acharam a pista
+    Histograma sondagensHash;     // nós da cadeia visitados por encontrarSuspeito (buscas do jogo, não as da carga)
+    Histograma profundidadeBST;   // profundidade alcançada ao inserir na BST ou AVL de pistas
+    Histograma latenciaMovNs;     // nanossegundos gastos por movimento na exploração
+} Estatisticas;
+
+extern Estatisticas g_est;      // contadores zerados na inicialização do programa (motor.c)
+
+void est_registrar(Histograma *h, unsigned long long v);
+
+/* est_somar - soma 'v' ao contador 'c' (atômica relaxada) */
+static inline void est_somar(unsigned long long *c, unsigned long long v) {
+    __atomic_fetch_add(c, v, __ATOMIC_RELAXED);
+}
+
+#define EST_ALOC(tipo, n)   (est_somar(&g_est.aloc##tipo, 1), est_somar(&g_est.bytes##tipo, (n))) // conta uma alocação de n bytes
+#define EST_CONTAR(campo)   est_somar(&g_est.campo, 1) // conta um evento
+#define EST_HIST(campo, v)  est_registrar(&g_est.campo, (unsigned long long)(v)) // registra amostra
+#define EST_INICIO(var)     unsigned long long var = agora_ns() // marca início de um intervalo
+#define EST_FIM(campo, var) EST_HIST(campo, agora_ns() - (var)) // registra duração do intervalo
+#else
+/* sem -DDQ_ESTATISTICAS as macros somem: nenhum custo no binário final */
+#define EST_ALOC(tipo, n)   ((void)0)
+#define EST_CONTAR(campo)   ((void)0)
+#define EST_HIST(campo, v)  ((void)0)
+#define EST_INICIO(var)     ((void)0)
+#define EST_FIM(campo, var) ((void)0)
+#endif
+
+/* ---------- Estruturas ---------- */
+
+/*
+ * StrCurta - string com armazenamento interno para textos curtos (16 bytes).
+ * Textos de até STRC_INTERNO caracteres ficam dentro do próprio nó, sem malloc;
+ * textos maiores vão para o heap e o ponteiro ocupa o início da área.
+ * O último byte diz qual é o caso: '\0' (interno, e também o terminador
+ * de um texto com 15 caracteres), STRC_HEAP ou STRC_NULO.
+ */
+#define STRC_BYTES   16                 // tamanho total da StrCurta
+#define STRC_INTERNO (STRC_BYTES - 1)   // maior texto que cabe dentro do nó
+#define STRC_HEAP    ((char)0x7F)       // marcador: texto está no heap
+#define STRC_NULO    ((char)0x7E)       // marcador: nenhum texto (equivale a NULL)
+
+typedef union StrCurta {
+    char interno[STRC_BYTES];  // texto inline terminado em '\0'
+    char *heap;                // ponteiro para o texto quando não cabe inline
+} StrCurta;
+
+/* Estrutura que representa uma sala (nó da árvore binária) */
+typedef struct Sala {          // início da definição do tipo 'struct Sala'
+    StrCurta nome;            // nome da sala (inline quando curto, ver StrCurta)
+    StrCurta pista;           // pista opcional (STRC_NULO se não houver)
+    int pistaId;              // ID da pista no catálogo (-1 se não houver; ver criarCatalogo)
+    int id;                   // ID da sala no catálogo (ordem de pré-ordem a partir da raiz)
+    struct Sala *esq;         // ponteiro para o filho à esquerda (subárvore esquerda)
+    struct Sala *dir;         // ponteiro para o filho à direita (subárvore direita)
+    struct Sala *pai;         // ponteiro para o nó pai (NULL se for a raiz)
+} Sala;                       // typedef para simplificar o uso do tipo como 'Sala'
+
+/* Nó da árvore BST que guarda as pistas coletadas */
+typedef struct NoPista {      // início da definição do nó da BST de pistas
+    StrCurta texto;           // texto da pista (inline quando curto, ver StrCurta)
+    struct NoPista *esq;      // filho esquerdo (itens "menores" alfabeticamente)
+    struct NoPista *dir;      // filho direito (itens "maiores" alfabeticamente)
+} NoPista;                    // typedef para usar 'NoPista' diretamente
+
+/* Nó para lista encadeada usada na tabela hash (encadeamento separado) */
+typedef struct HashNode {     // nó que guarda par chave/valor na tabela hash
+    char *chave;              // chave = texto da pista (alocado dinamicamente)
+    char *suspeito;           // valor = nome do suspeito associado à pista
+    struct HashNode *prox;    // ponteiro para o próximo nó na lista (encadeamento)
+} HashNode;
+
+/* Bloco do filtro de Bloom da tabela hash: 256 bits, meia linha de cache */
+typedef struct BlocoFiltro {
+    uint32_t palavras[8];     // cada chave liga um bit em cada palavra
+} BlocoFiltro;
+
+/* Estrutura da tabela hash (vetor de ponteiros para HashNode) */
+typedef struct HashTable {    // wrapper da tabela hash
+    HashNode **buckets;       // vetor de buckets (cada bucket é lista encadeada)
+    size_t tamanho;           // número de buckets no vetor
+    BlocoFiltro *filtro;      // filtro de Bloom das chaves (ver hash_filtro); NULL = desligado
+    size_t nBlocosFiltro;     // blocos do filtro
+} HashTable;
+
+/* ---------- Funções utilitárias e entrada em blocos ---------- */
+
+char *str_dup(const char *s);
+char *lerLinha(char *dst, size_t cap);
+char get_choice(void);
+int entradaTemComandos(void);
+void entradaDescartarComandos(void);
+const char *entradaRestoDaLinha(void);
+
+/* strc_texto - devolve o texto guardado (NULL se STRC_NULO) */
+static inline const char *strc_texto(const StrCurta *s) {
+    char m = s->interno[STRC_INTERNO]; // marcador no último byte
+    if (m == STRC_HEAP) return s->heap;
+    if (m == STRC_NULO) return NULL;
+    return s->interno;
+}
+
+/* ---------- Salas (mapa em árvore) ---------- */
+
+/* salaNome / salaPista - acesso aos textos da sala (salaPista devolve NULL se não houver pista) */
+static inline const char *salaNome(const Sala *s)  { return strc_texto(&s->nome); }
+static inline const char *salaPista(const Sala *s) { return strc_texto(&s->pista); }
+
+Sala *criarSala(const char *nome, const char *pista);
+void conectarFilhos(Sala *pai, Sala *esq, Sala *dir);
+char *formatarCaminho(const Sala *s, char *dst, size_t cap);
+void liberarSalas(Sala *raiz);
+
+/*
+ * ArenaSalas - salas (e os textos que não cabem na StrCurta) alocadas em
+ * sequência dentro de blocos grandes. A arena não tem trava: na montagem
+ * paralela cada thread usa a sua. O mapa sai inteiro com liberarArena, um
+ * free por bloco, sem visitar as salas; salas de arena nunca passam por
+ * liberarSalas.
+ */
+typedef struct BlocoArena {
+    struct BlocoArena *prox;
+    size_t usado, cap;                 // bytes ocupados e úteis (os dados vêm logo após o cabeçalho)
+} BlocoArena;
+
+typedef struct ArenaSalas {
+    BlocoArena *blocos;                // o primeiro é o que está sendo preenchido
+    size_t reservado;                  // bytes obtidos do malloc
+} ArenaSalas;
+
+Sala *arenaCriarSala(ArenaSalas *a, const char *nome, const char *pista);
+void liberarArena(ArenaSalas *a);
+
+/* ---------- Pool de nós de pista e BST de pistas ---------- */
+
+#define POOL_CLASSES 4                 // classes de texto do pool: 32 << c bytes
+
+/* Slab - cabeçalho de um bloco grande obtido do malloc (lista para liberar no fim) */
+typedef struct Slab {
+    struct Slab *prox;
+} Slab;
+
+/* PoolPistas - listas livres e contadores do pool (instância única: g_pool) */
+typedef struct PoolPistas {
+    NoPista *nosLivres;                  // nós livres, encadeados pelo campo 'esq'
+    void *textosLivres[POOL_CLASSES];    // blocos livres por classe (próximo no início do bloco)
+    Slab *slabs;                         // todos os slabs obtidos (para liberarPool)
+    unsigned long long pedidosNo, acertosNo;       // obterNo: total e atendidos pela lista livre
+    unsigned long long pedidosTexto, acertosTexto; // textos longos: total e atendidos pela lista livre
+    unsigned long long chamadasMalloc;   // chamadas ao malloc feitas pelo pool
+    size_t bytesReservados;              // memória total obtida do malloc pelo pool
+} PoolPistas;
+
+extern PoolPistas g_pool;              // pool global usado por criarNoPista/liberarPistas
+
+void liberarPool(void);
+void mostrarPool(void);
+NoPista *criarNoPista(const char *texto);
+NoPista *inserirPista(NoPista *raiz, const char *texto);
+NoPista *buscarPista(NoPista *raiz, const char *texto);
+void exibirPistas(NoPista *raiz);
+void liberarPistas(NoPista *raiz);
+
+/* ---------- Tabela hash (pista -> suspeito) ---------- */
+
+/* sais de cada palavra do bloco (os mesmos do filtro em blocos do Parquet) */
+static const uint32_t FILTRO_SAL[8] = {
+    0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du, 0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u
+};
+
+/* hash_filtro - hash de 64 bits de 'n' bytes, lidos de 8 em 8 */
+static inline uint64_t hash_filtro(const char *s, size_t n) {
+    uint64_t h = n * 0x9E3779B97F4A7C15ull, w;
+    for (; n >= 8; s += 8, n -= 8) {
+        memcpy(&w, s, 8);
+        h = (h ^ w) * 0xbf58476d1ce4e5b9ull;
+        h ^= h >> 31;
+    }
+    w = 0;
+    memcpy(&w, s, n);                   // cauda de 0 a 7 bytes
+    h = (h ^ w) * 0x94d049bb133111ebull;
+    h ^= h >> 29;
+    h *= 0xff51afd7ed558ccdull;
+    return h ^ (h >> 32);
+}
+
+/* filtro_bloco - bloco do filtro escolhido pelos 32 bits altos de 'h' */
+static inline BlocoFiltro *filtro_bloco(const HashTable *ht, uint64_t h) {
+    return &ht->filtro[((h >> 32) * ht->nBlocosFiltro) >> 32];
+}
+
+/* filtro_talvez - 0 se a chave de hash 'h' com certeza não está na tabela */
+static inline int filtro_talvez(const HashTable *ht, uint64_t h) {
+    const BlocoFiltro *b = filtro_bloco(ht, h);
+    uint32_t falta = 0;                 // sem desvios: junta os 8 testes
+    for (int i = 0; i < 8; ++i) falta |= ~b->palavras[i] & (1u << (((uint32_t)h * FILTRO_SAL[i]) >> 27));
+    return falta == 0;
+}
+
+HashTable *criarHashTable(size_t tamanho);
+size_t hash_simple(const char *s, size_t mod);
+void inserirNaHash(HashTable *ht, const char *pista, const char *suspeito);
+const char *encontrarSuspeito(HashTable *ht, const char *pista);
+const char *encontrarSuspeitoSemMedir(HashTable *ht, const char *pista);
+void liberarHashTable(HashTable *ht);
+void mostrarAssociacoes(HashTable *ht);
+
+/* ---------- Back-ends intercambiáveis ---------- */
+
+/*
+ * MapaOps - mapa somente leitura. Salas são identificadas por um ponteiro
+ * opaco (NULL = não existe), válido enquanto o mapa existir. 'criar'
+ * constrói o mapa a partir de uma árvore de Sala (que não é alterada).
+ * Uma árvore de Sala já é um mapa MAPA_ARVORE: basta passar a raiz.
+ */
+typedef struct MapaOps {
+    const char *nome;
+    void *(*criar)(const Sala *modelo);
+    void (*liberar)(void *mapa);
+    size_t (*bytes)(const void *mapa);                 // memória ocupada (estruturas e textos)
+    const void *(*raiz)(const void *mapa);
+    const void *(*esq)(const void *mapa, const void *sala);
+    const void *(*dir)(const void *mapa, const void *sala);
+    const void *(*pai)(const void *mapa, const void *sala);
+    const char *(*nomeSala)(const void *mapa, const void *sala);
+    const char *(*pistaSala)(const void *mapa, const void *sala); // NULL se a sala não tem pista
+} MapaOps;
+
+/* ColecaoOps - conjunto ordenado de textos (as pistas coletadas numa exploração) */
+typedef struct ColecaoOps {
+    const char *nome;
+    void *(*criar)(void);
+    int (*inserir)(void *c, const char *texto);        // 1 se o texto é novo, 0 se já estava
+    int (*contem)(const void *c, const char *texto);
+    void (*emOrdem)(const void *c, void (*visitar)(const char *texto, void *ctx), void *ctx);
+    size_t (*tamanho)(const void *c);
+    void (*liberar)(void *c);
+} ColecaoOps;
+
+/* AssociacoesOps - tabela pista -> suspeito (inserir uma pista existente troca o suspeito) */
+typedef struct AssociacoesOps {
+    const char *nome;
+    void *(*criar)(size_t capacidade);                 // 'capacidade' = chaves esperadas
+    void (*inserir)(void *a, const char *pista, const char *suspeito);
+    const char *(*buscar)(void *a, const char *pista); // NULL se a pista não tem suspeito
+    size_t (*bytes)(const void *a);
+    void (*liberar)(void *a);
+} AssociacoesOps;
+
+extern const MapaOps MAPA_ARVORE, MAPA_PLANO;
+extern const ColecaoOps COLECAO_BST, COLECAO_AVL;
+extern const AssociacoesOps ASSOC_ENCADEADA, ASSOC_ABERTA;
+
+/* ---------- Sessão de exploração do motor ---------- */
+
+#define MOTOR_MAX_EVENTOS  2           // eventos que um único comando pode gerar
+#define MOTOR_MAX_ENTRADA  256         // maior entrada (comando e argumentos) lida por explorarMotor
+
+/* tipos de evento */
+enum {
+    MOTOR_INICIO,                      // sessão começou em 'sala'
+    MOTOR_MOVEU,                       // 'cmd' levou o jogador até 'sala'
+    MOTOR_PISTA,                       // pista de 'sala' coletada ('suspeito' = NULL se desconhecido)
+    MOTOR_SEM_PASSAGEM,                // não há sala na direção de 'cmd'
+    MOTOR_INVALIDO,                    // comando desconhecido
+    MOTOR_FIM,                         // 's': exploração encerrada
+    MOTOR_EXTENSAO = 16                // primeiro tipo livre para os eventos dos front-ends
+};
+
+/* EventoMotor - o que um comando produziu (os ponteiros apontam para o mundo) */
+typedef struct EventoMotor {
+    uint8_t tipo;                      // MOTOR_* (ou um tipo do front-end, a partir de MOTOR_EXTENSAO)
+    char cmd;                          // comando que gerou o evento (minúsculo)
+    uint32_t valor;                    // eventos de extensão: número que acompanha o evento
+    const void *sala;                  // MOTOR_INICIO, MOTOR_MOVEU, MOTOR_PISTA
+    const char *suspeito;              // MOTOR_PISTA
+} EventoMotor;
+
+typedef struct SessaoMotor SessaoMotor; // definida abaixo; os ganchos do Motor a recebem
+
+/*
+ * Motor - o mundo de uma partida: mapa e associações (somente leitura) e o
+ * tipo de coleção. Os ganchos são opcionais e deixam um front-end estender
+ * a sessão sem repetir o laço: 'comandoExtra' recebe as entradas cujo
+ * primeiro caractere não é e/d/v/s (devolve 0 se também não as conhece) e
+ * 'aoColetar' é chamado a cada pista coletada, antes de o evento sair. Para
+ * guardar estado próprio, o front-end embute Motor e SessaoMotor como
+ * primeiro membro das suas estruturas e converte o ponteiro de volta.
+ */
+typedef struct Motor {
+    const MapaOps *mapaOps;
+    const void *mapa;
+    const ColecaoOps *colecaoOps;      // NULL = a coleção fica por conta de 'aoColetar' (ou não há coleta)
+    const AssociacoesOps *assocOps;    // NULL = pistas sem suspeitos (nível Aventureiro)
+    void *assoc;
+    size_t (*comandoExtra)(SessaoMotor *s, const char *entrada, EventoMotor *ev);
+    void (*aoColetar)(SessaoMotor *s, const EventoMotor *pista); // com 'aoColetar', as pistas são coletadas mesmo sem coleção
+} Motor;
+
+/* SessaoMotor - estado de uma exploração em andamento */
+struct SessaoMotor {
+    const Motor *motor;
+    const void *atual;                 // sala onde o jogador está
+    void *pistas;                      // coleção de pistas (NULL sem colecaoOps)
+    int encerrada;                     // 1 depois do 's'
+};
+
+/*
+ * TextosExploracao - frases que mudam de um nível do jogo para outro e os
+ * ganchos de tela de explorarMotor (todos opcionais a partir de 'opcoesExtras'):
+ * 'completarComando' recebe a entrada de um comando que não é e/d/v/s e pode
+ * completá-la (ex.: pedir um argumento), e 'mostrarEvento' é chamado antes
+ * do texto padrão de cada evento e devolve 1 se já o mostrou.
+ */
+typedef struct TextosExploracao {
+    const char *titulo;                // cabeçalho impresso ao iniciar
+    const char *opcaoSair;             // descrição da opção (s)
+    const char *encerrando;            // mensagem ao escolher 's'
+    const char *opcoesExtras;          // linhas do menu antes da opção (s)
+    const char *escolha;               // prompt (NULL = "Escolha (e/d/v/s): ")
+    void (*completarComando)(const SessaoMotor *s, char *entrada, size_t cap);
+    int (*mostrarEvento)(const SessaoMotor *s, const EventoMotor *e);
+} TextosExploracao;
+
+size_t motorIniciar(SessaoMotor *s, const Motor *m, EventoMotor ev[MOTOR_MAX_EVENTOS]);
+size_t motorPasso(SessaoMotor *s, char cmd, EventoMotor ev[MOTOR_MAX_EVENTOS]);
+size_t motorComando(SessaoMotor *s, const char *entrada, EventoMotor ev[MOTOR_MAX_EVENTOS]);
+size_t motorEntrar(SessaoMotor *s, const void *sala, char cmd, EventoMotor ev[MOTOR_MAX_EVENTOS]);
+void motorEncerrar(SessaoMotor *s);
+void motorExibirPistas(const SessaoMotor *s);
+void explorarMotor(SessaoMotor *s, const Motor *m, const TextosExploracao *t);
+
+#endif
@@ -0,0 +1,71 @@
+#!/bin/sh
+# Testes de regressão dos três níveis: compila tudo num diretório temporário,
+# roda cada roteiro de entrada e compara a saída padrão com o .esperado; depois
+# roda as verificações embutidas do bench_mestre (--testar-*).
+#
+# Uso, na raiz do repositório:
+#   sh testes/rodar.sh
+# Depois de mudar um texto do jogo de propósito, regrave as saídas esperadas
+# (e confira o diff antes de fazer o commit):
+#   DQ_REGRAVAR=1 sh testes/rodar.sh
+
+set -u
+raiz=$(cd "$(dirname "$0")/.." && pwd)
+t="$raiz/testes"
+bin=$(mktemp -d)
+trap 'rm -rf "$bin"' EXIT
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:--std=gnu11 -O2 -Wall -Wextra}
+falhas=0
+
+# compilar <executável> <fonte>
+compilar() {
+    $CC $CFLAGS "$raiz/$2" "$raiz/motor.c" -o "$bin/$1" -pthread || { echo "FALHOU compilação de $2"; exit 1; }
+}
+
+# caso <descrição> <entrada> <esperado> <comando...>: só a saída padrão é comparada
+caso() {
+    descricao=$1 entrada=$2 esperado=$3
+    shift 3
+    "$@" < "$entrada" > "$bin/saida" 2> /dev/null
+    if [ "${DQ_REGRAVAR:-0}" = 1 ]; then
+        cp "$bin/saida" "$esperado"
+        echo "  gravado $descricao"
+    elif cmp -s "$bin/saida" "$esperado"; then
+        echo "  ok     $descricao"
+    else
+        echo "  FALHOU $descricao"
+        diff "$esperado" "$bin/saida" | head -20
+        falhas=$((falhas + 1))
+    fi
+}
+
+compilar novato Novato.c
+compilar aventureiro Aventureiro.c
+compilar mestre Mestre.c
+compilar bench_mestre bench_mestre.c
+
+echo "Roteiros:"
+for n in 1 2; do
+    caso "novato, roteiro $n" "$t/niveis_$n.entrada" "$t/novato_$n.esperado" "$bin/novato"
+    caso "aventureiro, roteiro $n" "$t/niveis_$n.entrada" "$t/aventureiro_$n.esperado" "$bin/aventureiro"
+done
+caso "mestre, menu" "$t/mestre_menu.entrada" "$t/mestre_menu.esperado" "$bin/mestre"
+if [ "${DQ_REGRAVAR:-0}" != 1 ]; then # as coleções em árvore devem dar exatamente a mesma saída
+    caso "mestre, menu com --colecao bst" "$t/mestre_menu.entrada" "$t/mestre_menu.esperado" "$bin/mestre" --colecao bst
+    caso "mestre, menu com --colecao avl" "$t/mestre_menu.entrada" "$t/mestre_menu.esperado" "$bin/mestre" --colecao avl
+fi
+caso "mestre, teletransporte" "$t/mestre_teletransporte.entrada" "$t/mestre_teletransporte.esperado" "$bin/mestre"
+caso "mestre, homônimos no lote" "$t/homonimos.lote" "$t/homonimos.esperado" "$bin/mestre" --lote bitset "$t/homonimos.mundo"
+
+cd "$bin" || exit 1                   # os --testar-* criam arquivos no diretório atual
+for modo in --testar-diario --testar-grafo --testar-servidor; do
+    echo "bench_mestre $modo:"
+    ./bench_mestre "$modo" || falhas=$((falhas + 1))
+done
+
+if [ "$falhas" -ne 0 ]; then
+    echo "$falhas grupo(s) de testes falharam."
+    exit 1
+fi
+echo "Todos os testes passaram."